@@ -67,6 +67,13 @@ typedef struct {
 
 static agm_client_module_data *mdata = NULL;
 
+struct agm_log_config agm_log_cfg = AGM_LOG_CONFIG_INIT;
+
+void agm_log_config_update(void)
+{
+    agm_log_config_load(&agm_log_cfg);
+}
+
 static GDBusConnection *get_dbus_connection() {
     GError *error = NULL;
     GDBusConnection *conn = NULL;
@@ -1760,6 +1767,7 @@ int agm_session_open(uint32_t session_id, uint64_t *handle) {
     agm_client_session_data *ses_data = NULL;
 
     g_assert(handle != NULL);
+    agm_log_config_update();
     AGM_LOGD("%s\n", __func__);
 
     if (mdata == NULL) {
@@ -1834,6 +1842,7 @@ int agm_init() {
     GError *error = NULL;
     int rc = 0;
 
+    agm_log_config_update();
     AGM_LOGD("%s\n", __func__);
 
     if (mdata == NULL) {
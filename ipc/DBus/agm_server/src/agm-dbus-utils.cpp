@@ -33,6 +33,7 @@
 #include <errno.h>
 #include <malloc.h>
 
+#include <agm/agm_trace.h>
 #include "agm-dbus-utils.h"
 #include "utils.h"
 
@@ -83,6 +84,8 @@ static DBusHandlerResult server_message_handler(DBusConnection *connection,
                 g_hash_table_lookup(interface->methods, dbus_method)) == NULL) {
                 return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
             } else {
+                /*method names come from the static method tables*/
+                AGM_TRACE_SCOPE(method->method_name);
                 method->cb_func(connection, message, interface->userdata);
             }
         }
@@ -9,6 +9,13 @@ ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_HIDL)),true)
 LOCAL_CFLAGS += -DAGM_HIDL_ENABLED
 endif
 
+# set_params and event registration results are reported through
+# IAGMCallback@1.1::error_callback instead of the return value, services
+# that only implement @1.0 keep the synchronous calls
+ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_ONEWAY_CONTROLS)),true)
+LOCAL_CFLAGS += -DAGM_ONEWAY_CONTROLS
+endif
+
 LOCAL_SRC_FILES := \
     src/agm_client_wrapper.cpp\
     src/AGMCallback.cpp
@@ -20,7 +27,8 @@ LOCAL_SHARED_LIBRARIES := \
     libcutils \
     libhardware \
     libbase \
-    vendor.qti.hardware.AGMIPC@1.0
+    vendor.qti.hardware.AGMIPC@1.0 \
+    vendor.qti.hardware.AGMIPC@1.1
 
 LOCAL_HEADER_LIBRARIES := libagm_headers
 
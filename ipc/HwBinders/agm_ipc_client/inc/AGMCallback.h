@@ -29,7 +29,7 @@
 
 #pragma once
 
-#include <vendor/qti/hardware/AGMIPC/1.0/IAGMCallback.h>
+#include <vendor/qti/hardware/AGMIPC/1.1/IAGMCallback.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <agm/agm_api.h>
@@ -146,13 +146,16 @@ using ::android::hardware::Return;
 using ::android::hardware::Void;
 using ::android::sp;
 
-struct AGMCallback : public IAGMCallback {
+struct AGMCallback : public ::vendor::qti::hardware::AGMIPC::V1_1::IAGMCallback {
     Return<int32_t> event_callback(uint32_t session_id,
                                 const hidl_vec<AgmEventCbParams>& event_params,
                                 uint64_t clbk_data) override;
     Return<int32_t> event_callback_rw_done(uint32_t session_id,
                                 const hidl_vec<AgmReadWriteEventCbParams>& event_params,
                                 uint64_t clbk_data) override;
+    Return<void> error_callback(uint32_t session_id,
+                                const hidl_string& method,
+                                int32_t ret) override;
 };
 
 }  // namespace implementation
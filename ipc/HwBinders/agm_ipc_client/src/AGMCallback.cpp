@@ -44,24 +44,32 @@ Return<int32_t> AGMCallback::event_callback(uint32_t session_id,
     ClntClbk *cl_clbk_data;
     cl_clbk_data = (ClntClbk *) clbk_data;
     struct agm_event_cb_params *event_params_l = NULL;
+    uint32_t max_payload_size = 0;
+
+    /*the service may batch several events of a burst in one call*/
+    for (size_t i = 0; i < event_params.size(); i++) {
+        if (event_params[i].event_payload_size > max_payload_size)
+            max_payload_size = event_params[i].event_payload_size;
+    }
     event_params_l = (struct agm_event_cb_params*) calloc(1,
-                     (sizeof(struct agm_event_cb_params) +
-                     event_params.data()->event_payload_size));
+                     (sizeof(struct agm_event_cb_params) + max_payload_size));
     if (!event_params_l) {
         ALOGE("Not enough memory for event_params_l\n");
         return -ENOMEM;
     }
 
-    event_params_l->event_payload_size = event_params.data()->event_payload_size;
-    event_params_l->event_id = event_params.data()->event_id;
-    event_params_l->source_module_id = event_params.data()->source_module_id;
-    int8_t *src = (int8_t *)event_params.data()->event_payload.data();
-    int8_t *dst = (int8_t *)event_params_l->event_payload;
-    memcpy(dst, src, event_params_l->event_payload_size);
-
-    ALOGV("event_params payload_size %d", event_params_l->event_payload_size);
     agm_event_cb clbk_func = cl_clbk_data->get_clbk_func();
-    clbk_func(session_id, event_params_l, cl_clbk_data->get_clnt_data() );
+    for (size_t i = 0; i < event_params.size(); i++) {
+        event_params_l->event_payload_size = event_params[i].event_payload_size;
+        event_params_l->event_id = event_params[i].event_id;
+        event_params_l->source_module_id = event_params[i].source_module_id;
+        int8_t *src = (int8_t *)event_params[i].event_payload.data();
+        int8_t *dst = (int8_t *)event_params_l->event_payload;
+        memcpy(dst, src, event_params_l->event_payload_size);
+
+        ALOGV("event_params payload_size %d", event_params_l->event_payload_size);
+        clbk_func(session_id, event_params_l, cl_clbk_data->get_clnt_data());
+    }
     free(event_params_l);
     return int32_t {};
 }
@@ -128,6 +136,14 @@ Return<int32_t> AGMCallback::event_callback_rw_done(uint32_t session_id,
     return int32_t {};
 }
 
+Return<void> AGMCallback::error_callback(uint32_t session_id,
+                                const hidl_string& method,
+                                int32_t ret) {
+    ALOGE("%s: oneway %s on session %d failed, ret %d\n", __func__,
+          method.c_str(), session_id, ret);
+    return Void();
+}
+
 
 }  // namespace implementation
 }  // namespace V1_0
@@ -62,21 +62,33 @@
  */
 #define LOG_TAG "agm_client_wrapper"
 
+#include <cutils/ashmem.h>
 #include <cutils/list.h>
+#include <sys/mman.h>
 #include <vendor/qti/hardware/AGMIPC/1.0/IAGMCallback.h>
 #include <hidl/LegacySupport.h>
 #include <log/log.h>
 #include <unistd.h>
 #include <vendor/qti/hardware/AGMIPC/1.0/IAGM.h>
+#include <vendor/qti/hardware/AGMIPC/1.1/IAGM.h>
 
 #include <agm/agm_api.h>
+#include <agm/utils.h>
 #include "inc/AGMCallback.h"
+#include <atomic>
 #include <mutex>
 
 using android::hardware::Return;
 using android::hardware::hidl_vec;
+using android::hardware::hidl_handle;
+using android::hardware::hidl_memory;
 using vendor::qti::hardware::AGMIPC::V1_0::IAGM;
 using vendor::qti::hardware::AGMIPC::V1_0::IAGMCallback;
+using IAGM_V1_1 = vendor::qti::hardware::AGMIPC::V1_1::IAGM;
+using vendor::qti::hardware::AGMIPC::V1_1::AgmAsyncOp;
+using vendor::qti::hardware::AGMIPC::V1_1::AgmParamsBatchEntry;
+using vendor::qti::hardware::AGMIPC::V1_1::AgmParamsBatchType;
+using vendor::qti::hardware::AGMIPC::V1_1::AgmSessionLaunchConfig;
 using vendor::qti::hardware::AGMIPC::V1_0::implementation::AGMCallback;
 using vendor::qti::hardware::AGMIPC::V1_0::MmapBufInfo;
 using vendor::qti::hardware::AGMIPC::V1_0::AgmDumpInfo;
@@ -88,6 +100,17 @@ using android::sp;
 static bool agm_server_died = false;
 static pthread_mutex_t agmclient_init_lock = PTHREAD_MUTEX_INITIALIZER;
 static android::sp<IAGM> agm_client = NULL;
+/*
+ *agm_client is never reset once set, so the raw pointer stays valid for
+ *the life of the process and callers can use it without the init lock.
+ */
+static std::atomic<IAGM *> agm_client_cached(nullptr);
+/*
+ *NULL when the service only implements @1.0, set before agm_client_cached
+ *so a cached agm_client implies the cast has been made.
+ */
+static android::sp<IAGM_V1_1> agm_client_1_1 = NULL;
+static std::atomic<IAGM_V1_1 *> agm_client_1_1_cached(nullptr);
 static sp<server_death_notifier> Server_death_notifier = NULL;
 #ifdef AGM_HIDL_ENABLED
 sp<IAGMCallback> ClbkBinder = NULL;
@@ -98,6 +121,15 @@ static list_declare(client_clbk_data_list);
 static pthread_mutex_t clbk_data_list_lock = PTHREAD_MUTEX_INITIALIZER;
 static std::mutex agm_session_register_cb_mutex;
 
+/*
+ *Payloads at or above this size are handed to the service in an ashmem
+ *region instead of a hidl_vec, so they are copied once into shared memory
+ *rather than into the parcel and again out of it on the service side.
+ */
+#ifndef AGM_PARAMS_SHMEM_THRESHOLD
+#define AGM_PARAMS_SHMEM_THRESHOLD (4 * 1024)
+#endif
+
 struct client_cb_data {
    struct listnode node;
    uint64_t data;
@@ -114,7 +146,12 @@ void server_death_notifier::serviceDied(uint64_t cookie,
     // leading to a fresh start on both the sides.
 }
 
-android::sp<IAGM> get_agm_server() {
+static IAGM *get_agm_server() {
+    IAGM *client = agm_client_cached.load(std::memory_order_acquire);
+
+    if (client != nullptr)
+        return client;
+
     pthread_mutex_lock(&agmclient_init_lock);
     if (agm_client == NULL) {
         agm_client = IAGM::getService();
@@ -129,9 +166,24 @@ android::sp<IAGM> get_agm_server() {
             ALOGI("%s : server linked to death \n", __func__);
         }
     }
+    if (agm_client_1_1 == NULL) {
+        agm_client_1_1 = IAGM_V1_1::castFrom(agm_client);
+        if (agm_client_1_1 == nullptr)
+            ALOGI("%s : AGM service does not implement @1.1\n", __func__);
+    }
+    agm_client_1_1_cached.store(agm_client_1_1.get(),
+                                std::memory_order_release);
+    agm_client_cached.store(agm_client.get(), std::memory_order_release);
 done:
     pthread_mutex_unlock(&agmclient_init_lock);
-    return agm_client ;
+    return agm_client.get();
+}
+
+/*returns NULL when the service only implements @1.0*/
+static IAGM_V1_1 *get_agm_server_1_1() {
+    if (get_agm_server() == nullptr)
+        return nullptr;
+    return agm_client_1_1_cached.load(std::memory_order_acquire);
 }
 
 int agm_register_service_crash_callback(agm_service_crash_cb cb, uint64_t cookie)
@@ -162,7 +214,7 @@ int agm_aif_set_media_config(uint32_t audio_intf,
                                 struct agm_media_config *media_config) {
     ALOGV("%s called audio_intf = %d \n", __func__, audio_intf);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmMediaConfig> media_config_hidl(1);
         media_config_hidl.data()->rate = media_config->rate;
         media_config_hidl.data()->channels = media_config->channels;
@@ -180,7 +232,7 @@ int agm_session_set_config(uint64_t handle,
                             struct agm_buffer_config *buffer_config) {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long)handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmSessionConfig> session_config_hidl(1);
         memcpy(session_config_hidl.data(),
                session_config,
@@ -205,8 +257,16 @@ int agm_session_set_config(uint64_t handle,
 }
 
 
+struct agm_log_config agm_log_cfg = AGM_LOG_CONFIG_INIT;
+
+void agm_log_config_update(void)
+{
+    agm_log_config_load(&agm_log_cfg);
+}
+
 int agm_init(){
      /*agm_init in IPC happens in context of the server*/
+      agm_log_config_update();
       return 0;
 }
 
@@ -218,7 +278,7 @@ int agm_deinit(){
 int agm_aif_set_metadata(uint32_t audio_intf, uint32_t size, uint8_t *metadata){
     ALOGV("%s called aif = %d, size =%d \n", __func__, audio_intf, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<uint8_t> metadata_hidl;
         metadata_hidl.resize(size);
         memcpy(metadata_hidl.data(), metadata, size);
@@ -234,7 +294,7 @@ int agm_session_set_metadata(uint32_t session_id,
                              uint8_t *metadata){
     ALOGV("%s called sess_id = %d, size = %d\n", __func__, session_id, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<uint8_t> metadata_hidl;
         metadata_hidl.resize(size);
         memcpy(metadata_hidl.data(), metadata, size);
@@ -251,7 +311,7 @@ int agm_session_aif_set_metadata(uint32_t session_id, uint32_t audio_intf,
     ALOGV("%s called with sess_id = %d, aif = %d, size = %d\n", __func__,
                                                  session_id, audio_intf, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<uint8_t> metadata_hidl;
         metadata_hidl.resize(size);
         memcpy(metadata_hidl.data(), metadata, size);
@@ -267,7 +327,7 @@ int agm_session_aif_set_metadata(uint32_t session_id, uint32_t audio_intf,
 int agm_session_close(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_close(handle);
     }
     return -EINVAL;
@@ -276,7 +336,7 @@ int agm_session_close(uint64_t handle){
 int agm_session_prepare(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_prepare(handle);
     }
     return -EINVAL;
@@ -285,7 +345,7 @@ int agm_session_prepare(uint64_t handle){
 int agm_session_start(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_start(handle);
     }
     return -EINVAL;
@@ -294,7 +354,7 @@ int agm_session_start(uint64_t handle){
 int agm_session_stop(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_stop(handle);
     }
     return -EINVAL;
@@ -303,7 +363,7 @@ int agm_session_stop(uint64_t handle){
 int agm_session_pause(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_pause(handle);
     }
     return -EINVAL;
@@ -312,7 +372,7 @@ int agm_session_pause(uint64_t handle){
 int agm_session_flush(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_flush(handle);
     }
     return -EINVAL;
@@ -322,7 +382,7 @@ int agm_sessionid_flush(uint32_t session_id)
 {
     ALOGV("%s called with session id = %d", __func__, session_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_sessionid_flush(session_id);
     }
     return -EINVAL;
@@ -331,7 +391,7 @@ int agm_sessionid_flush(uint32_t session_id)
 int agm_session_resume(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_resume(handle);
     }
     return -EINVAL;
@@ -340,7 +400,7 @@ int agm_session_resume(uint64_t handle){
 int agm_session_suspend(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_suspend(handle);
     }
     return -EINVAL;
@@ -350,8 +410,9 @@ int agm_session_open(uint32_t session_id, enum agm_session_mode sess_mode ,
                      uint64_t *handle) {
     ALOGD("%s called with handle = %x , *handle = %x\n", __func__, handle, *handle);
     int ret = -EINVAL;
+    agm_log_config_update();
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         AgmSessionMode sess_mode_hidl = (AgmSessionMode) sess_mode;
         auto status = agm_client->ipc_agm_session_open(session_id, sess_mode_hidl,
                               [&](int32_t _ret, hidl_vec<uint64_t> handle_hidl)
@@ -372,7 +433,7 @@ int  agm_session_aif_connect(uint32_t session_id,
     ALOGV("%s called with sess_id = %d, aif = %d, state = %s\n", __func__,
            session_id, audio_intf, state ? "true" : "false" );
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_aif_connect(session_id,
                                                        audio_intf,
                                                        state);
@@ -380,10 +441,319 @@ int  agm_session_aif_connect(uint32_t session_id,
     return -EINVAL;
 }
 
+/*
+ * Services that only implement @1.0 have no launch method, the launch is
+ * then composed from the existing calls at one round trip per step. On
+ * failure the steps are undone in reverse. The previous metadata cannot
+ * be read back, so the session and session-aif metadata set here are
+ * cleared rather than restored, and aif media configs are kept as the
+ * service side launch does.
+ */
+static int agm_session_launch_each(struct agm_session_launch_config *config,
+                                   uint64_t *handle) {
+    /*num_gkvs, num_ckvs, prop_id and num_props all zero*/
+    uint8_t empty_metadata[4 * sizeof(uint32_t)] = {0};
+    struct agm_session_launch_aif *aif = NULL;
+    uint32_t num_meta = 0, connected = 0;
+    uint64_t hndl = 0;
+    bool opened = false;
+    int ret = 0;
+
+    if (config->metadata_size) {
+        ret = agm_session_set_metadata(config->session_id,
+                                       config->metadata_size,
+                                       config->metadata);
+        if (ret)
+            goto unwind;
+    }
+
+    for (connected = 0; connected < config->num_aifs; connected++) {
+        aif = &config->aifs[connected];
+
+        if (aif->set_media_config) {
+            ret = agm_aif_set_media_config(aif->aif_id, &aif->media_config);
+            if (ret)
+                goto unwind;
+        }
+        if (aif->metadata_size) {
+            num_meta = connected + 1;
+            ret = agm_session_aif_set_metadata(config->session_id,
+                                               aif->aif_id,
+                                               aif->metadata_size,
+                                               aif->metadata);
+            if (ret)
+                goto unwind;
+        }
+        ret = agm_session_aif_connect(config->session_id, aif->aif_id, true);
+        if (ret)
+            goto unwind;
+    }
+
+    ret = agm_session_open(config->session_id, config->sess_mode, &hndl);
+    if (ret)
+        goto unwind;
+    opened = true;
+
+    ret = agm_session_set_config(hndl, &config->session_config,
+                                 &config->media_config,
+                                 &config->buffer_config);
+    if (!ret)
+        ret = agm_session_prepare(hndl);
+    if (!ret && config->start)
+        ret = agm_session_start(hndl);
+    if (ret)
+        goto unwind;
+
+    *handle = hndl;
+    return 0;
+
+unwind:
+    if (opened)
+        agm_session_close(hndl);
+    while (connected--)
+        agm_session_aif_connect(config->session_id,
+                                config->aifs[connected].aif_id, false);
+    while (num_meta--) {
+        if (config->aifs[num_meta].metadata_size)
+            agm_session_aif_set_metadata(config->session_id,
+                                         config->aifs[num_meta].aif_id,
+                                         sizeof(empty_metadata),
+                                         empty_metadata);
+    }
+    if (config->metadata_size)
+        agm_session_set_metadata(config->session_id, sizeof(empty_metadata),
+                                 empty_metadata);
+    ALOGE("%s: launch of session %d failed %d\n", __func__,
+          config->session_id, ret);
+    return ret;
+}
+
+static void media_config_to_hidl(AgmMediaConfig *media_config_hidl,
+                                 struct agm_media_config *media_config) {
+    media_config_hidl->rate = media_config->rate;
+    media_config_hidl->channels = media_config->channels;
+    media_config_hidl->format = (::vendor::qti::hardware::AGMIPC::V1_0::AgmMediaFormat) media_config->format;
+    media_config_hidl->data_format = media_config->data_format;
+}
+
+int agm_session_launch(struct agm_session_launch_config *config,
+                       uint64_t *handle) {
+    int ret = -EINVAL;
+    uint32_t i = 0;
+
+    if (!config || !handle || (config->num_aifs && !config->aifs))
+        return -EINVAL;
+
+    ALOGV("%s called with sess_id = %d, num_aifs = %d\n", __func__,
+          config->session_id, config->num_aifs);
+    agm_log_config_update();
+    if (!agm_server_died) {
+        IAGM_V1_1 *agm_client = get_agm_server_1_1();
+
+        if (agm_client == nullptr)
+            return agm_session_launch_each(config, handle);
+
+        AgmSessionLaunchConfig config_hidl;
+        config_hidl.session_id = config->session_id;
+        config_hidl.sess_mode = (AgmSessionMode) config->sess_mode;
+        config_hidl.metadata.setToExternal(config->metadata,
+                              config->metadata ? config->metadata_size : 0);
+        config_hidl.aifs.resize(config->num_aifs);
+        for (i = 0; i < config->num_aifs; i++) {
+            config_hidl.aifs[i].aif_id = config->aifs[i].aif_id;
+            config_hidl.aifs[i].set_media_config =
+                                       config->aifs[i].set_media_config;
+            media_config_to_hidl(&config_hidl.aifs[i].media_config,
+                                 &config->aifs[i].media_config);
+            config_hidl.aifs[i].metadata.setToExternal(
+                              config->aifs[i].metadata,
+                              config->aifs[i].metadata ?
+                              config->aifs[i].metadata_size : 0);
+        }
+        memcpy(&config_hidl.session_config, &config->session_config,
+               sizeof(struct agm_session_config));
+        media_config_to_hidl(&config_hidl.media_config,
+                             &config->media_config);
+        config_hidl.buffer_config.count = config->buffer_config.count;
+        config_hidl.buffer_config.size = config->buffer_config.size;
+        config_hidl.start = config->start;
+
+        auto status = agm_client->ipc_agm_session_launch(config_hidl,
+                              [&](int32_t _ret, uint64_t hndl)
+                              {  ret = _ret;
+                                 if (!ret)
+                                     *handle = hndl;
+                              });
+        if (!status.isOk()) {
+            ALOGE("%s: HIDL call failed. ret=%d\n", __func__, ret);
+        }
+    }
+    return ret;
+}
+
+/*
+ * Services that only implement @1.0 have no batch method, entries are
+ * then sent one call each and are not merged into a single custom config
+ * per graph.
+ */
+static int agm_params_batch_each(struct agm_params_batch_entry *entries,
+                                 uint32_t num_entries) {
+    struct agm_params_batch_entry *entry = NULL;
+    uint32_t i = 0;
+    int ret = 0;
+
+    for (i = 0; i < num_entries; i++) {
+        entry = &entries[i];
+        switch (entry->type) {
+        case AGM_PARAMS_BATCH_SESSION:
+            entry->status = agm_session_set_params(entry->session_id,
+                                                   entry->payload,
+                                                   entry->size);
+            break;
+        case AGM_PARAMS_BATCH_SESSION_AIF:
+            entry->status = agm_session_aif_set_params(entry->session_id,
+                                                       entry->aif_id,
+                                                       entry->payload,
+                                                       entry->size);
+            break;
+        case AGM_PARAMS_BATCH_TAG:
+            entry->status = agm_set_params_with_tag(entry->session_id,
+                                   entry->aif_id,
+                                   (struct agm_tag_config *)entry->payload);
+            break;
+        case AGM_PARAMS_BATCH_SESSION_GET:
+            entry->status = agm_session_get_params(entry->session_id,
+                                                   entry->payload,
+                                                   entry->size);
+            break;
+        default:
+            entry->status = -EINVAL;
+            break;
+        }
+        if (!ret)
+            ret = entry->status;
+    }
+    return ret;
+}
+
+int agm_params_batch(struct agm_params_batch_entry *entries,
+                     uint32_t num_entries) {
+    ALOGV("%s called with num_entries = %d\n", __func__, num_entries);
+    int ret = -EINVAL;
+    uint32_t i = 0;
+
+    if (!entries || num_entries == 0)
+        return -EINVAL;
+
+    if (!agm_server_died) {
+        IAGM_V1_1 *agm_client = get_agm_server_1_1();
+
+        if (agm_client == nullptr)
+            return agm_params_batch_each(entries, num_entries);
+
+        hidl_vec<AgmParamsBatchEntry> entries_hidl(num_entries);
+        for (i = 0; i < num_entries; i++) {
+            entries_hidl[i].type = (AgmParamsBatchType) entries[i].type;
+            entries_hidl[i].session_id = entries[i].session_id;
+            entries_hidl[i].aif_id = entries[i].aif_id;
+            entries_hidl[i].payload.setToExternal(
+                              (uint8_t *) entries[i].payload,
+                              entries[i].payload ? entries[i].size : 0);
+        }
+        auto status = agm_client->ipc_agm_params_batch(entries_hidl,
+                      [&](int32_t _ret,
+                          const hidl_vec<AgmParamsBatchEntry>& entries_ret)
+                      {  ret = _ret;
+                         if (entries_ret.size() != num_entries) {
+                             if (!ret)
+                                 ret = -EIO;
+                             for (i = 0; i < num_entries; i++)
+                                 entries[i].status = ret;
+                             return;
+                         }
+                         for (i = 0; i < num_entries; i++) {
+                             entries[i].status = entries_ret[i].status;
+                             if (entries[i].type ==
+                                     AGM_PARAMS_BATCH_SESSION_GET &&
+                                 entries_ret[i].payload.size() ==
+                                     entries[i].size)
+                                 memcpy(entries[i].payload,
+                                        entries_ret[i].payload.data(),
+                                        entries[i].size);
+                         }
+                      });
+        if (!status.isOk()) {
+            ALOGE("%s: HIDL call failed. ret=%d\n", __func__, ret);
+            ret = -EIO;
+            for (i = 0; i < num_entries; i++)
+                entries[i].status = ret;
+        }
+    }
+    return ret;
+}
+
+static int agm_session_async(AgmAsyncOp op, uint64_t handle,
+                             uint32_t session_id, uint32_t aif_id,
+                             bool state, uint64_t cookie) {
+    if (!agm_server_died) {
+        IAGM_V1_1 *agm_client = get_agm_server_1_1();
+
+        /*@1.0 services cannot queue work, callers use the synchronous calls*/
+        if (agm_client == nullptr)
+            return -ENOSYS;
+        return agm_client->ipc_agm_session_async(op, handle, session_id,
+                                                 aif_id, state, cookie);
+    }
+    return -EINVAL;
+}
+
+int agm_session_set_standby(uint32_t session_id, bool enable) {
+    ALOGV("%s called with session_id = %d, enable = %d\n", __func__,
+          session_id, enable);
+    if (!agm_server_died) {
+        IAGM_V1_1 *agm_client = get_agm_server_1_1();
+
+        /*@1.0 services always tear the graph down on close*/
+        if (agm_client == nullptr)
+            return -ENOSYS;
+        return agm_client->ipc_agm_session_set_standby(session_id, enable);
+    }
+    return -EINVAL;
+}
+
+int agm_session_prepare_async(uint64_t handle, uint64_t cookie) {
+    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
+    return agm_session_async(AgmAsyncOp::PREPARE, handle, 0, 0, false,
+                             cookie);
+}
+
+int agm_session_start_async(uint64_t handle, uint64_t cookie) {
+    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
+    return agm_session_async(AgmAsyncOp::START, handle, 0, 0, false, cookie);
+}
+
+int agm_session_stop_async(uint64_t handle, uint64_t cookie) {
+    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
+    return agm_session_async(AgmAsyncOp::STOP, handle, 0, 0, false, cookie);
+}
+
+int agm_session_close_async(uint64_t handle, uint64_t cookie) {
+    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
+    return agm_session_async(AgmAsyncOp::CLOSE, handle, 0, 0, false, cookie);
+}
+
+int agm_session_aif_connect_async(uint32_t session_id, uint32_t aif_id,
+                                  bool state, uint64_t cookie) {
+    ALOGV("%s called with sess_id = %d, aif = %d, state = %s\n", __func__,
+           session_id, aif_id, state ? "true" : "false");
+    return agm_session_async(AgmAsyncOp::AIF_CONNECT, 0, session_id, aif_id,
+                             state, cookie);
+}
+
 int agm_session_read(uint64_t handle, void *buf, size_t *byte_count){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         if (!handle)
             return -EINVAL;
 
@@ -408,7 +778,7 @@ int agm_session_read(uint64_t handle, void *buf, size_t *byte_count){
 int agm_session_write(uint64_t handle, void *buf, size_t *byte_count) {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         int ret = -EINVAL;
 
         if (!handle)
@@ -440,7 +810,7 @@ int agm_session_set_loopback(uint32_t capture_session_id,
     ALOGV("%s called capture_session_id = %d, playback_session_id = %d\n", __func__,
            capture_session_id, playback_session_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_set_loopback(capture_session_id,
                                                         playback_session_id,
                                                         state);
@@ -451,7 +821,7 @@ int agm_session_set_loopback(uint32_t capture_session_id,
 size_t agm_get_hw_processed_buff_cnt(uint64_t handle, enum direction dir) {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         Direction dir_hidl = (Direction) dir;
         return agm_client->ipc_agm_get_hw_processed_buff_cnt(handle,
                                                              dir_hidl);
@@ -464,7 +834,7 @@ int agm_get_aif_info_list(struct aif_info *aif_list, size_t *num_aif_info) {
     if (!agm_server_died) {
         uint32_t num = (uint32_t) *num_aif_info;
         int ret = -EINVAL;
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         auto status = agm_client->ipc_agm_get_aif_info_list(num,[&](int32_t _ret,
                                             hidl_vec<AifInfo> aif_list_ret_hidl,
                                             uint32_t num_aif_info_hidl )
@@ -497,7 +867,7 @@ int agm_session_aif_get_tag_module_info(uint32_t session_id, uint32_t aif_id,
 {
     ALOGV("%s : sess_id = %d, aif_id = %d\n", __func__, session_id, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         uint32_t size_hidl = (uint32_t) *size;
         int ret = 0;
         auto status = agm_client->ipc_agm_session_aif_get_tag_module_info(
@@ -528,7 +898,7 @@ int agm_session_get_params(uint32_t session_id, void *payload, size_t size)
 {
     ALOGV("%s : sess_id = %d, size = %zu\n", __func__, session_id, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<uint8_t> buf_hidl;
         int ret = 0;
 
@@ -550,11 +920,50 @@ int agm_session_get_params(uint32_t session_id, void *payload, size_t size)
     return -EINVAL;
 }
 
+static native_handle_t *agm_params_shmem_create(void *payload, size_t size)
+{
+    native_handle_t *handle = nullptr;
+    void *addr = nullptr;
+    int fd;
+
+    fd = ashmem_create_region("agm_params", size);
+    if (fd < 0) {
+        ALOGE("%s: ashmem_create_region failed %d", __func__, fd);
+        return nullptr;
+    }
+
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        ALOGE("%s: mmap failed errno %d", __func__, errno);
+        goto err;
+    }
+    memcpy(addr, payload, size);
+    munmap(addr, size);
+
+    handle = native_handle_create(1, 0);
+    if (!handle) {
+        ALOGE("%s native_handle_create fails", __func__);
+        goto err;
+    }
+    handle->data[0] = fd;
+    return handle;
+
+err:
+    close(fd);
+    return nullptr;
+}
+
+static void agm_params_shmem_release(native_handle_t *handle)
+{
+    native_handle_close(handle);
+    native_handle_delete(handle);
+}
+
 int agm_aif_set_params(uint32_t aif_id, void *payload, size_t size)
 {
     ALOGV("%s : aif_id = %d\n", __func__, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 
         uint32_t size_hidl = (uint32_t) size;
         hidl_vec<uint8_t> payload_hidl;
@@ -572,13 +981,34 @@ int agm_session_aif_set_params(uint32_t session_id, uint32_t aif_id,
 {
     ALOGV("%s : sess_id = %d, aif_id = %d\n", __func__, session_id, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
+        IAGM_V1_1 *agm_client_1_1 = get_agm_server_1_1();
 
         uint32_t size_hidl = (uint32_t) size;
+        if (size >= AGM_PARAMS_SHMEM_THRESHOLD &&
+            agm_client_1_1 != nullptr) {
+            native_handle_t *handle = agm_params_shmem_create(payload, size);
+            int32_t ret;
+
+            if (!handle)
+                return -ENOMEM;
+            ret = agm_client_1_1->ipc_agm_session_aif_set_params_shmem(
+                              session_id, aif_id, hidl_memory("agm_params",
+                              hidl_handle(handle), size), size_hidl);
+            agm_params_shmem_release(handle);
+            return ret;
+        }
+
         hidl_vec<uint8_t> payload_hidl;
         payload_hidl.resize(size_hidl);
         memcpy(payload_hidl.data(), payload, size_hidl);
 
+#ifdef AGM_ONEWAY_CONTROLS
+        if (agm_client_1_1 != nullptr)
+            return agm_client_1_1->ipc_agm_session_aif_set_params_oneway(
+                                  session_id, aif_id, payload_hidl, size_hidl,
+                                  getpid()).isOk() ? 0 : -EIO;
+#endif
         return agm_client->ipc_agm_session_aif_set_params(session_id,
                                                           aif_id,
                                                           payload_hidl,
@@ -591,12 +1021,33 @@ int agm_session_set_params(uint32_t session_id, void *payload, size_t size)
 {
     ALOGV("%s : sess_id = %d, size = %zu\n", __func__, session_id, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
+        IAGM_V1_1 *agm_client_1_1 = get_agm_server_1_1();
 
         uint32_t size_hidl = (uint32_t) size;
+        if (size >= AGM_PARAMS_SHMEM_THRESHOLD &&
+            agm_client_1_1 != nullptr) {
+            native_handle_t *handle = agm_params_shmem_create(payload, size);
+            int32_t ret;
+
+            if (!handle)
+                return -ENOMEM;
+            ret = agm_client_1_1->ipc_agm_session_set_params_shmem(
+                              session_id, hidl_memory("agm_params",
+                              hidl_handle(handle), size), size_hidl);
+            agm_params_shmem_release(handle);
+            return ret;
+        }
+
         hidl_vec<uint8_t> payload_hidl;
         payload_hidl.resize(size_hidl);
         memcpy(payload_hidl.data(), payload, size_hidl);
+#ifdef AGM_ONEWAY_CONTROLS
+        if (agm_client_1_1 != nullptr)
+            return agm_client_1_1->ipc_agm_session_set_params_oneway(
+                                  session_id, payload_hidl, size_hidl,
+                                  getpid()).isOk() ? 0 : -EIO;
+#endif
         return agm_client->ipc_agm_session_set_params(session_id,
                                                       payload_hidl,
                                                       size_hidl);
@@ -609,7 +1060,7 @@ int agm_set_params_with_tag(uint32_t session_id, uint32_t aif_id,
 {
     ALOGV("%s : sess_id = %d, aif_id = %d\n", __func__, session_id, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 
         hidl_vec<AgmTagConfig> tag_cfg_hidl(1);
         tag_cfg_hidl.data()->tag = tag_config->tag;
@@ -619,6 +1070,14 @@ int agm_set_params_with_tag(uint32_t session_id, uint32_t aif_id,
              tag_cfg_hidl.data()->kv[i].key = tag_config->kv[i].key;
              tag_cfg_hidl.data()->kv[i].value = tag_config->kv[i].value;
         }
+#ifdef AGM_ONEWAY_CONTROLS
+        IAGM_V1_1 *agm_client_1_1 = get_agm_server_1_1();
+
+        if (agm_client_1_1 != nullptr)
+            return agm_client_1_1->ipc_agm_set_params_with_tag_oneway(
+                                  session_id, aif_id, tag_cfg_hidl,
+                                  getpid()).isOk() ? 0 : -EIO;
+#endif
         return agm_client->ipc_agm_set_params_with_tag(session_id,
                                                          aif_id, tag_cfg_hidl);
     }
@@ -630,7 +1089,7 @@ int agm_set_params_with_tag_to_acdb(uint32_t session_id, uint32_t aif_id,
 {
     ALOGV("%s : sess_id = %d, size = %zu\n", __func__, session_id, size);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 
         uint32_t size_hidl = (uint32_t) size;
         hidl_vec<uint8_t> payload_hidl;
@@ -645,9 +1104,24 @@ int agm_set_params_with_tag_to_acdb(uint32_t session_id, uint32_t aif_id,
 int agm_set_params_to_acdb_tunnel(void *payload, size_t size)
 {
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
+        IAGM_V1_1 *agm_client_1_1 = get_agm_server_1_1();
 
         uint32_t size_hidl = (uint32_t) size;
+        if (size >= AGM_PARAMS_SHMEM_THRESHOLD &&
+            agm_client_1_1 != nullptr) {
+            native_handle_t *handle = agm_params_shmem_create(payload, size);
+            int32_t ret;
+
+            if (!handle)
+                return -ENOMEM;
+            ret = agm_client_1_1->ipc_agm_set_params_to_acdb_tunnel_shmem(
+                              hidl_memory("agm_params", hidl_handle(handle),
+                              size), size_hidl);
+            agm_params_shmem_release(handle);
+            return ret;
+        }
+
         hidl_vec<uint8_t> payload_hidl;
         payload_hidl.resize(size_hidl);
         memcpy(payload_hidl.data(), payload, size_hidl);
@@ -656,12 +1130,38 @@ int agm_set_params_to_acdb_tunnel(void *payload, size_t size)
     return -EINVAL;
 }
 
+int agm_set_params_to_acdb_tunnel_batch(void *payload, size_t size)
+{
+    if (!agm_server_died) {
+        IAGM_V1_1 *agm_client = get_agm_server_1_1();
+        native_handle_t *handle = NULL;
+        int32_t ret;
+
+        if (!payload || !size)
+            return -EINVAL;
+        /*@1.0 services have no batch method*/
+        if (agm_client == nullptr)
+            return -ENOSYS;
+
+        /*batches are large by nature, always pass them in shared memory*/
+        handle = agm_params_shmem_create(payload, size);
+        if (!handle)
+            return -ENOMEM;
+        ret = agm_client->ipc_agm_set_params_to_acdb_tunnel_batch(
+                          hidl_memory("agm_params", hidl_handle(handle),
+                          size), (uint32_t) size);
+        agm_params_shmem_release(handle);
+        return ret;
+    }
+    return -EINVAL;
+}
+
 int agm_session_register_for_events(uint32_t session_id,
                                           struct agm_event_reg_cfg *evt_reg_cfg)
 {
     ALOGV("%s : sess_id = %d\n", __func__, session_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 
         hidl_vec<AgmEventRegCfg> evt_reg_cfg_hidl(1);
 
@@ -673,6 +1173,14 @@ int agm_session_register_for_events(uint32_t session_id,
         for (int i = 0; i < evt_reg_cfg->event_config_payload_size; i++)
             evt_reg_cfg_hidl.data()->event_config_payload[i] = evt_reg_cfg->event_config_payload[i];
 
+#ifdef AGM_ONEWAY_CONTROLS
+        IAGM_V1_1 *agm_client_1_1 = get_agm_server_1_1();
+
+        if (agm_client_1_1 != nullptr)
+            return agm_client_1_1->ipc_agm_session_register_for_events_oneway(
+                                  session_id, evt_reg_cfg_hidl,
+                                  getpid()).isOk() ? 0 : -EIO;
+#endif
         return agm_client->ipc_agm_session_register_for_events(session_id,
                                                               evt_reg_cfg_hidl);
     }
@@ -684,7 +1192,7 @@ int agm_session_aif_set_cal(uint32_t session_id ,uint32_t aif_id ,
 {
     ALOGV("%s : sess_id = %d, aif_id = %d\n", __func__, session_id, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 
         hidl_vec<AgmCalConfig> cal_cfg_hidl(1);
         cal_cfg_hidl.data()->num_ckvs = cal_config->num_ckvs;
@@ -705,7 +1213,7 @@ int agm_session_set_ec_ref(uint32_t capture_session_id,
     ALOGV("%s : cap_sess_id = %d, aif_id = %d\n", __func__,
                                   capture_session_id, aif_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_set_ec_ref(capture_session_id,
                                                        aif_id, state);
     }
@@ -725,7 +1233,7 @@ int agm_session_register_cb(uint32_t session_id, agm_event_cb cb,
 #endif
         ClntClbk *cl_clbk_data = NULL;
         uint64_t cl_clbk_data_add = 0;
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
 #ifndef AGM_HIDL_ENABLED
         if (!is_cb_registered) {
             ClbkBinder = new AGMCallback();
@@ -790,7 +1298,7 @@ int agm_session_eos(uint64_t handle)
 {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         return agm_client->ipc_agm_session_eos(handle);
     }
     return -EINVAL;
@@ -800,7 +1308,7 @@ int agm_get_session_time(uint64_t handle, uint64_t *timestamp)
 {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         int ret = -EINVAL;
         auto status = agm_client->ipc_agm_get_session_time(handle,
                                              [&](int _ret, uint64_t ts)
@@ -819,7 +1327,7 @@ int agm_get_buffer_timestamp(uint32_t session_id, uint64_t *timestamp)
     ALOGV("%s: session_id = %x\n", __func__, session_id);
     int ret = -EINVAL;
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         auto status = agm_client->ipc_agm_get_buffer_timestamp(session_id,
                                              [&](int _ret, uint64_t ts)
                                              { ret = _ret;
@@ -837,7 +1345,7 @@ int agm_session_get_buf_info(uint32_t session_id, struct agm_buf_info *buf_info,
     ALOGV("%s : session_id = %d\n", __func__, session_id);
     int ret = -EINVAL;
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         const native_handle *datahandle = nullptr;
         const native_handle *poshandle = nullptr;
 
@@ -869,7 +1377,7 @@ int agm_set_gapless_session_metadata(uint64_t handle, enum agm_gapless_silence_t
 {
     ALOGV("%s called with handle = %x \n", __func__, handle);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         AgmGaplessSilenceType type_hidl = (AgmGaplessSilenceType) type;
         return agm_client->ipc_agm_set_gapless_session_metadata(handle,
                                                  type_hidl,
@@ -888,7 +1396,7 @@ int agm_session_set_non_tunnel_mode_config(uint64_t handle,
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long)handle);
 
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmSessionConfig> session_config_hidl(1);
         memcpy(session_config_hidl.data(),
                session_config,
@@ -934,7 +1442,7 @@ int agm_session_write_with_metadata(uint64_t handle, struct agm_buff *buf, size_
 
     if (!agm_server_died) {
         ALOGV("%s:%d hndl %p",__func__, __LINE__, handle);
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmBuff> buf_hidl(1);
         native_handle_t *allocHidlHandle = nullptr;
         allocHidlHandle = native_handle_create(1, 1);
@@ -992,7 +1500,7 @@ int agm_session_read_with_metadata(uint64_t handle, struct agm_buff  *buf, uint3
         goto done;
 
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         native_handle_t *allocHidlHandle = nullptr;
         allocHidlHandle = native_handle_create(1, 1);
         if (!allocHidlHandle) {
@@ -1053,7 +1561,7 @@ int agm_aif_group_set_media_config(uint32_t group_id,
 {
     ALOGV("%s called, group_id = %d \n", __func__, group_id);
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmGroupMediaConfig> media_config_hidl(1);
         media_config_hidl.data()->rate = media_config->config.rate;
         media_config_hidl.data()->channels = media_config->config.channels;
@@ -1072,7 +1580,7 @@ int agm_get_group_aif_info_list(struct aif_info *aif_list, size_t *num_groups)
     if (!agm_server_died) {
         uint32_t num = (uint32_t) *num_groups;
         int ret = -EINVAL;
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         auto status = agm_client->ipc_agm_get_group_aif_info_list(num,[&](int32_t _ret,
                                             hidl_vec<AifInfo> aif_list_ret_hidl,
                                             uint32_t num_groups_hidl )
@@ -1105,7 +1613,7 @@ int agm_session_write_datapath_params(uint32_t session_id, struct agm_buff *buf)
     ALOGV("%s called with session id = %d \n", __func__, session_id);
 
     if (!agm_server_died) {
-        android::sp<IAGM> agm_client = get_agm_server();
+        IAGM *agm_client = get_agm_server();
         hidl_vec<AgmBuff> buf_hidl(1);
         AgmBuff *agmBuff = buf_hidl.data();
         agmBuff->size = buf->size;
@@ -1130,7 +1638,7 @@ int agm_dump(struct agm_dump_info *dump_info) {
         ALOGE("%s: Cannot perform dump, AGM service has died", __func__);
         return -EINVAL;
     }
-    android::sp<IAGM> agm_client = get_agm_server();
+    IAGM *agm_client = get_agm_server();
     hidl_vec<AgmDumpInfo> dump_info_hidl;
     dump_info_hidl.resize(1);
     memcpy(dump_info_hidl.data(),
@@ -22,8 +22,18 @@ LOCAL_SHARED_LIBRARIES := \
     libbase \
     libar-gsl \
     vendor.qti.hardware.AGMIPC@1.0 \
+    vendor.qti.hardware.AGMIPC@1.1 \
     libagm
 
+ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_TRACE)), true)
+LOCAL_CFLAGS        += -DAGM_TRACE_ENABLED
+endif
+
+# optional hold back, in ms, for batching bursts of module events per client
+ifneq ($(strip $(AUDIO_FEATURE_AGM_EVENT_BATCH_WINDOW_MS)),)
+LOCAL_CFLAGS        += -DAGM_EVENT_BATCH_WINDOW_MS=$(AUDIO_FEATURE_AGM_EVENT_BATCH_WINDOW_MS)
+endif
+
 include $(BUILD_SHARED_LIBRARY)
 endif
 
@@ -52,6 +62,7 @@ LOCAL_SHARED_LIBRARIES := \
     libhardware \
     libhidlbase \
     vendor.qti.hardware.AGMIPC@1.0 \
+    vendor.qti.hardware.AGMIPC@1.1 \
     vendor.qti.hardware.AGMIPC@1.0-impl \
     libagm
 
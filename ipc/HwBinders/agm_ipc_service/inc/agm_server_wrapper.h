@@ -62,7 +62,7 @@
 #ifndef ANDROID_SYSTEM_AGMIPC_V1_0_AGM_H
 #define ANDROID_SYSTEM_AGMIPC_V1_0_AGM_H
 
-#include <vendor/qti/hardware/AGMIPC/1.0/IAGM.h>
+#include <vendor/qti/hardware/AGMIPC/1.1/IAGM.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <vector>
@@ -127,7 +127,12 @@ typedef struct clbk_data {
    SrvrClbk *srv_clt_data;
 } clbk_data;
 
-struct AGM : public IAGM {
+using ::vendor::qti::hardware::AGMIPC::V1_1::AgmAsyncOp;
+using ::vendor::qti::hardware::AGMIPC::V1_1::AgmParamsBatchEntry;
+using ::vendor::qti::hardware::AGMIPC::V1_1::AgmParamsBatchType;
+using ::vendor::qti::hardware::AGMIPC::V1_1::AgmSessionLaunchConfig;
+
+struct AGM : public ::vendor::qti::hardware::AGMIPC::V1_1::IAGM {
     public :
     AGM() {
       agm_initialized = agm_init() == 0?true:false;
@@ -248,6 +253,43 @@ struct AGM : public IAGM {
                                ipc_agm_get_aif_info_list_cb _hidl_cb) override;
     Return<int32_t> ipc_agm_session_write_datapath_params(uint32_t session_id,
                                const hidl_vec<AgmBuff>& buff) override;
+    Return<void> ipc_agm_session_register_for_events_oneway(uint32_t session_id,
+                               const hidl_vec<AgmEventRegCfg>& evt_reg_cfg,
+                               uint32_t pid) override;
+    Return<void> ipc_agm_session_set_params_oneway(uint32_t session_id,
+                               const hidl_vec<uint8_t>& payload,
+                               uint32_t size, uint32_t pid) override;
+    Return<void> ipc_agm_session_aif_set_params_oneway(uint32_t session_id,
+                               uint32_t aif_id,
+                               const hidl_vec<uint8_t>& payload,
+                               uint32_t size, uint32_t pid) override;
+    Return<void> ipc_agm_set_params_with_tag_oneway(uint32_t session_id,
+                               uint32_t aif_id,
+                               const hidl_vec<AgmTagConfig>& tag_config,
+                               uint32_t pid) override;
+    Return<int32_t> ipc_agm_session_set_params_shmem(uint32_t session_id,
+                               const hidl_memory& payload,
+                               uint32_t size) override;
+    Return<int32_t> ipc_agm_session_aif_set_params_shmem(uint32_t session_id,
+                               uint32_t aif_id,
+                               const hidl_memory& payload,
+                               uint32_t size) override;
+    Return<int32_t> ipc_agm_set_params_to_acdb_tunnel_shmem(
+                               const hidl_memory& payload,
+                               uint32_t size) override;
+    Return<int32_t> ipc_agm_set_params_to_acdb_tunnel_batch(
+                               const hidl_memory& payload,
+                               uint32_t size) override;
+    Return<void> ipc_agm_params_batch(
+                               const hidl_vec<AgmParamsBatchEntry>& entries,
+                               ipc_agm_params_batch_cb _hidl_cb) override;
+    Return<int32_t> ipc_agm_session_async(AgmAsyncOp op, uint64_t hndl,
+                               uint32_t session_id, uint32_t aif_id,
+                               bool state, uint64_t cookie) override;
+    Return<void> ipc_agm_session_launch(const AgmSessionLaunchConfig& config,
+                               ipc_agm_session_launch_cb _hidl_cb) override;
+    Return<int32_t> ipc_agm_session_set_standby(uint32_t session_id,
+                                                bool enable) override;
 
     int is_agm_initialized() { return agm_initialized;}
 
@@ -63,15 +63,34 @@
 
 #define LOG_TAG "agm_server_wrapper"
 #include "inc/agm_server_wrapper.h"
+#include <agm/agm_trace.h>
 #include <log/log.h>
 #include <cutils/list.h>
 #include <cutils/android_filesystem_config.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <new>
 #include "gsl_intf.h"
 #include <hwbinder/IPCThreadState.h>
 
 #define MAX_CACHE_SIZE 64
+
+/*
+ * Module events are queued per client and delivered from a worker, events
+ * queued while a delivery is in flight go out together in one transaction.
+ * A non zero batch window holds the first event of a burst back for that
+ * long. Once a client has AGM_EVENT_QUEUE_MAX events pending, a new event
+ * replaces a pending one with the same id (latest wins) or the oldest one.
+ */
+#ifndef AGM_EVENT_QUEUE_MAX
+#define AGM_EVENT_QUEUE_MAX 64
+#endif
+
+#ifndef AGM_EVENT_BATCH_WINDOW_MS
+#define AGM_EVENT_BATCH_WINDOW_MS 0
+#endif
 #define NUM_GKV(x)                     (*((uint32_t *) x))
 
 #ifndef __SIGRTMIN
@@ -85,6 +104,7 @@ static const constexpr int DEBUGGER_SIGNAL = (__SIGRTMIN + 3);
 using AgmCallbackData = ::vendor::qti::hardware::AGMIPC::V1_0::implementation::clbk_data;
 using AgmServerCallback = ::vendor::qti::hardware::AGMIPC::V1_0::implementation::SrvrClbk;
 using ::vendor::qti::hardware::AGMIPC::V1_0::AgmDumpInfo;
+using ::vendor::qti::hardware::AGMIPC::V1_0::AgmEventCbParams;
 
 static list_declare(client_list);
 static pthread_mutex_t client_list_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -101,13 +121,255 @@ typedef struct {
    std::vector<uint32_t> aif_id_list;
 } agm_client_session_handle;
 
+typedef struct {
+    struct listnode list;
+    uint32_t session_id;
+    uint64_t clnt_data;
+    uint32_t source_module_id;
+    uint32_t event_id;
+    uint32_t event_payload_size;
+    uint8_t event_payload[];
+} client_event;
+
+typedef struct {
+    struct listnode event_list;
+    uint32_t num_events;
+    bool exit;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t pid;
+    android::sp<IAGMCallback> clbk_binder;
+} client_event_queue;
+
 typedef struct {
     struct listnode list;
     uint32_t pid;
     android::sp<IAGMCallback> clbk_binder;
     struct listnode agm_client_hndl_list;
+    client_event_queue *evt_queue;
 } client_info;
 
+static bool client_event_same(client_event *a, client_event *b)
+{
+    return a->session_id == b->session_id && a->clnt_data == b->clnt_data &&
+           a->source_module_id == b->source_module_id &&
+           a->event_id == b->event_id;
+}
+
+/*sends a run of events for the same registration in one transaction*/
+static void client_event_queue_deliver(client_event_queue *queue,
+                                       struct listnode *batch)
+{
+    struct listnode *node = NULL;
+    struct listnode *tempnode = NULL;
+    client_event *first = NULL;
+    client_event *evt = NULL;
+    size_t count = 0, i = 0;
+
+    while (!list_empty(batch)) {
+        first = node_to_item(list_head(batch), client_event, list);
+        count = 0;
+        list_for_each(node, batch) {
+            evt = node_to_item(node, client_event, list);
+            if (evt->session_id != first->session_id ||
+                evt->clnt_data != first->clnt_data)
+                break;
+            count++;
+        }
+
+        ::android::hardware::hidl_vec<AgmEventCbParams> evt_param_l(count);
+        i = 0;
+        list_for_each_safe(node, tempnode, batch) {
+            if (i == count)
+                break;
+            evt = node_to_item(node, client_event, list);
+            evt_param_l[i].source_module_id = evt->source_module_id;
+            evt_param_l[i].event_id = evt->event_id;
+            evt_param_l[i].event_payload_size = evt->event_payload_size;
+            evt_param_l[i].event_payload.setToExternal(
+                                      evt->event_payload,
+                                      evt->event_payload_size);
+            i++;
+        }
+
+        auto status = queue->clbk_binder->event_callback(first->session_id,
+                                  evt_param_l, first->clnt_data);
+        if (!status.isOk())
+            ALOGE("%s: HIDL call failed for pid %d, %zu events\n", __func__,
+                  queue->pid, count);
+
+        for (i = 0; i < count; i++) {
+            evt = node_to_item(list_head(batch), client_event, list);
+            list_remove(&evt->list);
+            free(evt);
+        }
+    }
+}
+
+static void *client_event_queue_thread(void *arg)
+{
+    client_event_queue *queue = (client_event_queue *)arg;
+    struct listnode batch;
+    struct listnode *node = NULL;
+    struct listnode *tempnode = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    while (!queue->exit) {
+        if (list_empty(&queue->event_list)) {
+            pthread_cond_wait(&queue->cond, &queue->lock);
+            continue;
+        }
+        if (AGM_EVENT_BATCH_WINDOW_MS > 0) {
+            pthread_mutex_unlock(&queue->lock);
+            usleep(AGM_EVENT_BATCH_WINDOW_MS * 1000);
+            pthread_mutex_lock(&queue->lock);
+            if (queue->exit)
+                break;
+        }
+
+        list_init(&batch);
+        list_for_each_safe(node, tempnode, &queue->event_list) {
+            list_remove(node);
+            list_add_tail(&batch, node);
+        }
+        queue->num_events = 0;
+        pthread_mutex_unlock(&queue->lock);
+
+        client_event_queue_deliver(queue, &batch);
+
+        pthread_mutex_lock(&queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+/*called with client_list_lock held*/
+static client_event_queue *client_event_queue_create_l(client_info *client)
+{
+    client_event_queue *queue = NULL;
+
+    queue = new (std::nothrow) client_event_queue();
+    if (queue == NULL) {
+        ALOGE("%s: Cannot allocate memory for event queue\n", __func__);
+        return NULL;
+    }
+    list_init(&queue->event_list);
+    pthread_mutex_init(&queue->lock, (const pthread_mutexattr_t *) NULL);
+    pthread_cond_init(&queue->cond, (const pthread_condattr_t *) NULL);
+    queue->pid = client->pid;
+    queue->clbk_binder = client->clbk_binder;
+    if (pthread_create(&queue->thread, NULL, client_event_queue_thread,
+                       queue)) {
+        ALOGE("%s: Cannot create event thread for pid %d\n", __func__,
+              client->pid);
+        pthread_cond_destroy(&queue->cond);
+        pthread_mutex_destroy(&queue->lock);
+        delete queue;
+        return NULL;
+    }
+    return queue;
+}
+
+/*must be called without client_list_lock held, pending events are dropped*/
+static void client_event_queue_destroy(client_event_queue *queue)
+{
+    struct listnode *node = NULL;
+    struct listnode *tempnode = NULL;
+
+    if (queue == NULL)
+        return;
+
+    pthread_mutex_lock(&queue->lock);
+    queue->exit = true;
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(queue->thread, NULL);
+
+    list_for_each_safe(node, tempnode, &queue->event_list) {
+        list_remove(node);
+        free(node_to_item(node, client_event, list));
+    }
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->lock);
+    delete queue;
+}
+
+static int client_event_queue_post(uint32_t pid, uint32_t session_id,
+                                   uint64_t clnt_data,
+                                   struct agm_event_cb_params *evt_param)
+{
+    client_info *client_obj = NULL;
+    client_event_queue *queue = NULL;
+    client_event *evt = NULL;
+    client_event *victim = NULL;
+    struct listnode *node = NULL;
+    int ret = 0;
+
+    evt = (client_event *)calloc(1, sizeof(client_event) +
+                                    evt_param->event_payload_size);
+    if (evt == NULL) {
+        ALOGE("%s: Cannot allocate memory for event\n", __func__);
+        return -ENOMEM;
+    }
+    evt->session_id = session_id;
+    evt->clnt_data = clnt_data;
+    evt->source_module_id = evt_param->source_module_id;
+    evt->event_id = evt_param->event_id;
+    evt->event_payload_size = evt_param->event_payload_size;
+    memcpy(evt->event_payload, evt_param->event_payload,
+           evt_param->event_payload_size);
+
+    pthread_mutex_lock(&client_list_lock);
+    list_for_each(node, &client_list) {
+        client_obj = node_to_item(node, client_info, list);
+        if (client_obj->pid == pid)
+            break;
+        client_obj = NULL;
+    }
+    if (!client_obj || !client_obj->clbk_binder) {
+        ALOGE("%s: Failed to get client data for pid %d\n", __func__, pid);
+        ret = -EINVAL;
+        goto done;
+    }
+    if (!client_obj->evt_queue)
+        client_obj->evt_queue = client_event_queue_create_l(client_obj);
+    queue = client_obj->evt_queue;
+    if (!queue) {
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->num_events >= AGM_EVENT_QUEUE_MAX) {
+        list_for_each(node, &queue->event_list) {
+            victim = node_to_item(node, client_event, list);
+            if (client_event_same(victim, evt))
+                break;
+            victim = NULL;
+        }
+        if (!victim) {
+            victim = node_to_item(list_head(&queue->event_list),
+                                  client_event, list);
+            ALOGW("%s: pid %d is behind, dropping event 0x%x\n", __func__,
+                  pid, victim->event_id);
+        }
+        list_remove(&victim->list);
+        free(victim);
+        queue->num_events--;
+    }
+    list_add_tail(&queue->event_list, &evt->list);
+    queue->num_events++;
+    evt = NULL;
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+
+done:
+    pthread_mutex_unlock(&client_list_lock);
+    free(evt);
+    return ret;
+}
+
 void dumpAgmStackTrace(struct agm_dump_info *d_info) {
     if (d_info->uid == AID_AUDIOSERVER && d_info->signal > 0) {
         // In TimeCheck or ANR scenarios, HAL receives debugger signal
@@ -135,6 +397,7 @@ void client_death_notifier::serviceDied(uint64_t cookie,
     client_info *handle = NULL;
     struct listnode *sess_node = NULL;
     struct listnode *sess_tempnode = NULL;
+    client_event_queue *evt_queue = NULL;
 
     AgmCallbackData* clbk_data_hndl = NULL;
     pthread_mutex_lock(&clbk_data_list_lock);
@@ -193,10 +456,12 @@ void client_death_notifier::serviceDied(uint64_t cookie,
             }
             list_remove(node);
             handle->clbk_binder->unlinkToDeath(this);
+            evt_queue = handle->evt_queue;
             free(handle);
         }
     }
     pthread_mutex_unlock(&client_list_lock);
+    client_event_queue_destroy(evt_queue);
     ALOGV("%s: exit\n", __func__);
 }
 
@@ -359,6 +624,7 @@ void ipc_callback (uint32_t session_id,
                    struct agm_event_cb_params *evt_param,
                    void *client_data)
 {
+    AGM_TRACE_SCOPE("ipc_callback");
     ALOGV("%s called with sess_id = %d, client_data = %p \n", __func__,
           session_id, client_data);
     SrvrClbk *sr_clbk_dat;
@@ -366,7 +632,6 @@ void ipc_callback (uint32_t session_id,
     sp<IAGMCallback> clbk_bdr = NULL;
     struct listnode *node = NULL;
     struct listnode *tempnode = NULL;
-    hidl_vec<AgmEventCbParams> evt_param_l(1);
     hidl_vec<AgmReadWriteEventCbParams> rw_evt_param_hidl(1);
     AgmReadWriteEventCbParams *rw_evt_param = NULL;
     AgmEventReadWriteDonePayload *rw_payload = NULL;
@@ -480,18 +745,8 @@ void ipc_callback (uint32_t session_id,
         if (allocHidlHandle)
             native_handle_delete(allocHidlHandle);
     } else {
-        evt_param_l.data()->source_module_id = evt_param->source_module_id;
-        evt_param_l.data()->event_payload_size = evt_param->event_payload_size;
-        evt_param_l.data()->event_id = evt_param->event_id;
-        evt_param_l.data()->event_payload.resize(evt_param->event_payload_size);
-        int8_t *dst = (int8_t *)evt_param_l.data()->event_payload.data();
-        int8_t *src = (int8_t *)evt_param->event_payload;
-        memcpy(dst, src, evt_param->event_payload_size);
-        auto status = clbk_bdr->event_callback(session_id, evt_param_l,
-                                  sr_clbk_dat->get_clnt_data());
-        if (!status.isOk()) {
-            ALOGE("%s: HIDL call failed.\n", __func__);
-        }
+        client_event_queue_post(sr_clbk_dat->pid, session_id,
+                                sr_clbk_dat->get_clnt_data(), evt_param);
     }
 }
 // Methods from ::vendor::qti::hardware::AGMIPC::V1_0::IAGM follow.
@@ -603,6 +858,7 @@ Return<int32_t> AGM::ipc_agm_session_aif_set_metadata(uint32_t session_id,
 Return<int32_t> AGM::ipc_agm_session_aif_connect(uint32_t session_id,
                                                  uint32_t aif_id,
                                                  bool state) {
+    AGM_TRACE_SCOPE("ipc_agm_session_aif_connect");
     ALOGV("%s : session_id = %d, aif_id =%d, state = %s\n", __func__,
                           session_id, aif_id, state ? "true" : "false");
     pthread_mutex_lock(&client_list_lock);
@@ -650,6 +906,7 @@ Return<void> AGM::ipc_agm_session_get_params(uint32_t session_id,
                                      uint32_t size,
                                      const hidl_vec<uint8_t>& buff,
                                      ipc_agm_session_get_params_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_session_get_params");
     ALOGV("%s : session_id = %d, size = %d\n", __func__, session_id, size);
     uint8_t * payload_local = NULL;
     int32_t ret = 0;
@@ -707,6 +964,7 @@ Return<int32_t> AGM::ipc_agm_session_aif_set_params(uint32_t session_id,
                                                uint32_t aif_id,
                                                const hidl_vec<uint8_t>& payload,
                                                uint32_t size) {
+    AGM_TRACE_SCOPE("ipc_agm_session_aif_set_params");
     ALOGV("%s : session_id = %d, aif_id =%d, size = %d\n", __func__,
                                                       session_id, aif_id, size);
     size_t size_local = (size_t) size;
@@ -764,6 +1022,7 @@ Return<int32_t> AGM::ipc_agm_session_aif_set_cal(uint32_t session_id,
 Return<int32_t> AGM::ipc_agm_session_set_params(uint32_t session_id,
                                                const hidl_vec<uint8_t>& payload,
                                                uint32_t size) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_params");
     ALOGV("%s : session_id = %d, size = %d\n", __func__, session_id, size);
     size_t size_local = (size_t) size;
     void * payload_local = NULL;
@@ -901,6 +1160,7 @@ Return<int32_t> AGM::ipc_agm_session_register_for_events(uint32_t session_id,
 Return<void> AGM::ipc_agm_session_open(uint32_t session_id,
                                        AgmSessionMode sess_mode,
                                        ipc_agm_session_open_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_session_open");
     uint64_t handle = 0;
     agm_client_session_handle *session_handle = NULL;
     hidl_vec<uint64_t> handle_ret(1);
@@ -934,6 +1194,7 @@ Return<int32_t> AGM::ipc_agm_session_set_config(uint64_t hndl,
                 const hidl_vec<AgmSessionConfig>& session_config,
                 const hidl_vec<AgmMediaConfig>& media_config,
                 const hidl_vec<AgmBufferConfig>& buffer_config) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_config");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     struct agm_media_config *media_config_local = NULL;
@@ -978,15 +1239,15 @@ Return<int32_t> AGM::ipc_agm_session_set_config(uint64_t hndl,
     return ret;
 }
 
-Return<int32_t> AGM::ipc_agm_session_close(uint64_t hndl) {
-    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
+/*drops the handle the calling client opened, before the session is closed*/
+static void remove_session_handle(int pid, uint64_t hndl)
+{
     struct listnode *node = NULL;
     struct listnode *tempnode = NULL;
     agm_client_session_handle *session_handle = NULL;
     client_info *handle = NULL;
     struct listnode *sess_node = NULL;
     struct listnode *sess_tempnode = NULL;
-    int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
 
     pthread_mutex_lock(&client_list_lock);
     list_for_each_safe(node, tempnode, &client_list) {
@@ -1015,34 +1276,47 @@ Return<int32_t> AGM::ipc_agm_session_close(uint64_t hndl) {
     }
 done:
     pthread_mutex_unlock(&client_list_lock);
+}
+
+Return<int32_t> AGM::ipc_agm_session_close(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_close");
+    ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
+    int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
+
+    remove_session_handle(pid, hndl);
     return agm_session_close(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_prepare(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_prepare");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_prepare(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_start(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_start");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_start(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_stop(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_stop");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_stop(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_pause(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_pause");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_pause(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_flush(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_flush");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_flush(hndl);
@@ -1055,12 +1329,14 @@ Return<int32_t> AGM::ipc_agm_sessionid_flush(uint32_t session_id) {
 }
 
 Return<int32_t> AGM::ipc_agm_session_resume(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_resume");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_resume(hndl);
 }
 
 Return<int32_t> AGM::ipc_agm_session_suspend(uint64_t hndl) {
+    AGM_TRACE_SCOPE("ipc_agm_session_suspend");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
 
     return agm_session_suspend(hndl);
@@ -1068,6 +1344,7 @@ Return<int32_t> AGM::ipc_agm_session_suspend(uint64_t hndl) {
 
 Return<void> AGM::ipc_agm_session_read(uint64_t hndl, uint32_t count,
                                              ipc_agm_session_read_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_session_read");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
     hidl_vec <uint8_t> buff_ret;
     void *buffer = NULL;
@@ -1090,6 +1367,7 @@ Return<void> AGM::ipc_agm_session_write(uint64_t hndl,
                                         const hidl_vec<uint8_t>& buff,
                                         uint32_t count,
                                         ipc_agm_session_write_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_session_write");
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
     void* buffer = NULL;
 
@@ -1152,6 +1430,7 @@ Return<void> AGM::ipc_agm_get_aif_info_list(uint32_t num_aif_info,
 Return<int32_t> AGM::ipc_agm_session_set_loopback(uint32_t capture_session_id,
                                                   uint32_t playback_session_id,
                                                   bool state) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_loopback");
     ALOGV("%s called capture_session_id = %d, playback_session_id = %d\n", __func__,
            capture_session_id, playback_session_id);
     return agm_session_set_loopback(capture_session_id,
@@ -1162,6 +1441,7 @@ Return<int32_t> AGM::ipc_agm_session_set_loopback(uint32_t capture_session_id,
 
 Return<int32_t> AGM::ipc_agm_session_set_ec_ref(uint32_t capture_session_id,
                                                 uint32_t aif_id, bool state) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_ec_ref");
     ALOGV("%s : cap_sess_id = %d, aif_id = %d\n", __func__,
                                   capture_session_id, aif_id);
     return agm_session_set_ec_ref(capture_session_id, aif_id, state);
@@ -1274,6 +1554,7 @@ Return<int32_t> AGM::ipc_agm_session_register_callback(uint32_t session_id,
 }
 
 Return<int32_t> AGM::ipc_agm_session_eos(uint64_t hndl){
+    AGM_TRACE_SCOPE("ipc_agm_session_eos");
     ALOGV("%s : handle = %llx \n", __func__, (unsigned long long) hndl);
     return agm_session_eos(hndl);
 }
@@ -1439,6 +1720,7 @@ Return<void> AGM::ipc_agm_session_write_with_metadata(uint64_t hndl, const hidl_
                                                uint64_t consumed_sz,
                                                ipc_agm_session_write_with_metadata_cb _hidl_cb)
 {
+    AGM_TRACE_SCOPE("ipc_agm_session_write_with_metadata");
     int32_t ret = -EINVAL;
     struct agm_buff buf;
     uint32_t bufSize;
@@ -1494,6 +1776,7 @@ Return<void> AGM::ipc_agm_session_read_with_metadata(uint64_t hndl, const hidl_v
                                                uint32_t captured_sz,
                                                ipc_agm_session_read_with_metadata_cb _hidl_cb)
 {
+    AGM_TRACE_SCOPE("ipc_agm_session_read_with_metadata");
     struct agm_buff buf;
     int32_t ret = 0;
     hidl_vec<AgmBuff> outBuff_hidl(1);
@@ -1650,6 +1933,337 @@ Return<int32_t> AGM::ipc_agm_dump(const hidl_vec<AgmDumpInfo>& dump_info) {
     return agm_dump(d_info);
 }
 
+/*
+ *Oneway calls have no reply, failures are sent to the callback the
+ *calling process registered, if any.
+ */
+static void oneway_report_error(uint32_t pid, uint32_t session_id,
+                                const char *method, int32_t ret)
+{
+    android::sp<IAGMCallback> clbk_bdr = NULL;
+    android::sp<V1_1::IAGMCallback> clbk_bdr_1_1 = NULL;
+    client_info *client_obj = NULL;
+    struct listnode *node = NULL;
+
+    ALOGE("%s: %s failed for pid %d session_id %d, ret %d\n", __func__,
+          method, pid, session_id, ret);
+
+    pthread_mutex_lock(&client_list_lock);
+    list_for_each(node, &client_list) {
+        client_obj = node_to_item(node, client_info, list);
+        if (client_obj->pid == pid) {
+            clbk_bdr = client_obj->clbk_binder;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&client_list_lock);
+
+    /*clients built against @1.0 only get the log above*/
+    if (clbk_bdr != NULL)
+        clbk_bdr_1_1 = V1_1::IAGMCallback::castFrom(clbk_bdr);
+    if (clbk_bdr_1_1 != NULL)
+        clbk_bdr_1_1->error_callback(session_id, method, ret);
+}
+
+Return<void> AGM::ipc_agm_session_register_for_events_oneway(uint32_t session_id,
+                                  const hidl_vec<AgmEventRegCfg>& evt_reg_cfg,
+                                  uint32_t pid) {
+    int32_t ret = ipc_agm_session_register_for_events(session_id, evt_reg_cfg);
+
+    if (ret)
+        oneway_report_error(pid, session_id,
+                            "agm_session_register_for_events", ret);
+    return Void();
+}
+
+Return<void> AGM::ipc_agm_session_set_params_oneway(uint32_t session_id,
+                                  const hidl_vec<uint8_t>& payload,
+                                  uint32_t size, uint32_t pid) {
+    int32_t ret = ipc_agm_session_set_params(session_id, payload, size);
+
+    if (ret)
+        oneway_report_error(pid, session_id, "agm_session_set_params", ret);
+    return Void();
+}
+
+Return<void> AGM::ipc_agm_session_aif_set_params_oneway(uint32_t session_id,
+                                  uint32_t aif_id,
+                                  const hidl_vec<uint8_t>& payload,
+                                  uint32_t size, uint32_t pid) {
+    int32_t ret = ipc_agm_session_aif_set_params(session_id, aif_id, payload,
+                                                 size);
+
+    if (ret)
+        oneway_report_error(pid, session_id, "agm_session_aif_set_params",
+                            ret);
+    return Void();
+}
+
+Return<void> AGM::ipc_agm_set_params_with_tag_oneway(uint32_t session_id,
+                                  uint32_t aif_id,
+                                  const hidl_vec<AgmTagConfig>& tag_config,
+                                  uint32_t pid) {
+    int32_t ret = ipc_agm_set_params_with_tag(session_id, aif_id, tag_config);
+
+    if (ret)
+        oneway_report_error(pid, session_id, "agm_set_params_with_tag", ret);
+    return Void();
+}
+
+/*
+ *The shared memory path maps the client's region copy-on-write and hands
+ *it straight to AGM, so the payload is not copied again in the service.
+ */
+static void *map_params_shmem(const hidl_memory& payload, uint32_t size)
+{
+    const native_handle *handle = payload.handle();
+    void *addr;
+
+    if (!handle || handle->numFds < 1 || !size || payload.size() < size) {
+        ALOGE("%s: invalid params memory, size %u\n", __func__, size);
+        return NULL;
+    }
+
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                handle->data[0], 0);
+    if (addr == MAP_FAILED) {
+        ALOGE("%s: mmap failed errno %d\n", __func__, errno);
+        return NULL;
+    }
+    return addr;
+}
+
+Return<int32_t> AGM::ipc_agm_session_set_params_shmem(uint32_t session_id,
+                                  const hidl_memory& payload, uint32_t size) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_params_shmem");
+    ALOGV("%s : session_id = %d, size = %d\n", __func__, session_id, size);
+    void *payload_local = map_params_shmem(payload, size);
+    int32_t ret = 0;
+
+    if (payload_local == NULL)
+        return -EINVAL;
+
+    ret = agm_session_set_params(session_id, payload_local, (size_t) size);
+    munmap(payload_local, size);
+    return ret;
+}
+
+Return<int32_t> AGM::ipc_agm_session_aif_set_params_shmem(uint32_t session_id,
+                                  uint32_t aif_id,
+                                  const hidl_memory& payload, uint32_t size) {
+    AGM_TRACE_SCOPE("ipc_agm_session_aif_set_params_shmem");
+    ALOGV("%s : session_id = %d, aif_id = %d, size = %d\n", __func__,
+          session_id, aif_id, size);
+    void *payload_local = map_params_shmem(payload, size);
+    int32_t ret = 0;
+
+    if (payload_local == NULL)
+        return -EINVAL;
+
+    ret = agm_session_aif_set_params(session_id, aif_id, payload_local,
+                                     (size_t) size);
+    munmap(payload_local, size);
+    return ret;
+}
+
+Return<int32_t> AGM::ipc_agm_set_params_to_acdb_tunnel_shmem(
+                                  const hidl_memory& payload, uint32_t size) {
+    ALOGV("%s : size = %d\n", __func__, size);
+    void *payload_local = map_params_shmem(payload, size);
+    int32_t ret = 0;
+
+    if (payload_local == NULL)
+        return -EINVAL;
+
+    ret = agm_set_params_to_acdb_tunnel(payload_local, (size_t) size);
+    munmap(payload_local, size);
+    return ret;
+}
+
+Return<int32_t> AGM::ipc_agm_set_params_to_acdb_tunnel_batch(
+                                  const hidl_memory& payload, uint32_t size) {
+    ALOGV("%s : size = %d\n", __func__, size);
+    void *payload_local = map_params_shmem(payload, size);
+    int32_t ret = 0;
+
+    if (payload_local == NULL)
+        return -EINVAL;
+
+    ret = agm_set_params_to_acdb_tunnel_batch(payload_local, (size_t) size);
+    munmap(payload_local, size);
+    return ret;
+}
+
+Return<void> AGM::ipc_agm_params_batch(
+                                  const hidl_vec<AgmParamsBatchEntry>& entries,
+                                  ipc_agm_params_batch_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_params_batch");
+    uint32_t num_entries = (uint32_t) entries.size();
+    ALOGV("%s : num_entries = %d\n", __func__, num_entries);
+    struct agm_params_batch_entry *entries_local = NULL;
+    hidl_vec<AgmParamsBatchEntry> entries_ret = entries;
+    int32_t ret = 0;
+    uint32_t i = 0;
+
+    if (num_entries == 0) {
+        ret = -EINVAL;
+        goto done;
+    }
+
+    entries_local = (struct agm_params_batch_entry *)
+                    calloc(num_entries, sizeof(struct agm_params_batch_entry));
+    if (entries_local == NULL) {
+        ALOGE("%s: Cannot allocate memory for entries_local\n", __func__);
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    /*payloads point into entries_ret, get entries are filled in place*/
+    for (i = 0; i < num_entries; i++) {
+        entries_local[i].type = (enum agm_params_batch_type) entries[i].type;
+        entries_local[i].session_id = entries[i].session_id;
+        entries_local[i].aif_id = entries[i].aif_id;
+        entries_local[i].size = entries_ret[i].payload.size();
+        if (entries_local[i].size)
+            entries_local[i].payload = entries_ret[i].payload.data();
+    }
+    ret = agm_params_batch(entries_local, num_entries);
+
+done:
+    for (i = 0; i < num_entries; i++) {
+        entries_ret[i].status = entries_local ? entries_local[i].status : ret;
+        if (entries_ret[i].type != AgmParamsBatchType::SESSION_GET)
+            entries_ret[i].payload.resize(0);
+    }
+    free(entries_local);
+    _hidl_cb(ret, entries_ret);
+    return Void();
+}
+
+Return<int32_t> AGM::ipc_agm_session_async(AgmAsyncOp op, uint64_t hndl,
+                                  uint32_t session_id, uint32_t aif_id,
+                                  bool state, uint64_t cookie) {
+    AGM_TRACE_SCOPE("ipc_agm_session_async");
+    ALOGV("%s : op = %d, handle = %llx, session_id = %d, aif_id = %d\n",
+          __func__, (uint32_t) op, (unsigned long long) hndl, session_id,
+          aif_id);
+    int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
+
+    switch (op) {
+    case AgmAsyncOp::PREPARE:
+        return agm_session_prepare_async(hndl, cookie);
+    case AgmAsyncOp::START:
+        return agm_session_start_async(hndl, cookie);
+    case AgmAsyncOp::STOP:
+        return agm_session_stop_async(hndl, cookie);
+    case AgmAsyncOp::CLOSE:
+        remove_session_handle(pid, hndl);
+        return agm_session_close_async(hndl, cookie);
+    case AgmAsyncOp::AIF_CONNECT:
+        pthread_mutex_lock(&client_list_lock);
+        if (state)
+            add_session_aif_to_list_l(session_id, aif_id);
+        else
+            remove_session_aif_from_list_l(session_id, aif_id);
+        pthread_mutex_unlock(&client_list_lock);
+        return agm_session_aif_connect_async(session_id, aif_id, state,
+                                             cookie);
+    }
+    return -EINVAL;
+}
+
+static void media_config_from_hidl(struct agm_media_config *media_config,
+                                   const AgmMediaConfig& media_config_hidl)
+{
+    media_config->rate = media_config_hidl.rate;
+    media_config->channels = media_config_hidl.channels;
+    media_config->format = (enum agm_media_format) media_config_hidl.format;
+    media_config->data_format = media_config_hidl.data_format;
+}
+
+Return<void> AGM::ipc_agm_session_launch(const AgmSessionLaunchConfig& config,
+                                  ipc_agm_session_launch_cb _hidl_cb) {
+    AGM_TRACE_SCOPE("ipc_agm_session_launch");
+    struct agm_session_launch_config config_local;
+    struct agm_session_launch_aif *aif = NULL;
+    agm_client_session_handle *session_handle = NULL;
+    uint32_t num_aifs = (uint32_t) config.aifs.size();
+    uint64_t handle = 0;
+    int32_t ret = -EINVAL;
+    uint32_t i = 0;
+
+    ALOGV("%s: session_id=%d num_aifs=%d start=%d\n", __func__,
+          config.session_id, num_aifs, config.start);
+    memset(&config_local, 0, sizeof(config_local));
+    if (num_aifs) {
+        config_local.aifs = (struct agm_session_launch_aif *)
+                   calloc(num_aifs, sizeof(struct agm_session_launch_aif));
+        if (config_local.aifs == NULL) {
+            ALOGE("%s: Cannot allocate memory for aifs\n", __func__);
+            ret = -ENOMEM;
+            goto exit;
+        }
+    }
+
+    /*metadata is only read by AGM, it is passed in place*/
+    config_local.session_id = config.session_id;
+    config_local.sess_mode = (enum agm_session_mode) config.sess_mode;
+    config_local.metadata_size = (uint32_t) config.metadata.size();
+    config_local.metadata = (uint8_t *) config.metadata.data();
+    config_local.num_aifs = num_aifs;
+    for (i = 0; i < num_aifs; i++) {
+        aif = &config_local.aifs[i];
+        aif->aif_id = config.aifs[i].aif_id;
+        aif->set_media_config = config.aifs[i].set_media_config;
+        media_config_from_hidl(&aif->media_config,
+                               config.aifs[i].media_config);
+        aif->metadata_size = (uint32_t) config.aifs[i].metadata.size();
+        aif->metadata = (uint8_t *) config.aifs[i].metadata.data();
+    }
+    memcpy(&config_local.session_config, &config.session_config,
+           sizeof(struct agm_session_config));
+    media_config_from_hidl(&config_local.media_config, config.media_config);
+    config_local.buffer_config.count = config.buffer_config.count;
+    config_local.buffer_config.size = config.buffer_config.size;
+    config_local.start = config.start;
+
+    pthread_mutex_lock(&client_list_lock);
+    session_handle = get_session_handle_l(config.session_id);
+    pthread_mutex_unlock(&client_list_lock);
+    if (!session_handle)
+        goto exit;
+
+    pthread_mutex_lock(&session_handle->handle_lock);
+    ret = agm_session_launch(&config_local, &handle);
+    if (!ret)
+        add_session_handle_to_list_l(config.session_id, handle);
+    pthread_mutex_unlock(&session_handle->handle_lock);
+
+    /*connected aifs are disconnected if this client dies*/
+    if (!ret) {
+        pthread_mutex_lock(&client_list_lock);
+        for (i = 0; i < num_aifs; i++)
+            add_session_aif_to_list_l(config.session_id,
+                                      config.aifs[i].aif_id);
+        pthread_mutex_unlock(&client_list_lock);
+    }
+
+exit:
+    free(config_local.aifs);
+    _hidl_cb(ret, handle);
+    ALOGV("%s : handle received is : %llx", __func__,
+          (unsigned long long) handle);
+    return Void();
+}
+
+Return<int32_t> AGM::ipc_agm_session_set_standby(uint32_t session_id,
+                                                 bool enable) {
+    AGM_TRACE_SCOPE("ipc_agm_session_set_standby");
+    ALOGV("%s : session_id = %d, enable = %d\n", __func__, session_id,
+          enable);
+    return agm_session_set_standby(session_id, enable);
+}
+
 }  // namespace implementation
 }  // namespace V1_0
 }  // namespace AGMIPC
@@ -123,8 +123,16 @@ int agm_session_set_config(uint64_t handle,
     return -EAGAIN;
 }
 
+struct agm_log_config agm_log_cfg = AGM_LOG_CONFIG_INIT;
+
+void agm_log_config_update(void)
+{
+    agm_log_config_load(&agm_log_cfg);
+}
+
 int agm_init(){
      /*agm_init in IPC happens in context of the server*/
+      agm_log_config_update();
       return 0;
 }
 
@@ -232,6 +240,7 @@ int agm_session_open(uint32_t session_id,
                      enum agm_session_mode sess_mode,
                      uint64_t *handle)
 {
+    agm_log_config_update();
     if (!agm_server_died) {
         android::sp<IAgmService> agm_client = get_agm_server();
         return agm_client->ipc_agm_session_open(session_id, sess_mode, handle);
@@ -240,6 +249,96 @@ int agm_session_open(uint32_t session_id,
     return -EAGAIN;
 }
 
+int agm_session_launch(struct agm_session_launch_config *config,
+                       uint64_t *handle)
+{
+    agm_log_config_update();
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_launch(config, handle);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_params_batch(struct agm_params_batch_entry *entries,
+                     uint32_t num_entries)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_params_batch(entries, num_entries);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_set_standby(uint32_t session_id, bool enable)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_set_standby(session_id, enable);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_prepare_async(uint64_t handle, uint64_t cookie)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_async(AGM_ASYNC_OP_PREPARE, handle,
+                                                 0, 0, false, cookie);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_start_async(uint64_t handle, uint64_t cookie)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_async(AGM_ASYNC_OP_START, handle,
+                                                 0, 0, false, cookie);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_stop_async(uint64_t handle, uint64_t cookie)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_async(AGM_ASYNC_OP_STOP, handle,
+                                                 0, 0, false, cookie);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_close_async(uint64_t handle, uint64_t cookie)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_async(AGM_ASYNC_OP_CLOSE, handle,
+                                                 0, 0, false, cookie);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
+int agm_session_aif_connect_async(uint32_t session_id, uint32_t aif_id,
+                                  bool state, uint64_t cookie)
+{
+    if (!agm_server_died) {
+        android::sp<IAgmService> agm_client = get_agm_server();
+        return agm_client->ipc_agm_session_async(AGM_ASYNC_OP_AIF_CONNECT, 0,
+                                                 session_id, aif_id, state,
+                                                 cookie);
+    }
+    AGM_LOGE("%s: agm service is not running\n", __func__);
+    return -EAGAIN;
+}
+
 int  agm_session_aif_connect(uint32_t session_id, uint32_t audio_intf,
                                                            bool state)
 {
@@ -17,6 +17,11 @@ LOCAL_SHARED_LIBRARIES := \
 LOCAL_MODULE := libagmproxy
 LOCAL_MODULE_TAGS := optional
 
+ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_TRACE)), true)
+LOCAL_CFLAGS += -DAGM_TRACE_ENABLED
+LOCAL_SHARED_LIBRARIES += libagm
+endif
+
 include $(BUILD_SHARED_LIBRARY)
 include $(CLEAR_VARS)
 LOCAL_MODULE := agmserver
@@ -37,6 +37,7 @@
 #include <binder/IServiceManager.h>
 #include <binder/IPCThreadState.h>
 #include <cutils/list.h>
+#include <unordered_set>
 #include "utils.h"
 
 using namespace android;
@@ -75,23 +76,23 @@ class server_death_notifier : public IBinder::DeathRecipient
 class client_death_notifier : public IBinder::DeathRecipient
 {
     public:
-        client_death_notifier();
+        client_death_notifier(pid_t pid);
         // DeathRecipient
         virtual void binderDied(const android::wp<IBinder>& who);
+    private:
+        pid_t client_pid;
 };
 
+/*
+ * Registered clients are kept in a map keyed by pid, each with the set of
+ * session handles it opened, so that adding or removing a handle and
+ * closing them all on client death costs O(1) per handle.
+ */
 typedef struct {
-     struct listnode list;
-     uint64_t handle;
-     //bool rx;
- } agm_client_session_handle;
-
-typedef struct {
-    struct listnode list;
     sp<IAGMClient> binder;
     pid_t pid;
     sp<client_death_notifier> Client_death_notifier;
-    struct listnode agm_client_hndl_list;
+    std::unordered_set<uint64_t> agm_client_hndl_set;
 } client_info;
 
 client_info *get_client_handle_from_list(pid_t pid);
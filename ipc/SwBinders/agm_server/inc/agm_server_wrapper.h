@@ -63,6 +63,17 @@ class AgmService : public BnAgmService
         virtual int ipc_agm_session_open(uint32_t session_id,
                                          enum agm_session_mode sess_mode,
                                          uint64_t *handle);
+        virtual int ipc_agm_session_launch(
+                                    struct agm_session_launch_config *config,
+                                    uint64_t *handle);
+        virtual int ipc_agm_params_batch(
+                                    struct agm_params_batch_entry *entries,
+                                    uint32_t num_entries);
+        virtual int ipc_agm_session_async(uint32_t op, uint64_t handle,
+                                    uint32_t session_id, uint32_t aif_id,
+                                    bool state, uint64_t cookie);
+        virtual int ipc_agm_session_set_standby(uint32_t session_id,
+                                    bool enable);
         virtual int ipc_agm_session_read(uint64_t handle, void *buff,
                                      size_t *count);
         virtual int ipc_agm_session_write(uint64_t handle, void *buff,
@@ -77,6 +77,17 @@ class IAgmService: public ::android::IInterface
         virtual int ipc_agm_session_open(uint32_t session_id,
                                     enum agm_session_mode sess_mode,
                                     uint64_t *handle) = 0;
+        virtual int ipc_agm_session_launch(
+                                    struct agm_session_launch_config *config,
+                                    uint64_t *handle) = 0;
+        virtual int ipc_agm_params_batch(
+                                    struct agm_params_batch_entry *entries,
+                                    uint32_t num_entries) = 0;
+        virtual int ipc_agm_session_async(uint32_t op, uint64_t handle,
+                                    uint32_t session_id, uint32_t aif_id,
+                                    bool state, uint64_t cookie) = 0;
+        virtual int ipc_agm_session_set_standby(uint32_t session_id,
+                                    bool enable) = 0;
         virtual int ipc_agm_session_register_for_events(uint32_t session_id,
                                     struct agm_event_reg_cfg *evt_reg_cfg) = 0;
         virtual int ipc_agm_session_register_cb(uint32_t session_id,
@@ -42,6 +42,8 @@
 #include <pthread.h>
 #include <cutils/list.h>
 #include <signal.h>
+#include <new>
+#include <unordered_map>
 #include "ipc_interface.h"
 #include "agm_death_notifier.h"
 #include "utils.h"
@@ -54,35 +56,30 @@
 
 using namespace android;
 
-struct listnode g_client_list;
-pthread_mutex_t g_client_list_lock;
-bool g_client_list_init = false;
-//initialize mutex
+/*map of registered clients keyed by pid, see client_info*/
+static std::unordered_map<pid_t, client_info *> g_client_map;
+static pthread_mutex_t g_client_list_lock = PTHREAD_MUTEX_INITIALIZER;
 
-client_death_notifier::client_death_notifier(void)
+client_death_notifier::client_death_notifier(pid_t pid)
+    : client_pid(pid)
 {
     AGM_LOGV("%s:%d\n", __func__, __LINE__);
     sp<ProcessState> proc(ProcessState::self());
     proc->startThreadPool();
 }
-sp<client_death_notifier> Client_death_notifier = NULL;
 
 client_info *get_client_handle_from_list(pid_t pid)
 {
-    struct listnode *node = NULL;
     client_info *handle = NULL;
 
     pthread_mutex_lock(&g_client_list_lock);
-    list_for_each(node, &g_client_list) {
-        handle = node_to_item(node, client_info, list);
-        if (handle->pid == pid) {
-            AGM_LOGV("%s: Found handle %p\n", __func__, handle);
-            pthread_mutex_unlock(&g_client_list_lock);
-            return handle;
-        }
+    auto it = g_client_map.find(pid);
+    if (it != g_client_map.end()) {
+        handle = it->second;
+        AGM_LOGV("%s: Found handle %p\n", __func__, handle);
     }
     pthread_mutex_unlock(&g_client_list_lock);
-    return NULL;
+    return handle;
 }
 
 void agm_register_client(sp<IBinder> binder)
@@ -91,54 +88,49 @@ void agm_register_client(sp<IBinder> binder)
     pid_t pid = IPCThreadState::self()->getCallingPid();
     android::sp<IAGMClient> client_binder =
                                   android::interface_cast<IAGMClient>(binder);
-    Client_death_notifier = new client_death_notifier();
+    sp<client_death_notifier> Client_death_notifier =
+                                  new client_death_notifier(pid);
+
     IInterface::asBinder(client_binder)->linkToDeath(Client_death_notifier);
     AGM_LOGD("%s: Client registered and death notifier linked to AGM\n",
                                                               __func__);
-    if (g_client_list_init == false) {
-        pthread_mutex_init(&g_client_list_lock,
-                                           (const pthread_mutexattr_t *) NULL);
-        list_init(&g_client_list);
-        g_client_list_init = true;
-    }
-    client_handle = (client_info *)calloc(1, sizeof(client_info));
-    if (client_handle == NULL) {
-        AGM_LOGE("%s: Cannot allocate memory for client handle\n",
-                                                        __func__);
-        return;
-    }
+
     pthread_mutex_lock(&g_client_list_lock);
+    auto it = g_client_map.find(pid);
+    if (it != g_client_map.end()) {
+        /*same process registering again keeps the handles it opened*/
+        client_handle = it->second;
+        if (client_handle->Client_death_notifier != NULL)
+            IInterface::asBinder(client_handle->binder)->unlinkToDeath(
+                                        client_handle->Client_death_notifier);
+    } else {
+        client_handle = new (std::nothrow) client_info();
+        if (client_handle == NULL) {
+            AGM_LOGE("%s: Cannot allocate memory for client handle\n",
+                                                            __func__);
+            goto exit;
+        }
+        client_handle->pid = pid;
+        g_client_map[pid] = client_handle;
+    }
     client_handle->binder = client_binder;
-    client_handle->pid = pid;
     client_handle->Client_death_notifier = Client_death_notifier;
-    list_add_tail(&g_client_list, &client_handle->list);
-    list_init(&client_handle->agm_client_hndl_list);
+
+exit:
     pthread_mutex_unlock(&g_client_list_lock);
-    
 }
 
 void agm_add_session_obj_handle(uint64_t handle)
 {
-    client_info *client_handle = NULL;
-    agm_client_session_handle *hndl = NULL;
-
-    client_handle =
-          get_client_handle_from_list(IPCThreadState::self()->getCallingPid());
-    if (client_handle == NULL) {
-        AGM_LOGE("%s: Could not find client handle\n", __func__);
-        goto exit;
-    }
+    pid_t pid = IPCThreadState::self()->getCallingPid();
 
     pthread_mutex_lock(&g_client_list_lock);
-    hndl = (agm_client_session_handle *)calloc(1,
-                                            sizeof(agm_client_session_handle));
-    if (hndl == NULL) {
-        AGM_LOGE("%s: Cannot allocate memory to store agm session handle\n",
-                                                                  __func__);
+    auto it = g_client_map.find(pid);
+    if (it == g_client_map.end()) {
+        AGM_LOGE("%s: Could not find client handle\n", __func__);
         goto exit;
     }
-    hndl->handle = handle;
-    list_add_tail(&client_handle->agm_client_hndl_list, &hndl->list);
+    it->second->agm_client_hndl_set.insert(handle);
 
 exit:
     pthread_mutex_unlock(&g_client_list_lock);
@@ -146,28 +138,19 @@ exit:
 
 void agm_remove_session_obj_handle(uint64_t handle)
 {
-    client_info *client_handle = NULL;
-    struct listnode *node = NULL;
-    agm_client_session_handle *hndl = NULL;
-    struct listnode *tempnode = NULL;
+    pid_t pid = IPCThreadState::self()->getCallingPid();
 
-    client_handle =
-          get_client_handle_from_list(IPCThreadState::self()->getCallingPid());
-    if (client_handle == NULL) {
+    pthread_mutex_lock(&g_client_list_lock);
+    auto it = g_client_map.find(pid);
+    if (it == g_client_map.end()) {
         AGM_LOGE("%s: Could not find client handle\n", __func__);
-        return;
+        goto exit;
     }
+    if (it->second->agm_client_hndl_set.erase(handle))
+        AGM_LOGV("%s: Removed handle 0x%llx\n", __func__,
+                 (unsigned long long)handle);
 
-    pthread_mutex_lock(&g_client_list_lock);
-    list_for_each_safe(node, tempnode, &client_handle->agm_client_hndl_list) {
-        hndl = node_to_item(node, agm_client_session_handle, list);
-        if (hndl->handle == handle) {
-            AGM_LOGV("%s: Removed handle 0x%llx\n", __func__, handle);
-            list_remove(node);
-            free(hndl);
-            break;
-        }
-    }
+exit:
     pthread_mutex_unlock(&g_client_list_lock);
 }
 
@@ -176,22 +159,19 @@ void agm_unregister_client(sp<IBinder> binder)
     android::sp<IAGMClient> client_binder =
                                    android::interface_cast<IAGMClient>(binder);
     client_info *handle = NULL;
-    struct listnode *tempnode = NULL;
-    struct listnode *node = NULL;
 
     AGM_LOGV("%s: enter\n", __func__);
     pthread_mutex_lock(&g_client_list_lock);
-    list_for_each_safe(node, tempnode, &g_client_list) {
-        handle = node_to_item(node, client_info, list);
-        if (handle->pid == IPCThreadState::self()->getCallingPid()) {
-            if (handle->Client_death_notifier != NULL) {
-                IInterface::asBinder(client_binder)->unlinkToDeath(handle->Client_death_notifier);
-                handle->Client_death_notifier.clear();
-                AGM_LOGV("%s: unlink to death %d\n", __func__, handle->pid);
-            }
-            list_remove(node);
-            free(handle);
+    auto it = g_client_map.find(IPCThreadState::self()->getCallingPid());
+    if (it != g_client_map.end()) {
+        handle = it->second;
+        if (handle->Client_death_notifier != NULL) {
+            IInterface::asBinder(client_binder)->unlinkToDeath(handle->Client_death_notifier);
+            handle->Client_death_notifier.clear();
+            AGM_LOGV("%s: unlink to death %d\n", __func__, handle->pid);
         }
+        g_client_map.erase(it);
+        delete handle;
     }
     AGM_LOGV("%s: exit\n", __func__);
     pthread_mutex_unlock(&g_client_list_lock);
@@ -200,30 +180,24 @@ void agm_unregister_client(sp<IBinder> binder)
 void client_death_notifier::binderDied(const wp<IBinder>& who)
 {
     client_info *handle = NULL;
-    struct listnode *node = NULL;
-    struct listnode *tempnode = NULL;
-    agm_client_session_handle *hndl = NULL;
-    struct listnode *sess_node = NULL;
-    struct listnode *sess_tempnode = NULL;
 
     pthread_mutex_lock(&g_client_list_lock);
-    list_for_each_safe(node, tempnode, &g_client_list) {
-        handle = node_to_item(node, client_info, list);
-        if (IInterface::asBinder(handle->binder).get() == who.unsafe_get()) {
-            list_for_each_safe(sess_node, sess_tempnode,
-                                             &handle->agm_client_hndl_list) {
-                hndl = node_to_item(sess_node, agm_client_session_handle, list);
-                   if (hndl->handle) {
-                       agm_session_close(hndl->handle);
-                       list_remove(sess_node);
-                       free(hndl);
-                   }
-                }
-                list_remove(node);
-                free(handle);
-        }
+    auto it = g_client_map.find(client_pid);
+    if (it != g_client_map.end() &&
+        IInterface::asBinder(it->second->binder).get() == who.unsafe_get()) {
+        handle = it->second;
+        g_client_map.erase(it);
     }
     pthread_mutex_unlock(&g_client_list_lock);
+
+    /*client is no longer reachable, close its sessions without the lock*/
+    if (handle) {
+        for (uint64_t hndl : handle->agm_client_hndl_set) {
+            if (hndl)
+                agm_session_close(hndl);
+        }
+        delete handle;
+    }
     AGM_LOGD("%s: exit\n", __func__);
 }
 
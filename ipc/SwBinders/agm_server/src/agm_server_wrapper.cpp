@@ -201,6 +201,46 @@ int AgmService::ipc_agm_session_open(uint32_t session_id,
     return agm_session_open(session_id, sess_mode, handle);
 };
 
+int AgmService::ipc_agm_session_launch(
+                            struct agm_session_launch_config *config,
+                            uint64_t *handle){
+    AGM_LOGV("%s called\n", __func__);
+    return agm_session_launch(config, handle);
+};
+
+int AgmService::ipc_agm_params_batch(
+                            struct agm_params_batch_entry *entries,
+                            uint32_t num_entries){
+    AGM_LOGV("%s called\n", __func__);
+    return agm_params_batch(entries, num_entries);
+};
+
+int AgmService::ipc_agm_session_async(uint32_t op, uint64_t handle,
+                                      uint32_t session_id, uint32_t aif_id,
+                                      bool state, uint64_t cookie){
+    AGM_LOGV("%s called\n", __func__);
+    switch (op) {
+    case AGM_ASYNC_OP_PREPARE:
+        return agm_session_prepare_async(handle, cookie);
+    case AGM_ASYNC_OP_START:
+        return agm_session_start_async(handle, cookie);
+    case AGM_ASYNC_OP_STOP:
+        return agm_session_stop_async(handle, cookie);
+    case AGM_ASYNC_OP_CLOSE:
+        return agm_session_close_async(handle, cookie);
+    case AGM_ASYNC_OP_AIF_CONNECT:
+        return agm_session_aif_connect_async(session_id, aif_id, state,
+                                             cookie);
+    default:
+        return -EINVAL;
+    }
+};
+
+int AgmService::ipc_agm_session_set_standby(uint32_t session_id, bool enable){
+    AGM_LOGV("%s called\n", __func__);
+    return agm_session_set_standby(session_id, enable);
+};
+
 int AgmService::ipc_agm_session_set_config(uint64_t handle,
                         struct agm_session_config *session_config,
                         struct agm_media_config *media_config,
@@ -52,6 +52,7 @@
 #include "ipc_interface.h"
 #include "agm_death_notifier.h"
 #include <agm/agm_api.h>
+#include <agm/agm_trace.h>
 #include "agm_server_wrapper.h"
 #include "agm_callback.h"
 #include "utils.h"
@@ -116,6 +117,10 @@ enum {
     AIF_SET_PARAMS,
     SET_GAPLESS_SESSION_METADATA,
     GET_BUF_INFO,
+    LAUNCH,
+    PARAMS_BATCH,
+    SESSION_ASYNC,
+    SET_STANDBY,
 };
 
 class BpAgmService : public ::android::BpInterface<IAgmService>
@@ -299,6 +304,110 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
             return reply.readInt32();
         }
 
+        virtual int ipc_agm_session_launch(
+                            struct agm_session_launch_config *config,
+                            uint64_t *handle)
+        {
+            android::Parcel data, reply;
+            struct agm_session_launch_aif *aif = NULL;
+
+            AGM_LOGV("%s:%d\n", __func__, __LINE__);
+            data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+            data.writeUint32(config->session_id);
+            data.writeUint32(config->sess_mode);
+            data.write(&config->start, sizeof(bool));
+            data.write(&config->session_config, sizeof(agm_session_config));
+            data.write(&config->media_config, sizeof(agm_media_config));
+            data.write(&config->buffer_config, sizeof(agm_buffer_config));
+            data.writeUint32(config->metadata_size);
+            if (config->metadata_size)
+                data.write(config->metadata, config->metadata_size);
+            data.writeUint32(config->num_aifs);
+            for (uint32_t i = 0; i < config->num_aifs; i++) {
+                aif = &config->aifs[i];
+                data.writeUint32(aif->aif_id);
+                data.write(&aif->set_media_config, sizeof(bool));
+                data.write(&aif->media_config, sizeof(agm_media_config));
+                data.writeUint32(aif->metadata_size);
+                if (aif->metadata_size)
+                    data.write(aif->metadata, aif->metadata_size);
+            }
+            remote()->transact(LAUNCH, data, &reply);
+            *handle = (uint64_t)reply.readInt64();
+            return reply.readInt32();
+        }
+
+        virtual int ipc_agm_params_batch(
+                            struct agm_params_batch_entry *entries,
+                            uint32_t num_entries)
+        {
+            android::Parcel data, reply;
+            struct agm_params_batch_entry *entry = NULL;
+            uint32_t i;
+            int rc = 0;
+
+            AGM_LOGV("%s:%d\n", __func__, __LINE__);
+            data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+            data.writeUint32(num_entries);
+            for (i = 0; i < num_entries; i++) {
+                entry = &entries[i];
+                data.writeUint32(entry->type);
+                data.writeUint32(entry->session_id);
+                data.writeUint32(entry->aif_id);
+                data.writeUint32((uint32_t)entry->size);
+                if (entry->size)
+                    data.write(entry->payload, entry->size);
+            }
+            remote()->transact(PARAMS_BATCH, data, &reply);
+            if (reply.readUint32() != num_entries) {
+                rc = reply.readInt32();
+                if (!rc)
+                    rc = -EIO;
+                for (i = 0; i < num_entries; i++)
+                    entries[i].status = rc;
+                return rc;
+            }
+            for (i = 0; i < num_entries; i++) {
+                entry = &entries[i];
+                entry->status = reply.readInt32();
+                if (entry->type == AGM_PARAMS_BATCH_SESSION_GET && entry->size)
+                    reply.read(entry->payload, entry->size);
+            }
+            return reply.readInt32();
+        }
+
+        virtual int ipc_agm_session_async(uint32_t op, uint64_t handle,
+                                          uint32_t session_id,
+                                          uint32_t aif_id, bool state,
+                                          uint64_t cookie)
+        {
+            android::Parcel data, reply;
+
+            AGM_LOGV("%s:%d\n", __func__, __LINE__);
+            data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+            data.writeUint32(op);
+            data.writeInt64((long)handle);
+            data.writeUint32(session_id);
+            data.writeUint32(aif_id);
+            data.write(&state, sizeof(bool));
+            data.writeUint64(cookie);
+            remote()->transact(SESSION_ASYNC, data, &reply);
+            return reply.readInt32();
+        }
+
+        virtual int ipc_agm_session_set_standby(uint32_t session_id,
+                                                bool enable)
+        {
+            android::Parcel data, reply;
+
+            AGM_LOGV("%s:%d\n", __func__, __LINE__);
+            data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+            data.writeUint32(session_id);
+            data.write(&enable, sizeof(bool));
+            remote()->transact(SET_STANDBY, data, &reply);
+            return reply.readInt32();
+        }
+
         virtual int ipc_agm_session_close(uint64_t handle)
         {
             android::Parcel data, reply;
@@ -742,6 +851,7 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
 void ipc_cb (uint32_t session_id, struct agm_event_cb_params *event_params,
                                                          void *client_data)
 {
+    AGM_TRACE_SCOPE("ipc_callback");
     struct listnode *node = NULL;
     clbk_data *handle = NULL;
 
@@ -793,6 +903,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
    case OPEN : {
+        AGM_TRACE_SCOPE("ipc_agm_session_open");
         uint32_t session_id;
         enum agm_session_mode sess_mode;
         uint64_t handle = 0;
@@ -804,6 +915,164 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         reply->writeInt32(rc);
         break; }
 
+    case LAUNCH : {
+        AGM_TRACE_SCOPE("ipc_agm_session_launch");
+        struct agm_session_launch_config config;
+        struct agm_session_launch_aif *aif = NULL;
+        uint64_t handle = 0;
+        uint32_t i = 0;
+
+        memset(&config, 0, sizeof(config));
+        config.session_id = data.readUint32();
+        config.sess_mode = (enum agm_session_mode)data.readUint32();
+        data.read(&config.start, sizeof(bool));
+        data.read(&config.session_config, sizeof(agm_session_config));
+        data.read(&config.media_config, sizeof(agm_media_config));
+        data.read(&config.buffer_config, sizeof(agm_buffer_config));
+        config.metadata_size = data.readUint32();
+        if (config.metadata_size) {
+            config.metadata = (uint8_t *)calloc(1, config.metadata_size);
+            if (!config.metadata) {
+                AGM_LOGE("calloc failed\n");
+                rc = -ENOMEM;
+                goto fail_launch;
+            }
+            data.read(config.metadata, config.metadata_size);
+        }
+        config.num_aifs = data.readUint32();
+        if (config.num_aifs) {
+            config.aifs = (struct agm_session_launch_aif *)
+                   calloc(config.num_aifs, sizeof(struct agm_session_launch_aif));
+            if (!config.aifs) {
+                AGM_LOGE("calloc failed\n");
+                rc = -ENOMEM;
+                goto fail_launch;
+            }
+        }
+        for (i = 0; i < config.num_aifs; i++) {
+            aif = &config.aifs[i];
+            aif->aif_id = data.readUint32();
+            data.read(&aif->set_media_config, sizeof(bool));
+            data.read(&aif->media_config, sizeof(agm_media_config));
+            aif->metadata_size = data.readUint32();
+            if (aif->metadata_size) {
+                aif->metadata = (uint8_t *)calloc(1, aif->metadata_size);
+                if (!aif->metadata) {
+                    AGM_LOGE("calloc failed\n");
+                    rc = -ENOMEM;
+                    goto fail_launch;
+                }
+                data.read(aif->metadata, aif->metadata_size);
+            }
+        }
+        rc = ipc_agm_session_launch(&config, &handle);
+        if (handle != 0)
+            agm_add_session_obj_handle(handle);
+    fail_launch:
+        if (config.aifs) {
+            for (i = 0; i < config.num_aifs; i++)
+                free(config.aifs[i].metadata);
+            free(config.aifs);
+        }
+        free(config.metadata);
+        reply->writeInt64((long)handle);
+        reply->writeInt32(rc);
+        break; }
+
+    case PARAMS_BATCH : {
+        AGM_TRACE_SCOPE("ipc_agm_session_params_batch");
+        struct agm_params_batch_entry *entries = NULL;
+        struct agm_params_batch_entry *entry = NULL;
+        uint32_t num_entries = 0;
+        uint32_t i = 0;
+        void *slot = NULL;
+
+        num_entries = data.readUint32();
+        entries = (struct agm_params_batch_entry *)
+                calloc(num_entries, sizeof(struct agm_params_batch_entry));
+        if (!entries) {
+            AGM_LOGE("calloc failed\n");
+            /* no per entry replies, client fails the whole batch */
+            reply->writeUint32(0);
+            reply->writeInt32(-ENOMEM);
+            break;
+        }
+        rc = 0;
+        for (i = 0; i < num_entries; i++) {
+            entry = &entries[i];
+            entry->type = (enum agm_params_batch_type)data.readUint32();
+            entry->session_id = data.readUint32();
+            entry->aif_id = data.readUint32();
+            entry->size = (size_t)data.readUint32();
+            if (!entry->size)
+                continue;
+            if (!rc)
+                entry->payload = calloc(1, entry->size);
+            if (!entry->payload) {
+                /* keep parsing so the reply still matches the request */
+                AGM_LOGE("calloc failed\n");
+                rc = -ENOMEM;
+                data.readInplace(entry->size);
+                continue;
+            }
+            data.read(entry->payload, entry->size);
+        }
+        if (rc) {
+            for (i = 0; i < num_entries; i++)
+                entries[i].status = rc;
+        } else {
+            rc = ipc_agm_params_batch(entries, num_entries);
+        }
+
+        reply->writeUint32(num_entries);
+        for (i = 0; i < num_entries; i++) {
+            entry = &entries[i];
+            reply->writeInt32(entry->status);
+            if (entry->type == AGM_PARAMS_BATCH_SESSION_GET && entry->size) {
+                if (entry->payload) {
+                    reply->write(entry->payload, entry->size);
+                } else {
+                    slot = reply->writeInplace(entry->size);
+                    if (slot)
+                        memset(slot, 0, entry->size);
+                }
+            }
+            free(entry->payload);
+        }
+        free(entries);
+        reply->writeInt32(rc);
+        break; }
+
+    case SESSION_ASYNC : {
+        AGM_TRACE_SCOPE("ipc_agm_session_async");
+        uint32_t op, session_id, aif_id;
+        uint64_t handle, cookie;
+        bool state;
+
+        op = data.readUint32();
+        handle = (uint64_t)data.readInt64();
+        session_id = data.readUint32();
+        aif_id = data.readUint32();
+        data.read(&state, sizeof(bool));
+        cookie = data.readUint64();
+        rc = ipc_agm_session_async(op, handle, session_id, aif_id, state,
+                                   cookie);
+        if (op == AGM_ASYNC_OP_CLOSE)
+            agm_remove_session_obj_handle(handle);
+        reply->writeInt32(rc);
+        break; }
+
+    case SET_STANDBY : {
+        AGM_TRACE_SCOPE("ipc_agm_session_set_standby");
+        uint32_t session_id;
+        bool enable;
+
+        session_id = data.readUint32();
+        data.read(&enable, sizeof(bool));
+        rc = ipc_agm_session_set_standby(session_id, enable);
+        reply->writeInt32(rc);
+        break; }
+
     case SESSION_SET_META : {
         uint32_t session_id = 0;
         size_t count = 0;
@@ -901,6 +1170,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
     }
 
     case LOOPBACK : {
+        AGM_TRACE_SCOPE("ipc_agm_session_set_loopback");
         uint32_t capture_session_id;
         uint32_t playback_session_id;
         capture_session_id = data.readUint32();
@@ -912,6 +1182,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case CLOSE : {
+        AGM_TRACE_SCOPE("ipc_agm_session_close");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_close(handle);
         agm_remove_session_obj_handle(handle);
@@ -919,36 +1190,42 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case PREPARE : {
+        AGM_TRACE_SCOPE("ipc_agm_session_prepare");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_prepare(handle);
         reply->writeInt32(rc);
         break; }
 
     case START : {
+        AGM_TRACE_SCOPE("ipc_agm_session_start");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_start(handle);
         reply->writeInt32(rc);
         break; }
 
     case STOP : {
+        AGM_TRACE_SCOPE("ipc_agm_session_stop");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_stop(handle);
         reply->writeInt32(rc);
         break; }
 
     case PAUSE : {
+        AGM_TRACE_SCOPE("ipc_agm_session_pause");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_pause(handle);
         reply->writeInt32(rc);
         break; }
 
     case RESUME : {
+        AGM_TRACE_SCOPE("ipc_agm_session_resume");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_resume(handle);
         reply->writeInt32(rc);
         break; }
 
     case CONNECT : {
+        AGM_TRACE_SCOPE("ipc_agm_session_aif_connect");
         uint32_t session_id;
         uint32_t audio_intf;
 
@@ -976,6 +1253,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case SESSION_SET_CONFIG : {
+        AGM_TRACE_SCOPE("ipc_agm_session_set_config");
         uint64_t handle = (uint64_t )data.readInt64();
         struct agm_session_config session_config;
         struct agm_media_config media_config;
@@ -1008,6 +1286,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case READ : {
+        AGM_TRACE_SCOPE("ipc_agm_session_read");
         int32_t rc;
         size_t byte_count;
         uint64_t handle;
@@ -1041,6 +1320,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
        break; }
 
     case WRITE: {
+        AGM_TRACE_SCOPE("ipc_agm_session_write");
         uint32_t rc;
         size_t byte_count;
         void *buf;
@@ -1206,6 +1486,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case SESSION_AIF_SET_PARAMS: {
+        AGM_TRACE_SCOPE("ipc_agm_session_aif_set_params");
         uint32_t rc, pcm_idx, be_idx;
         size_t count = 0;
         android::Parcel::ReadableBlob blob;
@@ -1255,6 +1536,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case SESSION_SET_PARAMS: {
+        AGM_TRACE_SCOPE("ipc_agm_session_set_params");
         uint32_t rc, pcm_idx;
         size_t count = 0;
         void *bn_payload;
@@ -1309,6 +1591,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case SET_ECREF :     {
+        AGM_TRACE_SCOPE("ipc_agm_session_set_ec_ref");
         uint32_t cap_sess_id;
         uint32_t aif_id;
 
@@ -1349,6 +1632,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case EOS : {
+        AGM_TRACE_SCOPE("ipc_agm_session_eos");
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_eos(handle);
         reply->writeInt32(rc);
@@ -1363,6 +1647,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         break; }
 
     case GET_PARAMS: {
+        AGM_TRACE_SCOPE("ipc_agm_session_get_params");
         uint32_t rc, pcm_idx;
         size_t count = 0;
         void *bn_payload;
@@ -28,6 +28,7 @@
 **/
 
 #define LOG_TAG "PLUGIN: AGMCTL"
+#define AGM_LOG_MODULE AGM_LOG_MOD_PLUGIN
 
 #include <alsa/asoundlib.h>
 #include <alsa/control_external.h>
@@ -94,6 +95,7 @@ static const struct agm_ctl_attribute_info {
     [AGM_FE_CTL_NAME_SET_CALIBRATION] = {SND_CTL_ELEM_TYPE_BYTES, SND_CTL_EXT_ACCESS_TLV_READWRITE |
                                          SND_CTL_EXT_ACCESS_TLV_CALLBACK, 512},
     [AGM_FE_CTL_NAME_GET_PARAM] = {SND_CTL_ELEM_TYPE_BYTES, SND_CTL_EXT_ACCESS_TLV_READWRITE |
+                                   SND_CTL_EXT_ACCESS_TLV_COMMAND |
                                    SND_CTL_EXT_ACCESS_TLV_CALLBACK, 128 * 1024},
     [AGM_FE_CTL_NAME_BUF_INFO] = {SND_CTL_ELEM_TYPE_BYTES, SND_CTL_EXT_ACCESS_TLV_READWRITE |
                                   SND_CTL_EXT_ACCESS_TLV_CALLBACK, 512},
@@ -381,6 +383,31 @@ static int agmctl_pcm_get_param_get(struct agm_mixer_controls *control,
     return ret;
 }
 
+/*
+ * TLV command: the query is read from and the result written back to the
+ * same buffer, replacing the put()/get() pair with one transaction.
+ */
+static int agmctl_pcm_get_param_cmd(struct agm_mixer_controls *control,
+                                   unsigned char *data, size_t len)
+{
+    int pcm_idx = control->pcm_be_id;
+    int ret = 0;
+
+    if (len < sizeof(uint32_t)) {
+        AGM_LOGE("%s: invalid getParam size %zu\n", __func__, len);
+        return -EINVAL;
+    }
+
+    ret = agm_session_get_params(pcm_idx, data, len);
+    if (ret == -EALREADY)
+        ret = 0;
+
+    if (ret)
+        AGM_LOGE("%s: failed err %d for %d\n", __func__, ret, pcm_idx);
+
+    return ret;
+}
+
 static int agmctl_pcm_get_param_put(struct agm_mixer_controls *control,
                                    unsigned char *data, size_t len)
 {
@@ -1220,6 +1247,41 @@ static int agmctl_write_bytes(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
     return rc;
 }
 
+static int agmctl_cmd_bytes(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+                            unsigned char *tlv, size_t tlv_size)
+{
+    struct agmctl_priv *agmctl = ext->private_data;
+    int rc = 0;
+    unsigned char *data;
+    uint32_t len32;
+    size_t len;
+
+    if (key >= agmctl->total_ctl_cnt)
+        return -EINVAL;
+
+    if (tlv_size < 2 * sizeof(unsigned int))
+        return -EINVAL;
+
+    memcpy(&len32, tlv + sizeof(unsigned int), sizeof(len32));
+    len = (size_t)len32;
+    if (len > tlv_size - 2 * sizeof(unsigned int)) {
+        AGM_LOGE("Invalid length %zu, tlv size %zu\n", len, tlv_size);
+        return -EINVAL;
+    }
+    data = (unsigned char *)(tlv + 2 * sizeof(unsigned int));
+
+    switch (agmctl->controls[key].ctl_id) {
+    case AGM_FE_CTL_NAME_GET_PARAM:
+        rc = agmctl_pcm_get_param_cmd(&agmctl->controls[key], data, len);
+        break;
+    default:
+        rc = -EINVAL;
+        AGM_LOGE("Unsupported control %d\n", agmctl->controls[key].ctl_id);
+        break;
+    }
+    return rc;
+}
+
 int agm_ext_tlv_callback(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
                          int op_flag, unsigned int numid __unused,
                          unsigned int *tlv, unsigned int tlv_size)
@@ -1233,6 +1295,8 @@ int agm_ext_tlv_callback(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
         return agmctl_read_bytes(ext, key, (unsigned char *)tlv, (size_t)tlv_size);
     else if (op_flag == 1)
         return agmctl_write_bytes(ext, key, (unsigned char *)tlv, (size_t)tlv_size);
+    else if (op_flag == -1)
+        return agmctl_cmd_bytes(ext, key, (unsigned char *)tlv, (size_t)tlv_size);
     else
         return -EINVAL;
 }
@@ -27,8 +27,13 @@
 ** IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
 #define LOG_TAG "PLUGIN: AGMIO"
+#define AGM_LOG_MODULE AGM_LOG_MOD_PLUGIN
 #include <stdio.h>
+#include <pthread.h>
 #include <sys/poll.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include <sys/eventfd.h>
 #include <alsa/asoundlib.h>
@@ -40,6 +45,18 @@
 #include "utils.h"
 
 #define ARRAY_SIZE(a)   (sizeof(a)/sizeof(a[0]))
+#define AGM_IO_MAX_PERIODS 8
+
+/* retries for a consistent read of the DSP position buffer */
+#define AGM_IO_POS_RETRY_COUNT 5
+
+/* layout of the position buffer the DSP updates in push pull mode */
+struct agm_io_shared_pos_buffer {
+    volatile uint32_t frame_counter;
+    volatile uint32_t read_index;
+    volatile uint32_t wall_clock_us_lsw;
+    volatile uint32_t wall_clock_us_msw;
+};
 
 enum {
     AGM_IO_STATE_OPEN = 1,
@@ -66,6 +83,28 @@ struct agmio_priv {
     snd_pcm_uframes_t hw_pointer;
     snd_pcm_uframes_t boundary;
     int event_fd;
+    /*
+     * data path state, updated from write/read done events, protected
+     * by lock. hw_pointer only moves when the DSP reports a buffer done.
+     */
+    pthread_mutex_t lock;
+    snd_pcm_uframes_t avail;
+    /* frames of each buffer written to the DSP and not yet done */
+    snd_pcm_uframes_t pending[AGM_IO_MAX_PERIODS];
+    unsigned int pending_head;
+    unsigned int pending_count;
+    bool event_signaled;
+    /*
+     * mmap mode, the DSP reads and writes a shared circular buffer
+     * directly (push pull), position comes from the shared pos buffer
+     * and poll is paced by timer_fd at the period rate.
+     */
+    bool mmap;
+    struct agm_buf_info buf_info;
+    void *data_buf;
+    void *pos_buf;
+    snd_pcm_uframes_t mmap_appl;
+    int timer_fd;
 /* add private variables here */
 };
 
@@ -82,6 +121,207 @@ static int agm_get_session_handle(struct agmio_priv *priv,
     return 0;
 }
 
+/*
+ * Keeps event_fd readable for as long as there is room to write or data
+ * to read, so that poll behaves level triggered. Called with lock held.
+ */
+static void agm_io_update_event_l(struct agmio_priv *pcm)
+{
+    eventfd_t val;
+
+    if (pcm->avail > 0 && !pcm->event_signaled) {
+        eventfd_write(pcm->event_fd, 1);
+        pcm->event_signaled = true;
+    } else if (pcm->avail == 0 && pcm->event_signaled) {
+        eventfd_read(pcm->event_fd, &val);
+        pcm->event_signaled = false;
+    }
+}
+
+static void agm_io_reset_l(struct agmio_priv *pcm)
+{
+    snd_pcm_ioplug_t *io = &pcm->io;
+
+    pcm->pending_head = 0;
+    pcm->pending_count = 0;
+    /*
+     * Reads are only queued to the DSP from transfer, so capture has to
+     * start out readable with a period on the pointer, otherwise the first
+     * non-blocking read never happens and no read done ever arrives.
+     * avail follows the pointer so poll does not spin ahead of it.
+     */
+    if (io->stream == SND_PCM_STREAM_PLAYBACK) {
+        pcm->avail = io->buffer_size;
+        pcm->hw_pointer = 0;
+    } else {
+        pcm->avail = io->period_size;
+        pcm->hw_pointer = io->period_size;
+    }
+    agm_io_update_event_l(pcm);
+}
+
+static void agm_io_event_cb(uint32_t session_id __unused,
+                            struct agm_event_cb_params *event_params,
+                            void *client_data)
+{
+    struct agmio_priv *pcm = client_data;
+    snd_pcm_ioplug_t *io;
+    snd_pcm_uframes_t frames = 0;
+
+    if (!pcm || !event_params) {
+        AGM_LOGE("%s: invalid event\n", __func__);
+        return;
+    }
+    io = &pcm->io;
+
+    pthread_mutex_lock(&pcm->lock);
+    if (event_params->event_id == AGM_EVENT_WRITE_DONE) {
+        if (pcm->pending_count == 0) {
+            AGM_LOGE("%s: write done without a pending buffer\n", __func__);
+            goto done;
+        }
+        frames = pcm->pending[pcm->pending_head];
+        pcm->pending_head = (pcm->pending_head + 1) % AGM_IO_MAX_PERIODS;
+        pcm->pending_count--;
+        pcm->avail += frames;
+    } else if (event_params->event_id == AGM_EVENT_READ_DONE) {
+        frames = pcm->period_size;
+        pcm->avail += frames;
+        if (pcm->avail > io->buffer_size)
+            pcm->avail = io->buffer_size;
+    } else {
+        goto done;
+    }
+
+    if (io->buffer_size)
+        pcm->hw_pointer = (pcm->hw_pointer + frames) % io->buffer_size;
+    agm_io_update_event_l(pcm);
+done:
+    pthread_mutex_unlock(&pcm->lock);
+}
+
+static void agm_io_mmap_release(struct agmio_priv *pcm)
+{
+    if (pcm->data_buf) {
+        munmap(pcm->data_buf, pcm->buf_info.data_buf_size);
+        pcm->data_buf = NULL;
+    }
+    if (pcm->pos_buf) {
+        munmap(pcm->pos_buf, pcm->buf_info.pos_buf_size);
+        pcm->pos_buf = NULL;
+    }
+    if (pcm->buf_info.data_buf_fd > 0)
+        close(pcm->buf_info.data_buf_fd);
+    if (pcm->buf_info.pos_buf_fd > 0)
+        close(pcm->buf_info.pos_buf_fd);
+    memset(&pcm->buf_info, 0, sizeof(pcm->buf_info));
+}
+
+static int agm_io_mmap_setup(struct agmio_priv *pcm)
+{
+    snd_pcm_ioplug_t *io = &pcm->io;
+    int ret;
+
+    agm_io_mmap_release(pcm);
+
+    ret = agm_session_get_buf_info(pcm->device, &pcm->buf_info,
+                                   DATA_BUF | POS_BUF);
+    if (ret) {
+        AGM_LOGE("%s: failed to get shared buffers %d\n", __func__, ret);
+        return ret;
+    }
+
+    if ((snd_pcm_uframes_t)pcm->buf_info.data_buf_size <
+                                  io->buffer_size * pcm->frame_size) {
+        AGM_LOGE("%s: shared buffer %d smaller than %lu frames\n", __func__,
+                 pcm->buf_info.data_buf_size, io->buffer_size);
+        ret = -EINVAL;
+        goto err;
+    }
+
+    pcm->data_buf = mmap(0, pcm->buf_info.data_buf_size,
+                         PROT_READ | PROT_WRITE, MAP_SHARED,
+                         pcm->buf_info.data_buf_fd, 0);
+    if (pcm->data_buf == MAP_FAILED) {
+        pcm->data_buf = NULL;
+        ret = -errno;
+        goto err;
+    }
+    pcm->pos_buf = mmap(0, pcm->buf_info.pos_buf_size,
+                        PROT_READ | PROT_WRITE, MAP_SHARED,
+                        pcm->buf_info.pos_buf_fd, 0);
+    if (pcm->pos_buf == MAP_FAILED) {
+        pcm->pos_buf = NULL;
+        ret = -errno;
+        goto err;
+    }
+    return 0;
+
+err:
+    agm_io_mmap_release(pcm);
+    return ret;
+}
+
+/* DSP position in frames within the shared buffer */
+static snd_pcm_sframes_t agm_io_mmap_pointer(struct agmio_priv *pcm)
+{
+    struct agm_io_shared_pos_buffer *pos = pcm->pos_buf;
+    uint32_t frame_cnt, read_index;
+    int i;
+
+    if (!pos)
+        return -EBADFD;
+
+    for (i = 0; i < AGM_IO_POS_RETRY_COUNT; i++) {
+        frame_cnt = pos->frame_counter;
+        read_index = pos->read_index;
+        if (frame_cnt == pos->frame_counter)
+            return (read_index / pcm->frame_size) % pcm->io.buffer_size;
+    }
+    return -EAGAIN;
+}
+
+/* copies between the client areas and the shared buffer at mmap_appl */
+static snd_pcm_uframes_t agm_io_mmap_copy(struct agmio_priv *pcm,
+                                         uint8_t *buf, snd_pcm_uframes_t size)
+{
+    snd_pcm_ioplug_t *io = &pcm->io;
+    snd_pcm_uframes_t done = 0, frames;
+    uint8_t *ring;
+
+    while (done < size) {
+        frames = io->buffer_size - pcm->mmap_appl;
+        if (frames > size - done)
+            frames = size - done;
+        ring = (uint8_t *)pcm->data_buf + pcm->mmap_appl * pcm->frame_size;
+        if (io->stream == SND_PCM_STREAM_PLAYBACK)
+            memcpy(ring, buf + done * pcm->frame_size,
+                   frames * pcm->frame_size);
+        else
+            memcpy(buf + done * pcm->frame_size, ring,
+                   frames * pcm->frame_size);
+        pcm->mmap_appl = (pcm->mmap_appl + frames) % io->buffer_size;
+        done += frames;
+    }
+    return done;
+}
+
+static int agm_io_timer_arm(struct agmio_priv *pcm, bool enable)
+{
+    snd_pcm_ioplug_t *io = &pcm->io;
+    struct itimerspec its;
+    uint64_t period_ns = 0;
+
+    memset(&its, 0, sizeof(its));
+    if (enable && io->rate) {
+        period_ns = (uint64_t)io->period_size * 1000000000ULL / io->rate;
+        its.it_value.tv_sec = period_ns / 1000000000ULL;
+        its.it_value.tv_nsec = period_ns % 1000000000ULL;
+        its.it_interval = its.it_value;
+    }
+    return timerfd_settime(pcm->timer_fd, 0, &its, NULL) ? -errno : 0;
+}
+
 static int agm_io_start(snd_pcm_ioplug_t * io)
 {
     struct agmio_priv *pcm = io->private_data;
@@ -104,6 +344,8 @@ static int agm_io_start(snd_pcm_ioplug_t * io)
         ret = agm_session_start(handle);
         if (!ret)
             pcm->state = AGM_IO_STATE_RUNNING;
+        if (!ret && pcm->mmap)
+            agm_io_timer_arm(pcm, true);
     }
 
     AGM_LOGD("%s: exit\n", __func__);
@@ -119,6 +361,8 @@ static int agm_io_stop(snd_pcm_ioplug_t * io)
     ret = agm_get_session_handle(pcm, &handle);
     if (ret)
         return ret;
+    if (pcm->mmap)
+        agm_io_timer_arm(pcm, false);
     ret = agm_session_stop(handle);
 
     AGM_LOGD("%s: exit\n", __func__);
@@ -136,14 +380,15 @@ static snd_pcm_sframes_t agm_io_pointer(snd_pcm_ioplug_t * io)
     struct agmio_priv *pcm = io->private_data;
     snd_pcm_sframes_t new_hw_ptr;
 
-    new_hw_ptr = pcm->hw_pointer;
-    if (io->stream == SND_PCM_STREAM_CAPTURE) {
-        if (pcm->hw_pointer == 0)
-             new_hw_ptr = io->period_size * pcm->frame_size;
-    }
+    if (pcm->mmap)
+        return agm_io_mmap_pointer(pcm);
 
+    pthread_mutex_lock(&pcm->lock);
+    new_hw_ptr = pcm->hw_pointer;
+    pthread_mutex_unlock(&pcm->lock);
 
-    AGM_LOGD("%s %d\n", __func__, io->state);
+    AGM_LOGV_DP(pcm->device, "%s %d hw_ptr %ld\n", __func__, io->state,
+                (long)new_hw_ptr);
     return new_hw_ptr;
 }
 
@@ -155,13 +400,28 @@ static snd_pcm_sframes_t agm_io_transfer(snd_pcm_ioplug_t * io,
     struct agmio_priv *pcm = io->private_data;
     uint64_t handle;
     uint8_t *buf = (uint8_t *) areas->addr + (areas->first + areas->step * offset) / 8;
-    size_t count;
+    size_t count, chunk;
+    snd_pcm_uframes_t frames = 0;
     int ret = 0;
 
     ret = agm_get_session_handle(pcm, &handle);
     if (ret)
         return ret;
 
+    if (pcm->mmap) {
+        /* data goes straight into the shared buffer, start once filled */
+        if (io->stream == SND_PCM_STREAM_PLAYBACK)
+            frames = agm_io_mmap_copy(pcm, buf, size);
+        if (pcm->state != AGM_IO_STATE_RUNNING) {
+            ret = agm_io_start(io);
+            if (ret)
+                return ret;
+        }
+        if (io->stream == SND_PCM_STREAM_CAPTURE)
+            frames = agm_io_mmap_copy(pcm, buf, size);
+        return frames;
+    }
+
     if (pcm->state != AGM_IO_STATE_RUNNING) {
         ret = agm_io_start(io);
         if (ret)
@@ -175,16 +435,36 @@ static snd_pcm_sframes_t agm_io_transfer(snd_pcm_ioplug_t * io,
     else
         ret = agm_session_read(handle, buf, &count);
 
-    if (ret == 0) {
-        ret = snd_pcm_bytes_to_frames(io->pcm, count);
-        pcm->hw_pointer += ret;
-    }
+    if (ret)
+        return ret;
 
-    if (pcm->hw_pointer > pcm->boundary)
-         pcm->hw_pointer -= pcm->boundary;
+    frames = snd_pcm_bytes_to_frames(io->pcm, count);
 
-    AGM_LOGD("%s: exit\n", __func__);
-    return ret;
+    pthread_mutex_lock(&pcm->lock);
+    if (io->stream == SND_PCM_STREAM_PLAYBACK) {
+        /* every DSP buffer written, even partially, gets its write done */
+        while (count > 0) {
+            chunk = count < pcm->buffer_config->size ?
+                    count : pcm->buffer_config->size;
+            if (pcm->pending_count < AGM_IO_MAX_PERIODS) {
+                pcm->pending[(pcm->pending_head + pcm->pending_count) %
+                             AGM_IO_MAX_PERIODS] =
+                                  snd_pcm_bytes_to_frames(io->pcm, chunk);
+                pcm->pending_count++;
+            } else {
+                pcm->pending[(pcm->pending_head + pcm->pending_count - 1) %
+                             AGM_IO_MAX_PERIODS] +=
+                                  snd_pcm_bytes_to_frames(io->pcm, chunk);
+            }
+            count -= chunk;
+        }
+    }
+    pcm->avail = (pcm->avail > frames) ? pcm->avail - frames : 0;
+    agm_io_update_event_l(pcm);
+    pthread_mutex_unlock(&pcm->lock);
+
+    AGM_LOGV_DP(pcm->device, "%s: exit\n", __func__);
+    return frames;
 }
 
 static int agm_io_prepare(snd_pcm_ioplug_t * io)
@@ -198,6 +478,15 @@ static int agm_io_prepare(snd_pcm_ioplug_t * io)
         return ret;
 
     ret = agm_session_prepare(handle);
+    if (!ret) {
+        pthread_mutex_lock(&pcm->lock);
+        agm_io_reset_l(pcm);
+        pthread_mutex_unlock(&pcm->lock);
+        if (pcm->mmap && pcm->data_buf) {
+            memset(pcm->data_buf, 0, pcm->buf_info.data_buf_size);
+            pcm->mmap_appl = 0;
+        }
+    }
 
     AGM_LOGD("%s: exit\n", __func__);
     return ret;
@@ -228,14 +517,21 @@ static int agm_io_hw_params(snd_pcm_ioplug_t * io,
     buffer_config->count = io->buffer_size / io->period_size;
     pcm->period_size = io->period_size;
     buffer_config->size = io->period_size * pcm->frame_size;
-    pcm->hw_pointer = 0;
 
     snd_card_def_get_int(pcm->pcm_node, "session_mode", &sess_mode);
 
     session_config->dir = (io->stream == SND_PCM_STREAM_PLAYBACK) ? RX : TX;
     session_config->sess_mode = sess_mode;
+    /*
+     * buffer completion is tracked through write/read done events, in
+     * mmap mode the DSP works on the shared buffer directly
+     */
+    session_config->data_mode = pcm->mmap ? AGM_DATA_PUSH_PULL :
+                                            AGM_DATA_NON_BLOCKING;
     ret = agm_session_set_config(pcm->handle, session_config,
                                  pcm->media_config, pcm->buffer_config);
+    if (!ret && pcm->mmap)
+        ret = agm_io_mmap_setup(pcm);
     if (!ret)
         pcm->state = AGM_IO_STATE_SETUP;
 
@@ -284,7 +580,16 @@ static int agm_io_close(snd_pcm_ioplug_t * io)
         return ret;
 
     ret = agm_session_close(handle);
-
+    agm_session_register_cb(pcm->device, NULL, AGM_EVENT_DATA_PATH, pcm);
+
+    if (pcm->event_fd >= 0)
+        close(pcm->event_fd);
+    if (pcm->mmap) {
+        agm_io_mmap_release(pcm);
+        if (pcm->timer_fd >= 0)
+            close(pcm->timer_fd);
+    }
+    pthread_mutex_destroy(&pcm->lock);
     snd_card_def_put_card(pcm->card_node);
     free(pcm->buffer_config);
     free(pcm->media_config);
@@ -310,6 +615,9 @@ static int agm_io_pause(snd_pcm_ioplug_t * io, int enable)
      else
          ret = agm_session_resume(handle);
 
+     if (!ret && pcm->mmap)
+         agm_io_timer_arm(pcm, !enable);
+
      AGM_LOGD("%s: exit\n", __func__);
      return ret;
 }
@@ -331,13 +639,12 @@ static int agm_io_poll_desc(snd_pcm_ioplug_t *io, struct pollfd *pfd,
         AGM_LOGE("%s space %u is not correct!\n", __func__, space);
         return -EINVAL;
     }
-    if (io->stream == SND_PCM_STREAM_PLAYBACK) {
-        pfd[0].fd = pcm->event_fd;
-        pfd[0].events = POLLOUT;
-    } else {
-        pfd[0].fd = pcm->event_fd;
-        pfd[0].events = POLLIN;
-    }
+    /*
+     * event_fd is readable while there is room to write or data to read,
+     * in mmap mode timer_fd wakes the client up every period
+     */
+    pfd[0].fd = pcm->mmap ? pcm->timer_fd : pcm->event_fd;
+    pfd[0].events = POLLIN;
 
     AGM_LOGD("%s: exit\n", __func__);
     return space;
@@ -354,11 +661,32 @@ static int agm_io_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd,
         return -EINVAL;
     }
 
-    if (pfd[0].revents & POLLIN) {
-        *revents = POLLIN;
-    } else if (pfd[0].revents & POLLOUT) {
-        *revents = POLLOUT;
+    *revents = 0;
+    if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        *revents = POLLERR;
+        return 0;
+    }
+
+    if (pcm->mmap) {
+        uint64_t expirations;
+        snd_pcm_sframes_t avail;
+
+        if ((pfd[0].revents & POLLIN) &&
+            read(pcm->timer_fd, &expirations, sizeof(expirations)) < 0)
+            AGM_LOGV("%s: timer_fd read failed %d\n", __func__, errno);
+        avail = snd_pcm_avail_update(io->pcm);
+        if (avail < 0)
+            *revents = POLLERR;
+        else if ((snd_pcm_uframes_t)avail >= io->period_size)
+            *revents = (io->stream == SND_PCM_STREAM_PLAYBACK) ?
+                                                       POLLOUT : POLLIN;
+        return 0;
     }
+
+    pthread_mutex_lock(&pcm->lock);
+    if (pcm->avail > 0)
+        *revents = (io->stream == SND_PCM_STREAM_PLAYBACK) ? POLLOUT : POLLIN;
+    pthread_mutex_unlock(&pcm->lock);
     return 0;
 }
 
@@ -422,7 +750,7 @@ static int agm_hw_constraint(struct agmio_priv* priv)
             return ret;
 
     ret = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIODS,
-                                          1, 8);
+                                          1, AGM_IO_MAX_PERIODS);
     if (ret < 0)
             return ret;
 
@@ -445,6 +773,8 @@ SND_PCM_PLUGIN_DEFINE_FUNC(agm)
     priv = calloc(1, sizeof(*priv));
     if (!priv)
         return -ENOMEM;
+    priv->event_fd = -1;
+    priv->timer_fd = -1;
 
     media_config = calloc(1, sizeof(struct agm_media_config));
     if (!media_config)
@@ -486,6 +816,16 @@ SND_PCM_PLUGIN_DEFINE_FUNC(agm)
             priv->device = device;
             continue;
         }
+        if (strcmp(id, "mmap") == 0) {
+            if ((ret = snd_config_get_bool(n)) < 0) {
+                AGM_LOGE("Invalid type for %s", id);
+                ret = -EINVAL;
+                goto err_free_priv;
+            }
+            priv->mmap = ret;
+            ret = 0;
+            continue;
+        }
     }
 
     card_node = snd_card_def_get_card(card);
@@ -518,7 +858,6 @@ SND_PCM_PLUGIN_DEFINE_FUNC(agm)
     priv->buffer_config = buffer_config;
     priv->session_config = session_config;
     priv->handle = handle;
-    priv->event_fd = -1;
     priv->state = AGM_IO_STATE_OPEN;
     priv->io.version = SND_PCM_IOPLUG_VERSION;
     priv->io.name = "AGM PCM I/O Plugin";
@@ -532,21 +871,44 @@ SND_PCM_PLUGIN_DEFINE_FUNC(agm)
         goto err_free_priv;
     }
 
-    if ((priv->event_fd = eventfd(0, EFD_CLOEXEC)) == -1) {
+    if ((priv->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
         AGM_LOGE("failed to create event_fd\n");
         ret = -EINVAL;
         goto err_free_priv;
     }
+    pthread_mutex_init(&priv->lock, (const pthread_mutexattr_t *) NULL);
+
+    if (priv->mmap) {
+        priv->timer_fd = timerfd_create(CLOCK_MONOTONIC,
+                                        TFD_CLOEXEC | TFD_NONBLOCK);
+        if (priv->timer_fd == -1) {
+            AGM_LOGE("failed to create timer_fd\n");
+            ret = -EINVAL;
+            goto err_free_priv;
+        }
+    }
+
+    ret = agm_session_register_cb(session_id, &agm_io_event_cb,
+                                  AGM_EVENT_DATA_PATH, priv);
+    if (ret) {
+        AGM_LOGE("failed to register data path callback %d\n", ret);
+        goto err_free_priv;
+    }
 
     ret = agm_hw_constraint(priv);
     if (ret < 0) {
+        /* the close callback releases priv and its fds */
         snd_pcm_ioplug_delete(&priv->io);
-        goto err_free_priv;
+        return ret;
     }
 
     *pcmp = priv->io.pcm;
     return 0;
 err_free_priv:
+    if (priv->event_fd >= 0)
+        close(priv->event_fd);
+    if (priv->timer_fd >= 0)
+        close(priv->timer_fd);
     free(priv);
     return ret;
 }
@@ -27,6 +27,7 @@
 ** IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
 #define LOG_TAG "PLUGIN: compress"
+#define AGM_LOG_MODULE AGM_LOG_MOD_PLUGIN
 
 #include <agm/agm_api.h>
 #include <errno.h>
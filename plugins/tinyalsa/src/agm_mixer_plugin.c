@@ -31,6 +31,7 @@
 /* agm_mixer.c all names (variable/functions) should have
    amp_ (Agm Mixer Plugin) */
 #define LOG_TAG "PLUGIN: mixer"
+#define AGM_LOG_MODULE AGM_LOG_MOD_PLUGIN
 
 #include <stdio.h>
 #include <stdint.h>
@@ -69,6 +70,15 @@
 #define AMP_PRIV_GET_CTL_NAME_PTR(p, idx) \
     (p->ctl_names[idx])
 
+/*
+ * Module events are kept in fixed rings of AMP_EVENT_RING_SIZE entries,
+ * once full the oldest entry is dropped. Event slots are preallocated
+ * for AMP_EVENT_PAYLOAD_PREALLOC bytes of payload and only grow when a
+ * larger event shows up.
+ */
+#define AMP_EVENT_RING_SIZE 64
+#define AMP_EVENT_PAYLOAD_PREALLOC 256
+
 enum {
     BE_CTL_NAME_MEDIA_CONFIG = 0,
     BE_CTL_NAME_METADATA,
@@ -190,13 +200,36 @@ struct amp_be_group_info {
     int count;
 };
 
+/* "<pcm> event" ctl name of a session, built at open */
+struct amp_event_name {
+    uint32_t session_id;
+    char name[SNDRV_CTL_ELEM_ID_NAME_MAXLEN];
+};
+
+struct amp_event_slot {
+    uint32_t session_id;
+    bool valid;
+    size_t capacity;
+    struct agm_event_cb_params *params;
+};
+
 struct amp_priv {
     unsigned int card;
     void *card_node;
 
     struct aif_info *aif_list;
-    struct listnode events_list;
-    struct listnode events_paramlist;
+
+    struct amp_event_name *event_names;
+    int event_name_count;
+    /* event params, read per session through "<pcm> event" */
+    struct amp_event_slot event_slots[AMP_EVENT_RING_SIZE];
+    unsigned int event_head;
+    unsigned int event_count;
+    /* name index of each pending ctl event, read through read_event */
+    int event_notify[AMP_EVENT_RING_SIZE];
+    unsigned int notify_head;
+    unsigned int notify_count;
+    uint64_t events_dropped;
 
     struct amp_dev_info rx_be_devs;
     struct amp_dev_info tx_be_devs;
@@ -217,16 +250,6 @@ struct amp_priv {
     pthread_mutex_t lock;
 };
 
-struct event_params_node {
-    uint32_t session_id;
-    struct listnode node;
-    struct agm_event_cb_params event_params;
-};
-
-struct mixer_plugin_event_data {
-    struct ctl_event ev;
-    struct listnode node;
-};
 
 static enum agm_media_format alsa_to_agm_fmt(int fmt)
 {
@@ -325,8 +348,23 @@ static void amp_free_acdb_dev_info(struct amp_priv *amp_priv)
     amp_free_dev_info(&amp_priv->acdb_tunnels);
 }
 
+static void amp_free_events(struct amp_priv *amp_priv)
+{
+    int i;
+
+    for (i = 0; i < AMP_EVENT_RING_SIZE; i++) {
+        free(amp_priv->event_slots[i].params);
+        amp_priv->event_slots[i].params = NULL;
+        amp_priv->event_slots[i].capacity = 0;
+    }
+    free(amp_priv->event_names);
+    amp_priv->event_names = NULL;
+    amp_priv->event_name_count = 0;
+}
+
 static void amp_free_pcm_dev_info(struct amp_priv *amp_priv)
 {
+    amp_free_events(amp_priv);
     amp_free_dev_info(&amp_priv->rx_pcm_devs);
     amp_free_dev_info(&amp_priv->tx_pcm_devs);
 }
@@ -346,26 +384,123 @@ static void amp_free_ctls(struct amp_priv *amp_priv)
     amp_priv->ctl_count = 0;
 }
 
-static void amp_add_event_params(struct amp_priv *amp_priv,
-                                 uint32_t session_id,
-                                 struct agm_event_cb_params *event_params)
+static int amp_init_events(struct amp_priv *amp_priv)
 {
-    struct event_params_node *event_node;
-    struct agm_event_cb_params *eparams;
-    uint32_t len = event_params->event_payload_size;
+    struct amp_dev_info *adis[] = {
+        &amp_priv->rx_pcm_devs, &amp_priv->tx_pcm_devs };
+    struct amp_event_slot *slot;
+    int i, j, n = 0;
 
-    event_node = calloc(1, sizeof(struct event_params_node) + len);
-    if (!event_node)
-        return;
+    amp_priv->event_names = calloc(adis[0]->count + adis[1]->count,
+                                   sizeof(*amp_priv->event_names));
+    if (!amp_priv->event_names)
+        return -ENOMEM;
 
-    event_node->session_id = session_id;
-    eparams = &event_node->event_params;
-    eparams->source_module_id = event_params->source_module_id;
-    eparams->event_id = event_params->event_id;
-    eparams->event_payload_size = len;
+    /* Rx device nodes first, then Tx */
+    for (i = 0; i < (int)ARRAY_SIZE(adis); i++) {
+        for (j = 0; j < adis[i]->count; j++) {
+            amp_priv->event_names[n].session_id = adis[i]->idx_arr[j];
+            snprintf(amp_priv->event_names[n].name,
+                     sizeof(amp_priv->event_names[n].name), "%s %s",
+                     adis[i]->names[j],
+                     amp_pcm_ctl_name_extn[PCM_CTL_NAME_EVENT]);
+            n++;
+        }
+    }
+    amp_priv->event_name_count = n;
 
-    memcpy(&eparams->event_payload, &event_params->event_payload, len);
-    list_add_tail(&amp_priv->events_paramlist, &event_node->node);
+    for (i = 0; i < AMP_EVENT_RING_SIZE; i++) {
+        slot = &amp_priv->event_slots[i];
+        slot->capacity = sizeof(struct agm_event_cb_params) +
+                         AMP_EVENT_PAYLOAD_PREALLOC;
+        slot->params = calloc(1, slot->capacity);
+        if (!slot->params) {
+            amp_free_events(amp_priv);
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
+
+static int amp_get_event_name_idx(struct amp_priv *amp_priv,
+                                  uint32_t session_id)
+{
+    int i;
+
+    for (i = 0; i < amp_priv->event_name_count; i++) {
+        if (amp_priv->event_names[i].session_id == session_id)
+            return i;
+    }
+    return -1;
+}
+
+/* advance past slots already read out of order, called with lock held */
+static void amp_event_trim_l(struct amp_priv *amp_priv)
+{
+    while (amp_priv->event_count &&
+           !amp_priv->event_slots[amp_priv->event_head].valid) {
+        amp_priv->event_head = (amp_priv->event_head + 1) %
+                               AMP_EVENT_RING_SIZE;
+        amp_priv->event_count--;
+    }
+}
+
+static void amp_event_drop_oldest_l(struct amp_priv *amp_priv)
+{
+    struct amp_event_slot *slot;
+
+    slot = &amp_priv->event_slots[amp_priv->event_head];
+    amp_priv->events_dropped++;
+    /* log the first drop and then every power of two */
+    if ((amp_priv->events_dropped & (amp_priv->events_dropped - 1)) == 0)
+        AGM_LOGE("%s: event ring full, dropped event 0x%x of session %u, "
+                 "%llu dropped so far\n", __func__, slot->params->event_id,
+                 slot->session_id,
+                 (unsigned long long)amp_priv->events_dropped);
+    slot->valid = false;
+    amp_event_trim_l(amp_priv);
+}
+
+static int amp_add_event_params_l(struct amp_priv *amp_priv,
+                                  uint32_t session_id,
+                                  struct agm_event_cb_params *event_params)
+{
+    struct amp_event_slot *slot;
+    size_t size = sizeof(struct agm_event_cb_params) +
+                  event_params->event_payload_size;
+    void *params;
+
+    if (amp_priv->event_count == AMP_EVENT_RING_SIZE)
+        amp_event_drop_oldest_l(amp_priv);
+
+    slot = &amp_priv->event_slots[(amp_priv->event_head +
+                                   amp_priv->event_count) %
+                                  AMP_EVENT_RING_SIZE];
+    if (slot->capacity < size) {
+        params = realloc(slot->params, size);
+        if (!params)
+            return -ENOMEM;
+        slot->params = params;
+        slot->capacity = size;
+    }
+
+    memcpy(slot->params, event_params, size);
+    slot->session_id = session_id;
+    slot->valid = true;
+    amp_priv->event_count++;
+    return 0;
+}
+
+static void amp_add_event_notify_l(struct amp_priv *amp_priv, int name_idx)
+{
+    if (amp_priv->notify_count == AMP_EVENT_RING_SIZE) {
+        amp_priv->notify_head = (amp_priv->notify_head + 1) %
+                                AMP_EVENT_RING_SIZE;
+        amp_priv->notify_count--;
+    }
+    amp_priv->event_notify[(amp_priv->notify_head + amp_priv->notify_count) %
+                           AMP_EVENT_RING_SIZE] = name_idx;
+    amp_priv->notify_count++;
 }
 
 void amp_event_cb(uint32_t session_id, struct agm_event_cb_params *event_params,
@@ -373,13 +508,7 @@ void amp_event_cb(uint32_t session_id, struct agm_event_cb_params *event_params,
 {
     struct mixer_plugin *plugin = client_data;
     struct amp_priv *amp_priv;
-    struct ctl_event event;
-    struct mixer_plugin_event_data *data;
-    char *stream = NULL;
-    char *ctl_name = "event";
-    char *mixer_str = NULL;
-    int ctl_len, i;
-    struct amp_dev_info *adi = NULL;
+    int name_idx;
 
     if (!plugin)
         return;
@@ -391,56 +520,20 @@ void amp_event_cb(uint32_t session_id, struct agm_event_cb_params *event_params,
     if (!amp_priv)
         return;
 
-    /* Get device node name
-     * Check Rx device nodes followed by Tx.
-     */
-    adi = &amp_priv->rx_pcm_devs;
-    for (i = 0; i < adi->count; i++) {
-        if(adi->idx_arr[i] == session_id) {
-            stream = adi->names[i];
-            goto found;
-        }
-    }
-
-    adi = &amp_priv->tx_pcm_devs;
-    for (i = 0; i < adi->count; i++) {
-        if(adi->idx_arr[i] == session_id) {
-            stream = adi->names[i];
-            goto found;
-        }
-    }
-
-    if (!stream)
+    name_idx = amp_get_event_name_idx(amp_priv, session_id);
+    if (name_idx < 0)
         return;
-found:
+
     pthread_mutex_lock(&amp_priv->lock);
-    amp_add_event_params(amp_priv, session_id, event_params);
-    event.type = SNDRV_CTL_EVENT_ELEM;
-    ctl_len = (int)(strlen(stream) + 1 + strlen(ctl_name) + 1);
-    mixer_str = calloc(1, ctl_len);
-    if (!mixer_str) {
+    if (amp_add_event_params_l(amp_priv, session_id, event_params)) {
         pthread_mutex_unlock(&amp_priv->lock);
         return;
     }
-
-    snprintf(mixer_str, ctl_len, "%s %s", stream, ctl_name);
-    strlcpy((char*)event.data.elem.id.name, mixer_str, sizeof(event.data.elem.id.name));
-
-    data = calloc(1, sizeof(struct mixer_plugin_event_data));
-    if (!data) {
-        pthread_mutex_unlock(&amp_priv->lock);
-        goto done;
-    }
-
-    data->ev = event;
-    list_add_tail(&amp_priv->events_list, &data->node);
+    amp_add_event_notify_l(amp_priv, name_idx);
     pthread_mutex_unlock(&amp_priv->lock);
 
     if (amp_priv->event_cb)
         amp_priv->event_cb(plugin);
-
-done:
-    free(mixer_str);
 }
 
 static void amp_copy_be_names_from_aif_list(struct aif_info *aif_list,
@@ -1104,10 +1197,10 @@ static int amp_pcm_event_get(struct mixer_plugin *plugin,
                 struct snd_control *ctl, struct snd_ctl_tlv *tlv)
 {
     struct amp_priv *amp_priv = plugin->priv;
-    struct listnode *eparams_node, *temp;
-    struct event_params_node *event_node;
+    struct amp_event_slot *slot;
     struct agm_event_cb_params *eparams;
     int session_id = ctl->private_value;
+    unsigned int i;
     uint32_t tlv_size, event_payload_size;
     void *payload;
     int ret = 0;
@@ -1123,23 +1216,23 @@ static int amp_pcm_event_get(struct mixer_plugin *plugin,
         return -EINVAL;
     }
     pthread_mutex_lock(&amp_priv->lock);
-    list_for_each_safe(eparams_node, temp, &amp_priv->events_paramlist) {
-        event_node = node_to_item(eparams_node, struct event_params_node, node);
-        if (event_node->session_id == session_id) {
-            eparams = &event_node->event_params;
-            event_payload_size = sizeof(struct agm_event_cb_params) + eparams->event_payload_size;
-            if (tlv_size < event_payload_size) {
-                AGM_LOGE("Expected %d size, received %d\n", event_payload_size, tlv_size);
-                ret = -EINVAL;
-                goto done;
-            }
-            memcpy(payload, eparams,
-                   sizeof(struct agm_event_cb_params)
-                   + eparams->event_payload_size);
-            list_remove(&event_node->node);
-            free(event_node);
+    for (i = 0; i < amp_priv->event_count; i++) {
+        slot = &amp_priv->event_slots[(amp_priv->event_head + i) %
+                                      AMP_EVENT_RING_SIZE];
+        if (!slot->valid || slot->session_id != session_id)
+            continue;
+
+        eparams = slot->params;
+        event_payload_size = sizeof(struct agm_event_cb_params) + eparams->event_payload_size;
+        if (tlv_size < event_payload_size) {
+            AGM_LOGE("Expected %d size, received %d\n", event_payload_size, tlv_size);
+            ret = -EINVAL;
             goto done;
         }
+        memcpy(payload, eparams, event_payload_size);
+        slot->valid = false;
+        amp_event_trim_l(amp_priv);
+        goto done;
     }
 
 done:
@@ -1394,9 +1487,22 @@ static int amp_pcm_get_param_get(struct mixer_plugin *plugin __unused,
     tlv_size = tlv->length;
     pcm_idx = pcm_adi->idx_arr[idx];
 
+    /*
+     * Without a staged put(), the caller's TLV buffer already carries the
+     * query (module instance id first) and the result is written back into
+     * it, so a getParam costs a single control transaction.
+     */
     if (!pcm_adi->get_param_info[idx].get_param_payload) {
-        AGM_LOGE("%s: put() for getParam not called\n", __func__);
-        return -EINVAL;
+        if (tlv_size < sizeof(uint32_t) || !*(uint32_t *)payload) {
+            AGM_LOGE("%s: put() for getParam not called\n", __func__);
+            return -EINVAL;
+        }
+        ret = agm_session_get_params(pcm_idx, payload, tlv_size);
+        if (ret == -EALREADY)
+            ret = 0;
+        if (ret)
+            AGM_LOGE("%s: failed err %d for %s\n", __func__, ret, ctl->name);
+        return ret;
     }
 
     if (tlv_size < pcm_adi->get_param_info[idx].get_param_payload_size) {
@@ -2151,28 +2257,26 @@ static ssize_t amp_read_event(struct mixer_plugin *plugin,
 {
     struct amp_priv *amp_priv = plugin->priv;
     ssize_t result = 0;
+    int name_idx;
 
-    while (size >= sizeof(struct ctl_event)) {
-        struct mixer_plugin_event_data *data;
-
-        pthread_mutex_lock(&amp_priv->lock);
-        if (list_empty(&amp_priv->events_list)) {
-            pthread_mutex_unlock(&amp_priv->lock);
-            return result;
-        }
-
-        data = node_to_item(amp_priv->events_list.next,
-                            struct mixer_plugin_event_data, node);
-        memcpy(ev, &data->ev, sizeof(struct ctl_event));
-
-        list_remove(&data->node);
-        free(data);
-        pthread_mutex_unlock(&amp_priv->lock);
-
-        ev += sizeof(struct ctl_event);
+    pthread_mutex_lock(&amp_priv->lock);
+    while (size >= sizeof(struct ctl_event) && amp_priv->notify_count) {
+        name_idx = amp_priv->event_notify[amp_priv->notify_head];
+        amp_priv->notify_head = (amp_priv->notify_head + 1) %
+                                AMP_EVENT_RING_SIZE;
+        amp_priv->notify_count--;
+
+        memset(ev, 0, sizeof(struct ctl_event));
+        ev->type = SNDRV_CTL_EVENT_ELEM;
+        strlcpy((char *)ev->data.elem.id.name,
+                amp_priv->event_names[name_idx].name,
+                sizeof(ev->data.elem.id.name));
+
+        ev++;
         size -= sizeof(struct ctl_event);
         result += sizeof(struct ctl_event);
     }
+    pthread_mutex_unlock(&amp_priv->lock);
 
     return result;
 }
@@ -2181,9 +2285,7 @@ static int amp_subscribe_events(struct mixer_plugin *plugin,
                                   event_callback event_cb)
 {
     struct amp_priv *amp_priv = plugin->priv;
-    struct listnode *eparams_node, *ev_node, *temp, *temp2;
-    struct event_params_node *event_node;
-    struct mixer_plugin_event_data *ev_data;
+    int i;
 
     AGM_LOGV("%s: enter\n", __func__);
 
@@ -2191,17 +2293,14 @@ static int amp_subscribe_events(struct mixer_plugin *plugin,
 
     /* clear all event params on unsubscribe */
     if (event_cb == NULL) {
-        list_for_each_safe(eparams_node, temp, &amp_priv->events_paramlist) {
-            event_node = node_to_item(eparams_node, struct event_params_node, node);
-            list_remove(&event_node->node);
-            free(event_node);
-        }
-
-        list_for_each_safe(ev_node, temp2, &amp_priv->events_list) {
-            ev_data = node_to_item(ev_node, struct mixer_plugin_event_data, node);
-            list_remove(&ev_data->node);
-            free(ev_data);
-        }
+        pthread_mutex_lock(&amp_priv->lock);
+        for (i = 0; i < AMP_EVENT_RING_SIZE; i++)
+            amp_priv->event_slots[i].valid = false;
+        amp_priv->event_head = 0;
+        amp_priv->event_count = 0;
+        amp_priv->notify_head = 0;
+        amp_priv->notify_count = 0;
+        pthread_mutex_unlock(&amp_priv->lock);
     }
     return 0;
 }
@@ -2283,6 +2382,10 @@ MIXER_PLUGIN_OPEN_FN(agm_mixer_plugin)
     if (ret)
         goto err_get_pcm_info;
 
+    ret = amp_init_events(amp_priv);
+    if (ret)
+        goto err_get_acdb_info;
+
     ret = amp_get_acdb_info(amp_priv);
     if (ret)
         goto err_get_acdb_info;
@@ -2335,10 +2438,8 @@ MIXER_PLUGIN_OPEN_FN(agm_mixer_plugin)
     amp->priv = amp_priv;
     *plugin = amp;
 
-    amp_register_event_callback(amp, 1);
-    list_init(&amp_priv->events_paramlist);
-    list_init(&amp_priv->events_list);
     pthread_mutex_init(&amp_priv->lock, (const pthread_mutexattr_t *) NULL);
+    amp_register_event_callback(amp, 1);
     AGM_LOGV("%s: total_ctl_cnt = %d\n", __func__, total_ctl_cnt);
 
     return 0;
@@ -28,6 +28,7 @@
 ** IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 **/
 #define LOG_TAG "PLUGIN: pcm"
+#define AGM_LOG_MODULE AGM_LOG_MOD_PLUGIN
 
 #include <agm/agm_api.h>
 #include <errno.h>
@@ -31,6 +31,7 @@
 ** SPDX-License-Identifier: BSD-3-Clause-Clear
 **/
 
+#include <errno.h>
 #include <tinyalsa/asoundlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -73,7 +74,7 @@ static unsigned int capture_sample(FILE *file, unsigned int card, unsigned int d
                             unsigned int period_count, unsigned int cap_time,
                             struct device_config *dev_config, unsigned int stream_kv,
                             unsigned int device_kv, unsigned int instance_kv,
-                            unsigned int devicepp_kv);
+                            unsigned int devicepp_kv, bool measure);
 
 static void sigint_handler(int sig)
 {
@@ -87,7 +88,8 @@ static void usage(void)
            " [-n n_periods] [-T capture time] [-i intf_name] [-dkv device_kv]\n"
            " [-dppkv deviceppkv] : Assign 0 if no device pp in the graph\n"
            " [-ikv instance_kv] :  Assign 0 if no instance kv in the graph\n"
-           " [-skv stream_kv]\n");
+           " [-skv stream_kv]\n"
+           " [-m] : measure per-period read timing, jitter and xruns\n");
 }
 
 int main(int argc, char **argv)
@@ -111,7 +113,7 @@ int main(int argc, char **argv)
     unsigned int devicepp_kv = 0;
     unsigned int stream_kv = 0;
     unsigned int instance_kv = INSTANCE_1;
-
+    bool measure = false;
 
     if (argc < 2) {
         usage();
@@ -179,6 +181,8 @@ int main(int argc, char **argv)
             argv++;
             if (*argv)
                 devicepp_kv = convert_char_to_hex(*argv);
+        } else if (strcmp(*argv, "-m") == 0) {
+            measure = true;
         } else if (strcmp(*argv, "-help") == 0) {
             usage();
         }
@@ -236,7 +240,7 @@ int main(int argc, char **argv)
     frames = capture_sample(file, card, device, header.num_channels,
                             header.sample_rate, format,
                             period_size, period_count, cap_time, &config,
-                            stream_kv, device_kv, instance_kv, devicepp_kv);
+                            stream_kv, device_kv, instance_kv, devicepp_kv, measure);
     printf("Captured %u frames\n", frames);
 
     /* write header now all information is known */
@@ -255,7 +259,8 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
                             enum pcm_format format, unsigned int period_size,
                             unsigned int period_count, unsigned int cap_time,
                             struct device_config *dev_config, unsigned int stream_kv,
-                            unsigned int device_kv, unsigned int instance_kv, unsigned int devicepp_kv)
+                            unsigned int device_kv, unsigned int instance_kv, unsigned int devicepp_kv,
+                            bool measure)
 {
     struct pcm_config config;
     struct pcm *pcm;
@@ -268,6 +273,8 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
     struct timespec end;
     struct timespec now;
     uint32_t miid = 0;
+    struct period_stats stats;
+    uint64_t begin_us;
     int ret = 0;
     stream_kv = stream_kv ? stream_kv : PCM_RECORD;
 
@@ -333,14 +340,19 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
         goto err_close_mixer;
     }
 
-    pcm = pcm_open(card, device, PCM_IN, &config);
+    /* in measurement mode surface overruns instead of restarting silently */
+    pcm = pcm_open(card, device, PCM_IN | (measure ? PCM_NORESTART : 0), &config);
     if (!pcm || !pcm_is_ready(pcm)) {
         printf("Unable to open PCM device (%s)\n",
                 pcm_get_error(pcm));
         goto err_close_mixer;
     }
 
-    size = pcm_frames_to_bytes(pcm, pcm_get_buffer_size(pcm));
+    /* read one period at a time so each call can be timed */
+    if (measure)
+        size = pcm_frames_to_bytes(pcm, config.period_size);
+    else
+        size = pcm_frames_to_bytes(pcm, pcm_get_buffer_size(pcm));
     buffer = malloc(size);
     if (!buffer) {
         printf("Unable to allocate %u bytes\n", size);
@@ -359,7 +371,24 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
     end.tv_sec = now.tv_sec + cap_time;
     end.tv_nsec = now.tv_nsec;
 
-    while (capturing && !pcm_read(pcm, buffer, size)) {
+    if (measure)
+        period_stats_init(&stats, "agmcap", config.period_size, config.period_count,
+                          config.rate);
+
+    while (capturing) {
+        if (measure) {
+            begin_us = period_stats_now_us();
+            ret = pcm_read(pcm, buffer, size);
+            period_stats_record(&stats, begin_us, period_stats_now_us(), ret);
+            if (ret == -EPIPE) {
+                pcm_prepare(pcm);
+                continue;
+            }
+        } else {
+            ret = pcm_read(pcm, buffer, size);
+        }
+        if (ret)
+            break;
         if (fwrite(buffer, 1, size, file) != size) {
             printf("Error capturing sample\n");
             break;
@@ -373,6 +402,9 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
         }
     }
 
+    if (measure)
+        period_stats_print(&stats);
+
     frames = pcm_bytes_to_frames(pcm, bytes_read);
     free(buffer);
 
@@ -31,6 +31,7 @@
 ** SPDX-License-Identifier: BSD-3-Clause-Clear
 **/
 
+#include <errno.h>
 #include <tinyalsa/asoundlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -43,6 +44,10 @@
 #include <time.h>
 #include "agmmixer.h"
 
+/* impulse train used to measure the loopback round trip */
+#define IMPULSE_INTERVAL_US 500000
+#define IMPULSE_TIMEOUT_US  1000000
+
 static int close_f = 0;
 
 void sigint_handler(int sig)
@@ -55,7 +60,47 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
                   struct device_config *p_config, unsigned int period_size,
                   unsigned int period_count, unsigned int play_cap_time, char* capture_intf,
                   char* play_intf, unsigned int pdkv, unsigned int cdkv, unsigned int stream_kv,
-                  unsigned int do_loopback);
+                  unsigned int do_loopback, bool measure, bool rtt);
+
+static int32_t impulse_level(enum pcm_format format)
+{
+    switch (format) {
+    case PCM_FORMAT_S32_LE:
+        return INT32_MAX;
+    case PCM_FORMAT_S24_LE:
+        return 0x7fffff;
+    default:
+        return INT16_MAX;
+    }
+}
+
+/* full scale sample on the first channel of the first frame */
+static void impulse_put(char *buffer, enum pcm_format format)
+{
+    if (format == PCM_FORMAT_S16_LE)
+        *(int16_t *)buffer = (int16_t)impulse_level(format);
+    else
+        *(int32_t *)buffer = impulse_level(format);
+}
+
+/* first frame whose first channel is above half scale, -1 if none */
+static int impulse_find(char *buffer, enum pcm_format format, unsigned int channels,
+                        unsigned int frames)
+{
+    int32_t threshold = impulse_level(format) / 2;
+    int32_t sample;
+    unsigned int i;
+
+    for (i = 0; i < frames; i++) {
+        if (format == PCM_FORMAT_S16_LE)
+            sample = ((int16_t *)buffer)[i * channels];
+        else
+            sample = ((int32_t *)buffer)[i * channels];
+        if (sample > threshold || sample < -threshold)
+            return i;
+    }
+    return -1;
+}
 
 void usage()
 {
@@ -65,7 +110,11 @@ void usage()
            " [-cdkv capture_device_kv] [-pdkv playback_device_kv] [-skv stream_kv]\n"
            " Used to enable 'hostless' mode for audio devices with a DSP back-end.\n"
            " Alternatively, specify '-l' for loopback mode: this program will read\n"
-           " from the capture device and write to the playback device.\n");
+           " from the capture device and write to the playback device.\n"
+           " [-m] : with '-l', measure per-period read/write timing, jitter and xruns\n"
+           " [-rtt] : measure the round trip latency, implies '-l -m'. An impulse train\n"
+           " is played instead of the captured data and detected on the capture\n"
+           " device, so the playback interface must be looped back to the capture one.\n");
 }
 
 int main(int argc, char **argv)
@@ -82,6 +131,8 @@ int main(int argc, char **argv)
     char* c_intf_name = NULL;
     char* p_intf_name = NULL;
     unsigned int do_loopback = 0;
+    bool measure = false;
+    bool rtt = false;
     enum pcm_format format;
     struct device_config capture_config;
     struct device_config play_config;
@@ -144,6 +195,10 @@ int main(int argc, char **argv)
                 p_intf_name = *argv;
         } else if (strcmp(*argv, "-l") == 0) {
             do_loopback = 1;
+        } else if (strcmp(*argv, "-m") == 0) {
+            measure = true;
+        } else if (strcmp(*argv, "-rtt") == 0) {
+            rtt = true;
         } else if (strcmp(*argv, "-skv") == 0) {
             argv++;
             if (*argv)
@@ -164,6 +219,15 @@ int main(int argc, char **argv)
             argv++;
     }
 
+    if (rtt) {
+        do_loopback = 1;
+        measure = true;
+    }
+    if (measure && !do_loopback) {
+        printf("Nothing to measure in hostless mode, use '-l'\n");
+        measure = false;
+    }
+
     ret = get_device_media_config(BACKEND_CONF_FILE, c_intf_name, &capture_config);
     if (ret) {
         printf("Invalid input, assigning default values for : %s\n", c_intf_name);
@@ -196,7 +260,7 @@ int main(int argc, char **argv)
     }
     play_loopback(card, p_device, c_device, num_channels, sample_rate, format, &capture_config, &play_config, period_size,
                   period_count, play_cap_time, c_intf_name, p_intf_name, p_device_kv,
-                  c_device_kv, stream_kv, do_loopback);
+                  c_device_kv, stream_kv, do_loopback, measure, rtt);
 
     return 0;
 }
@@ -206,7 +270,7 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
                   struct device_config *p_config, unsigned int period_size,
                   unsigned int period_count, unsigned int play_cap_time, char* capture_intf,
                   char* play_intf, unsigned int pdkv, unsigned int cdkv, unsigned int stream_kv,
-                  unsigned int do_loopback)
+                  unsigned int do_loopback, bool measure, bool rtt)
 {
     struct pcm_config config;
     struct pcm *p_pcm, *c_pcm;
@@ -220,6 +284,12 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
     struct timespec end;
     struct timespec now;
     struct group_config grp_config;
+    struct period_stats c_stats, p_stats;
+    uint64_t begin_us, now_us = 0, capture_us;
+    uint64_t impulse_us = 0, last_impulse_us = 0;
+    unsigned int impulses_lost = 0;
+    bool emit = false;
+    int io_ret, index;
     stream_kv = stream_kv ? stream_kv : PCM_RX_LOOPBACK;
 
     memset(&config, 0, sizeof(config));
@@ -308,7 +378,8 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
         }
     }
 
-    p_pcm = pcm_open(card, p_device, PCM_OUT, &config);
+    /* in measurement mode surface xruns instead of restarting silently */
+    p_pcm = pcm_open(card, p_device, PCM_OUT | (measure ? PCM_NORESTART : 0), &config);
     if (!p_pcm || !pcm_is_ready(p_pcm)) {
         printf("Unable to open playback PCM device (%s)\n",
                 pcm_get_error(p_pcm));
@@ -326,7 +397,7 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
         goto err_close_p_pcm;
     }
 
-    c_pcm = pcm_open(card, c_device, PCM_IN, &config);
+    c_pcm = pcm_open(card, c_device, PCM_IN | (measure ? PCM_NORESTART : 0), &config);
     if (!c_pcm || !pcm_is_ready(c_pcm)) {
         printf("Unable to open playback PCM device (%s)\n",
                 pcm_get_error(c_pcm));
@@ -339,7 +410,11 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
     }
 
     if (do_loopback) {
-        size = pcm_frames_to_bytes(c_pcm, pcm_get_buffer_size(c_pcm));
+        /* move one period at a time so each call can be timed */
+        if (measure)
+            size = pcm_frames_to_bytes(c_pcm, period_size);
+        else
+            size = pcm_frames_to_bytes(c_pcm, pcm_get_buffer_size(c_pcm));
         buffer = malloc(size);
         if (!buffer) {
             printf("Unable to allocate %d bytes\n", size);
@@ -347,22 +422,71 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
         }
     }
 
+    if (measure) {
+        period_stats_init(&c_stats, "agmhostless capture", period_size, period_count, rate);
+        period_stats_init(&p_stats, "agmhostless playback", period_size, period_count, rate);
+    }
+
     clock_gettime(CLOCK_MONOTONIC, &end);
     end.tv_sec += play_cap_time;
     while (1) {
         if (close_f)
             break;
         if (do_loopback) {
-            if (pcm_read(c_pcm, buffer, size)) {
+            begin_us = measure ? period_stats_now_us() : 0;
+            io_ret = pcm_read(c_pcm, buffer, size);
+            if (measure) {
+                now_us = period_stats_now_us();
+                period_stats_record(&c_stats, begin_us, now_us, io_ret);
+                if (io_ret == -EPIPE) {
+                    pcm_prepare(c_pcm);
+                    continue;
+                }
+            }
+            if (io_ret) {
                 printf("Unable to read from PCM capture device %u (%s)\n",
                         c_device, pcm_get_error(c_pcm));
                 break;
             }
-            if (pcm_write(p_pcm, buffer, size)) {
+            if (rtt) {
+                if (impulse_us) {
+                    index = impulse_find(buffer, format, channels, period_size);
+                    if (index >= 0) {
+                        /* capture time of the impulse, not of the end of the period */
+                        capture_us = now_us - (uint64_t)(period_size - index) * 1000000ULL / rate;
+                        period_stats_record_rtt(&c_stats,
+                                capture_us > impulse_us ? capture_us - impulse_us : 0);
+                        impulse_us = 0;
+                    } else if (now_us - impulse_us > IMPULSE_TIMEOUT_US) {
+                        impulses_lost++;
+                        impulse_us = 0;
+                    }
+                }
+                /* play silence with an impulse every IMPULSE_INTERVAL_US */
+                memset(buffer, 0, size);
+                emit = !impulse_us && now_us - last_impulse_us >= IMPULSE_INTERVAL_US;
+                if (emit)
+                    impulse_put(buffer, format);
+            }
+            begin_us = measure ? period_stats_now_us() : 0;
+            io_ret = pcm_write(p_pcm, buffer, size);
+            if (measure) {
+                now_us = period_stats_now_us();
+                period_stats_record(&p_stats, begin_us, now_us, io_ret);
+                if (io_ret == -EPIPE) {
+                    pcm_prepare(p_pcm);
+                    continue;
+                }
+            }
+            if (io_ret) {
                 printf("Unable to write to PCM playback device %u (%s)\n",
                         p_device, pcm_get_error(p_pcm));
                 break;
             }
+            if (emit) {
+                impulse_us = last_impulse_us = now_us;
+                emit = false;
+            }
         } else {
             usleep(100000);
         }
@@ -374,6 +498,12 @@ void play_loopback(unsigned int card, unsigned int p_device, unsigned int c_devi
                 break;
         }
     }
+    if (measure) {
+        period_stats_print(&c_stats);
+        period_stats_print(&p_stats);
+        if (rtt)
+            printf("round trip: %u impulses lost\n", impulses_lost);
+    }
     connect_play_pcm_to_cap_pcm(mixer, -1, c_device);
 err_close_c_pcm:
     pcm_close(c_pcm);
@@ -41,6 +41,8 @@
 #include <stdint.h>
 #include <string.h>
 #include <signal.h>
+#include <inttypes.h>
+#include <time.h>
 
 #include <agm/agm_api.h>
 #include "agmmixer.h"
@@ -1444,3 +1446,130 @@ exit:
     free(mixer_str);
     return ret;
 }
+
+uint64_t period_stats_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static unsigned int period_stats_bucket(uint64_t us)
+{
+    unsigned int bucket = 0;
+
+    while (us && bucket < PERIOD_HIST_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void period_stats_init(struct period_stats *stats, const char *name, unsigned int period_size,
+                       unsigned int period_count, unsigned int rate)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+    stats->period_us = rate ? (uint64_t)period_size * 1000000ULL / rate : 0;
+    stats->buffer_us = stats->period_us * period_count;
+    /* the first calls only fill (or drain) the buffer, do not count them as jitter */
+    stats->warmup = period_count;
+    stats->call_min_us = UINT64_MAX;
+    stats->jitter_min_us = INT64_MAX;
+    stats->jitter_max_us = INT64_MIN;
+    stats->rtt_min_us = UINT64_MAX;
+}
+
+void period_stats_record(struct period_stats *stats, uint64_t begin_us, uint64_t end_us, int ret)
+{
+    uint64_t call_us = end_us - begin_us;
+    uint64_t interval_us;
+    int64_t jitter_us;
+
+    stats->calls++;
+    if (ret == -EPIPE)
+        stats->xruns++;
+
+    if (call_us < stats->call_min_us)
+        stats->call_min_us = call_us;
+    if (call_us > stats->call_max_us)
+        stats->call_max_us = call_us;
+    stats->call_sum_us += call_us;
+    stats->call_hist[period_stats_bucket(call_us)]++;
+
+    if (stats->last_us && stats->calls > stats->warmup) {
+        interval_us = end_us - stats->last_us;
+        jitter_us = (int64_t)interval_us - (int64_t)stats->period_us;
+        if (jitter_us < stats->jitter_min_us)
+            stats->jitter_min_us = jitter_us;
+        if (jitter_us > stats->jitter_max_us)
+            stats->jitter_max_us = jitter_us;
+        stats->jitter_abs_sum_us += jitter_us < 0 ? -jitter_us : jitter_us;
+        stats->jitter_count++;
+        stats->jitter_hist[period_stats_bucket(jitter_us < 0 ? -jitter_us : jitter_us)]++;
+        /* a whole buffer elapsed between two periods, the DSP side must have run dry */
+        if (stats->buffer_us && interval_us > stats->buffer_us)
+            stats->late++;
+    }
+    stats->last_us = end_us;
+}
+
+void period_stats_record_rtt(struct period_stats *stats, uint64_t rtt_us)
+{
+    stats->rtt_count++;
+    if (rtt_us < stats->rtt_min_us)
+        stats->rtt_min_us = rtt_us;
+    if (rtt_us > stats->rtt_max_us)
+        stats->rtt_max_us = rtt_us;
+    stats->rtt_sum_us += rtt_us;
+}
+
+static void period_stats_print_hist(const char *title, uint64_t *hist, uint64_t total)
+{
+    unsigned int i, j, width;
+    uint64_t lo;
+
+    if (!total)
+        return;
+
+    printf("  %s\n", title);
+    for (i = 0; i < PERIOD_HIST_BUCKETS; i++) {
+        if (!hist[i])
+            continue;
+        lo = i ? 1ULL << (i - 1) : 0;
+        if (i == PERIOD_HIST_BUCKETS - 1)
+            printf("    >= %8" PRIu64 " us", lo);
+        else
+            printf("    %8" PRIu64 "-%-8" PRIu64 " us", lo, (uint64_t)(1ULL << i) - 1);
+        printf(" %8" PRIu64 " ", hist[i]);
+        width = (unsigned int)(hist[i] * 50 / total);
+        for (j = 0; j < (width ? width : 1); j++)
+            printf("#");
+        printf("\n");
+    }
+}
+
+void period_stats_print(struct period_stats *stats)
+{
+    printf("%s: period %" PRIu64 " us, buffer %" PRIu64 " us, %" PRIu64 " calls\n",
+           stats->name, stats->period_us, stats->buffer_us, stats->calls);
+    if (!stats->calls)
+        return;
+
+    printf("  call duration: min %" PRIu64 " mean %" PRIu64 " max %" PRIu64 " us\n",
+           stats->call_min_us, stats->call_sum_us / stats->calls, stats->call_max_us);
+    if (stats->jitter_count)
+        printf("  wakeup jitter: min %" PRId64 " mean |%" PRIu64 "| max %" PRId64 " us\n",
+               stats->jitter_min_us, stats->jitter_abs_sum_us / stats->jitter_count,
+               stats->jitter_max_us);
+    printf("  xruns: %" PRIu64 " reported, %" PRIu64 " late periods\n",
+           stats->xruns, stats->late);
+    if (stats->rtt_count)
+        printf("  round trip: %" PRIu64 " impulses, min %" PRIu64 " mean %" PRIu64
+               " max %" PRIu64 " us\n", stats->rtt_count, stats->rtt_min_us,
+               stats->rtt_sum_us / stats->rtt_count, stats->rtt_max_us);
+
+    period_stats_print_hist("call duration histogram:", stats->call_hist, stats->calls);
+    period_stats_print_hist("|jitter| histogram:", stats->jitter_hist, stats->jitter_count);
+}
@@ -71,6 +71,39 @@ typedef enum {
    SLOT_MASK15 = 15,
 }slot_mask_t;
 
+/* log2 buckets in microseconds, the last one collects everything above */
+#define PERIOD_HIST_BUCKETS 21
+
+/*
+ * Per-period timing collected by the test apps in measurement mode.
+ * Every pcm_read/pcm_write of one period is recorded: how long the call
+ * blocked, and how far the interval since the previous call deviates
+ * from the ideal period (wakeup jitter).
+ */
+struct period_stats {
+    const char *name;
+    uint64_t period_us;
+    uint64_t buffer_us;
+    uint64_t last_us;
+    unsigned int warmup;
+    uint64_t calls;
+    uint64_t xruns;
+    uint64_t late;
+    uint64_t call_min_us;
+    uint64_t call_max_us;
+    uint64_t call_sum_us;
+    int64_t jitter_min_us;
+    int64_t jitter_max_us;
+    uint64_t jitter_abs_sum_us;
+    uint64_t jitter_count;
+    uint64_t call_hist[PERIOD_HIST_BUCKETS];
+    uint64_t jitter_hist[PERIOD_HIST_BUCKETS];
+    uint64_t rtt_count;
+    uint64_t rtt_min_us;
+    uint64_t rtt_max_us;
+    uint64_t rtt_sum_us;
+};
+
 int convert_char_to_hex(char *char_num);
 int set_agm_device_media_config(struct mixer *mixer, unsigned int channels,
                                 unsigned int rate, unsigned int bits, char *intf_name);
@@ -100,4 +133,10 @@ int get_device_media_config(char* filename, char *intf_name, struct device_confi
 int get_group_device_info(char* filename, char *intf_name, struct group_config *config);
 int configure_mfc(struct mixer *mixer, int device, char *intf_name, int tag, enum stream_type stype, unsigned int rate,
                        unsigned int channels, unsigned int bits, uint32_t miid);
+uint64_t period_stats_now_us(void);
+void period_stats_init(struct period_stats *stats, const char *name, unsigned int period_size,
+                       unsigned int period_count, unsigned int rate);
+void period_stats_record(struct period_stats *stats, uint64_t begin_us, uint64_t end_us, int ret);
+void period_stats_record_rtt(struct period_stats *stats, uint64_t rtt_us);
+void period_stats_print(struct period_stats *stats);
 #endif
@@ -72,7 +72,8 @@ static int close = 0;
 
 void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned int *device_kv,
                  unsigned int stream_kv, unsigned int instance_kv, unsigned int *devicepp_kv,
-                 struct chunk_fmt fmt, bool haptics, char **intf_name, int intf_num);
+                 struct chunk_fmt fmt, bool haptics, char **intf_name, int intf_num,
+                 bool measure);
 
 void stream_close(int sig)
 {
@@ -89,7 +90,8 @@ static void usage(void)
            " [-dkv device_kv] : Can be multiple if num_intf is more than 1\n"
            " [-dppkv deviceppkv] : Assign 0 if no device pp in the graph\n"
            " [-ikv instance_kv] :  Assign 0 if no instance kv in the graph\n"
-           " [-skv stream_kv] [-h haptics usecase]\n");
+           " [-skv stream_kv] [-h haptics usecase]\n"
+           " [-m] : measure per-period write timing, jitter and xruns\n");
 }
 
 int main(int argc, char **argv)
@@ -105,6 +107,7 @@ int main(int argc, char **argv)
     unsigned int stream_kv = 0;
     unsigned int instance_kv = INSTANCE_1;
     bool haptics = false;
+    bool measure = false;
     char **intf_name = NULL;
     char *filename;
     int more_chunks = 1, ret = 0;
@@ -226,6 +229,8 @@ int main(int argc, char **argv)
                     devicepp_kv[i] = convert_char_to_hex(*argv);
                 }
             }
+        } else if (strcmp(*argv, "-m") == 0) {
+            measure = true;
         } else if (strcmp(*argv, "-help") == 0) {
             usage();
         }
@@ -237,7 +242,7 @@ int main(int argc, char **argv)
         return 1;
 
     play_sample(file, card, device, device_kv, stream_kv, instance_kv, devicepp_kv,
-                 chunk_fmt, haptics, intf_name, intf_num);
+                 chunk_fmt, haptics, intf_name, intf_num, measure);
 
     fclose(file);
     if (device_kv)
@@ -252,7 +257,8 @@ int main(int argc, char **argv)
 
 void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned int *device_kv,
                  unsigned int stream_kv, unsigned int instance_kv, unsigned int *devicepp_kv,
-                 struct chunk_fmt fmt, bool haptics, char **intf_name, int intf_num)
+                 struct chunk_fmt fmt, bool haptics, char **intf_name, int intf_num,
+                 bool measure)
 {
     struct pcm_config config;
     struct pcm *pcm;
@@ -264,6 +270,8 @@ void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned in
     struct group_config *grp_config = NULL;
     struct device_config *dev_config = NULL;
     uint32_t miid = 0;
+    struct period_stats stats;
+    uint64_t begin_us;
 
     grp_config = (struct group_config *) malloc(intf_num * sizeof(struct group_config));
     if (!grp_config) {
@@ -376,7 +384,8 @@ void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned in
         }
     }
 
-    pcm = pcm_open(card, device, PCM_OUT, &config);
+    /* in measurement mode surface underruns instead of restarting silently */
+    pcm = pcm_open(card, device, PCM_OUT | (measure ? PCM_NORESTART : 0), &config);
     if (!pcm || !pcm_is_ready(pcm)) {
         printf("Unable to open PCM device %u (%s)\n",
                 device, pcm_get_error(pcm));
@@ -391,7 +400,11 @@ void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned in
         }
     }
 
-    size = pcm_frames_to_bytes(pcm, pcm_get_buffer_size(pcm));
+    /* write one period at a time so each call can be timed */
+    if (measure)
+        size = pcm_frames_to_bytes(pcm, config.period_size);
+    else
+        size = pcm_frames_to_bytes(pcm, pcm_get_buffer_size(pcm));
     buffer = malloc(size);
     if (!buffer) {
         printf("Unable to allocate %d bytes\n", size);
@@ -409,16 +422,34 @@ void play_sample(FILE *file, unsigned int card, unsigned int device, unsigned in
     /* catch ctrl-c to shutdown cleanly */
     signal(SIGINT, stream_close);
 
+    if (measure)
+        period_stats_init(&stats, "agmplay", config.period_size, config.period_count,
+                          config.rate);
+
     do {
         num_read = fread(buffer, 1, size, file);
         if (num_read > 0) {
-            if (pcm_write(pcm, buffer, num_read)) {
+            if (measure) {
+                begin_us = period_stats_now_us();
+                ret = pcm_write(pcm, buffer, num_read);
+                period_stats_record(&stats, begin_us, period_stats_now_us(), ret);
+                if (ret == -EPIPE) {
+                    pcm_prepare(pcm);
+                    continue;
+                }
+            } else {
+                ret = pcm_write(pcm, buffer, num_read);
+            }
+            if (ret) {
                 printf("Error playing sample\n");
                 break;
             }
         }
     } while (!close && num_read > 0);
 
+    if (measure)
+        period_stats_print(&stats);
+
     pcm_stop(pcm);
     /* disconnect pcm stream to audio intf */
     for (index = 0; index < intf_num; index++) {
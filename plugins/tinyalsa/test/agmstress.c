@@ -0,0 +1,1094 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * agmstress: runs a mix of playback, capture, compress and hostless
+ * streams described by a scenario file on a pool of worker threads.
+ * Every stream repeatedly goes through setup, open, start, a random
+ * "on" time with optional device switch and set_param traffic, stop and
+ * close, then rests for a random "off" time. Aggregate throughput,
+ * control operation latency and failures are reported periodically.
+ *
+ * Scenario file, one directive per line, '#' starts a comment:
+ *
+ *   threads <n>          worker threads, default 4
+ *   duration <sec>       0 runs until interrupted, default 60
+ *   report <sec>         report interval, default 5
+ *   seed <n>             random seed, default time based
+ *   card <n>             sound card, default 100
+ *   stream <type> <count> <device> <intf> <dkv> [key=value ...]
+ *
+ * <type> is playback, capture, compress or hostless. <count> instances
+ * are created on consecutive devices starting at <device>. Keys:
+ *
+ *   skv=<hex> ikv=<hex>              stream and instance kv
+ *   rate=<n> ch=<n> bits=<n>         stream media format
+ *   period=<frames> periods=<n>      pcm buffer
+ *   frag=<bytes> frags=<n>           compress buffer
+ *   on=<min>[-<max>] off=<min>[-<max>]  run and rest time in ms
+ *   switch=<intf>:<dkv>              switch to this interface once per run
+ *   param=<file> param_ms=<ms>       setParam payload sent every param_ms
+ *   file=<path>                      compress: MP3 data, looped
+ *   cdev=<n> cintf=<intf> cdkv=<hex> hostless: capture side
+ */
+
+#include <errno.h>
+#include <tinyalsa/asoundlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef AGMSTRESS_COMPRESS
+#include <sound/compress_params.h>
+#include <tinycompress/tinycompress.h>
+#endif
+
+#include "agmmixer.h"
+
+#define MAX_STREAM_CLASSES  32
+#define MAX_STREAMS         256
+#define MAX_THREADS         64
+#define NAME_LEN            80
+#define PATH_LEN            256
+#define IDLE_POLL_US        10000
+#define HOSTLESS_POLL_US    20000
+
+enum stress_type {
+    STRESS_PLAYBACK,
+    STRESS_CAPTURE,
+    STRESS_COMPRESS,
+    STRESS_HOSTLESS,
+    STRESS_TYPE_MAX,
+};
+
+static const char *stress_type_name[STRESS_TYPE_MAX] = {
+    "playback", "capture", "compress", "hostless",
+};
+
+enum stress_op {
+    OP_SETUP,
+    OP_OPEN,
+    OP_START,
+    OP_STOP,
+    OP_CLOSE,
+    OP_SWITCH,
+    OP_SET_PARAM,
+    OP_MAX,
+};
+
+static const char *stress_op_name[OP_MAX] = {
+    "setup", "open", "start", "stop", "close", "switch", "set_param",
+};
+
+struct op_stats {
+    uint64_t count;
+    uint64_t failures;
+    uint64_t sum_us;
+    uint64_t max_us;
+};
+
+struct stress_stats {
+    struct op_stats ops[OP_MAX];
+    uint64_t cycles;
+    uint64_t bytes;
+    uint64_t io_failures;
+};
+
+struct stress_class {
+    enum stress_type type;
+    unsigned int count;
+    unsigned int device;
+    unsigned int c_device;
+    char intf[NAME_LEN];
+    char c_intf[NAME_LEN];
+    char switch_intf[NAME_LEN];
+    uint32_t dkv;
+    uint32_t c_dkv;
+    uint32_t switch_dkv;
+    uint32_t skv;
+    uint32_t instance_kv;
+    struct device_config intf_config;
+    struct device_config c_intf_config;
+    struct device_config switch_config;
+    unsigned int rate;
+    unsigned int channels;
+    unsigned int bits;
+    unsigned int period_size;
+    unsigned int period_count;
+    unsigned int frag_size;
+    unsigned int frags;
+    unsigned int on_min_ms;
+    unsigned int on_max_ms;
+    unsigned int off_min_ms;
+    unsigned int off_max_ms;
+    unsigned int param_ms;
+    void *param;
+    int param_size;
+    char file[PATH_LEN];
+};
+
+struct stress_stream {
+    struct stress_class *cls;
+    unsigned int device;
+    unsigned int c_device;
+    bool busy;
+    uint64_t next_us;
+};
+
+struct stress_worker {
+    pthread_t thread;
+    unsigned int seed;
+    struct mixer *mixer;
+};
+
+static struct stress_class classes[MAX_STREAM_CLASSES];
+static unsigned int num_classes;
+static struct stress_stream streams[MAX_STREAMS];
+static unsigned int num_streams;
+static unsigned int next_stream;
+static unsigned int active_streams;
+static pthread_mutex_t stream_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct stress_stats stats_total;
+static struct stress_stats stats_interval;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int card = 100;
+static unsigned int num_threads = 4;
+static unsigned int duration_s = 60;
+static unsigned int report_s = 5;
+static unsigned int seed;
+static volatile int stop_f;
+
+static void sigint_handler(int sig)
+{
+    stop_f = 1;
+}
+
+static void usage(void)
+{
+    printf(" Usage: agmstress scenario_file [-help print usage] [-D card]\n"
+           " [-t threads] [-T duration] [-R report_interval] [-s seed]\n"
+           " Command line options override the scenario file.\n");
+}
+
+static unsigned int rand_between(struct stress_worker *w, unsigned int min, unsigned int max)
+{
+    if (max <= min)
+        return min;
+    return min + rand_r(&w->seed) % (max - min + 1);
+}
+
+static void stats_op(enum stress_op op, uint64_t begin_us, int ret)
+{
+    uint64_t us = period_stats_now_us() - begin_us;
+    struct op_stats *stats[2] = { &stats_total.ops[op], &stats_interval.ops[op] };
+    int i;
+
+    pthread_mutex_lock(&stats_lock);
+    for (i = 0; i < 2; i++) {
+        stats[i]->count++;
+        stats[i]->sum_us += us;
+        if (us > stats[i]->max_us)
+            stats[i]->max_us = us;
+        if (ret)
+            stats[i]->failures++;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void stats_io(unsigned int bytes, bool failed)
+{
+    pthread_mutex_lock(&stats_lock);
+    stats_total.bytes += bytes;
+    stats_interval.bytes += bytes;
+    if (failed) {
+        stats_total.io_failures++;
+        stats_interval.io_failures++;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static uint64_t stats_failures(struct stress_stats *stats)
+{
+    uint64_t failures = stats->io_failures;
+    int op;
+
+    for (op = 0; op < OP_MAX; op++)
+        failures += stats->ops[op].failures;
+    return failures;
+}
+
+static void stats_print(struct stress_stats *stats, const char *title, uint64_t elapsed_us,
+                        uint64_t span_us, unsigned int active)
+{
+    struct op_stats *ops;
+    int op;
+
+    printf("[%7.1fs] %s: active %u cycles %llu io %.2f KB/s failures %llu (io %llu)\n",
+           elapsed_us / 1000000.0, title, active, (unsigned long long)stats->cycles,
+           span_us ? stats->bytes * 1000000.0 / span_us / 1024 : 0.0,
+           (unsigned long long)stats_failures(stats),
+           (unsigned long long)stats->io_failures);
+    for (op = 0; op < OP_MAX; op++) {
+        ops = &stats->ops[op];
+        if (!ops->count)
+            continue;
+        printf("    %-10s n=%-7llu mean=%-7llu max=%-7llu us fail=%llu\n",
+               stress_op_name[op], (unsigned long long)ops->count,
+               (unsigned long long)(ops->sum_us / ops->count),
+               (unsigned long long)ops->max_us, (unsigned long long)ops->failures);
+    }
+}
+
+/* media config and metadata of one audio interface, before it is connected */
+static int intf_configure(struct mixer *mixer, char *intf, uint32_t dkv,
+                          struct device_config *config, enum usecase_type usecase,
+                          uint32_t skv)
+{
+    if (set_agm_device_media_config(mixer, config->ch, config->rate, config->bits, intf))
+        return -EINVAL;
+    if (set_agm_audio_intf_metadata(mixer, intf, dkv, usecase, config->rate,
+                                    config->bits, skv))
+        return -EINVAL;
+    return 0;
+}
+
+/* make before break: connect the new interface, then drop the old one */
+static int stream_switch(struct mixer *mixer, struct stress_stream *s, enum usecase_type usecase,
+                         enum stream_type stype, uint32_t skv)
+{
+    struct stress_class *cls = s->cls;
+    uint64_t begin_us = period_stats_now_us();
+    int ret;
+
+    ret = intf_configure(mixer, cls->switch_intf, cls->switch_dkv, &cls->switch_config,
+                         usecase, skv);
+    if (!ret && connect_agm_audio_intf_to_stream(mixer, s->device, cls->switch_intf,
+                                                 stype, true))
+        ret = -EIO;
+    if (!ret && connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, stype, false)) {
+        connect_agm_audio_intf_to_stream(mixer, s->device, cls->switch_intf, stype, false);
+        ret = -EIO;
+    }
+    stats_op(OP_SWITCH, begin_us, ret);
+    return ret;
+}
+
+static void stream_set_param(struct mixer *mixer, struct stress_stream *s,
+                             enum stream_type stype)
+{
+    uint64_t begin_us = period_stats_now_us();
+    int ret;
+
+    ret = agm_mixer_set_param(mixer, s->device, stype, s->cls->param, s->cls->param_size);
+    stats_op(OP_SET_PARAM, begin_us, ret);
+}
+
+/*
+ * State of one "on" period. The caller moves data in between
+ * stream_run_step() calls, which fire the switch and set_param events
+ * when they are due. intf tracks the interface connected right now.
+ */
+struct stream_run_ctx {
+    struct stress_worker *w;
+    struct stress_stream *s;
+    enum usecase_type usecase;
+    enum stream_type stype;
+    uint32_t skv;
+    uint64_t end_us;
+    uint64_t switch_us;
+    uint64_t param_us;
+    char *intf;
+};
+
+static void stream_run_init(struct stream_run_ctx *ctx, struct stress_worker *w,
+                            struct stress_stream *s, enum usecase_type usecase,
+                            enum stream_type stype, uint32_t skv)
+{
+    struct stress_class *cls = s->cls;
+    uint64_t now_us = period_stats_now_us();
+    uint64_t on_us = rand_between(w, cls->on_min_ms, cls->on_max_ms) * 1000ULL;
+
+    ctx->w = w;
+    ctx->s = s;
+    ctx->usecase = usecase;
+    ctx->stype = stype;
+    ctx->skv = skv;
+    ctx->end_us = now_us + on_us;
+    ctx->switch_us = cls->switch_intf[0] ?
+            now_us + (on_us ? rand_r(&w->seed) % on_us : 0) : 0;
+    ctx->param_us = cls->param ? now_us + cls->param_ms * 1000ULL : 0;
+    ctx->intf = cls->intf;
+}
+
+/* handles the control events due now, false once the run is over */
+static bool stream_run_step(struct stream_run_ctx *ctx)
+{
+    struct stress_class *cls = ctx->s->cls;
+    uint64_t now_us = period_stats_now_us();
+
+    if (stop_f || now_us >= ctx->end_us)
+        return false;
+
+    if (ctx->switch_us && now_us >= ctx->switch_us) {
+        if (!stream_switch(ctx->w->mixer, ctx->s, ctx->usecase, ctx->stype, ctx->skv))
+            ctx->intf = cls->switch_intf;
+        ctx->switch_us = 0;
+    }
+    if (ctx->param_us && now_us >= ctx->param_us) {
+        stream_set_param(ctx->w->mixer, ctx->s, ctx->stype);
+        ctx->param_us = now_us + cls->param_ms * 1000ULL;
+    }
+    return true;
+}
+
+static void run_pcm(struct stress_worker *w, struct stress_stream *s)
+{
+    struct stress_class *cls = s->cls;
+    struct mixer *mixer = w->mixer;
+    bool playback = cls->type == STRESS_PLAYBACK;
+    enum usecase_type usecase = playback ? PLAYBACK : CAPTURE;
+    uint32_t skv = cls->skv ? cls->skv : (playback ? PCM_LL_PLAYBACK : PCM_RECORD);
+    struct stream_run_ctx ctx;
+    struct pcm_config config;
+    struct pcm *pcm;
+    char *intf = cls->intf;
+    char *buffer = NULL;
+    unsigned int size;
+    uint64_t begin_us;
+    int ret;
+
+    begin_us = period_stats_now_us();
+    ret = intf_configure(mixer, cls->intf, cls->dkv, &cls->intf_config, usecase, skv);
+    if (!ret) {
+        if (playback)
+            ret = set_agm_stream_metadata(mixer, s->device, skv, PLAYBACK, STREAM_PCM,
+                                          cls->instance_kv);
+        else
+            ret = set_agm_capture_stream_metadata(mixer, s->device, skv, CAPTURE, STREAM_PCM,
+                                                  cls->instance_kv);
+    }
+    if (!ret)
+        ret = connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, STREAM_PCM, true);
+    stats_op(OP_SETUP, begin_us, ret);
+    if (ret)
+        return;
+
+    memset(&config, 0, sizeof(config));
+    config.channels = cls->channels;
+    config.rate = cls->rate;
+    config.period_size = cls->period_size;
+    config.period_count = cls->period_count;
+    config.format = cls->bits == 32 ? PCM_FORMAT_S32_LE :
+                    cls->bits == 24 ? PCM_FORMAT_S24_LE : PCM_FORMAT_S16_LE;
+
+    begin_us = period_stats_now_us();
+    pcm = pcm_open(card, s->device, playback ? PCM_OUT : PCM_IN, &config);
+    ret = (pcm && pcm_is_ready(pcm)) ? 0 : -EIO;
+    stats_op(OP_OPEN, begin_us, ret);
+    if (ret) {
+        if (pcm)
+            pcm_close(pcm);
+        goto disconnect;
+    }
+
+    size = pcm_frames_to_bytes(pcm, config.period_size);
+    buffer = calloc(1, size);
+    if (!buffer)
+        goto close;
+
+    begin_us = period_stats_now_us();
+    ret = pcm_start(pcm);
+    stats_op(OP_START, begin_us, ret);
+    if (ret)
+        goto close;
+
+    stream_run_init(&ctx, w, s, usecase, STREAM_PCM, skv);
+    while (stream_run_step(&ctx)) {
+        if (playback)
+            ret = pcm_write(pcm, buffer, size);
+        else
+            ret = pcm_read(pcm, buffer, size);
+        stats_io(ret ? 0 : size, ret != 0);
+        if (ret)
+            break;
+    }
+    intf = ctx.intf;
+
+    begin_us = period_stats_now_us();
+    ret = pcm_stop(pcm);
+    stats_op(OP_STOP, begin_us, ret);
+close:
+    begin_us = period_stats_now_us();
+    ret = pcm_close(pcm);
+    stats_op(OP_CLOSE, begin_us, ret);
+disconnect:
+    connect_agm_audio_intf_to_stream(mixer, s->device, intf, STREAM_PCM, false);
+    free(buffer);
+}
+
+static void run_hostless(struct stress_worker *w, struct stress_stream *s)
+{
+    struct stress_class *cls = s->cls;
+    struct mixer *mixer = w->mixer;
+    uint32_t skv = cls->skv ? cls->skv : PCM_RX_LOOPBACK;
+    struct stream_run_ctx ctx;
+    struct pcm_config config;
+    struct pcm *p_pcm, *c_pcm;
+    char *intf = cls->intf;
+    uint64_t begin_us;
+    int ret;
+
+    begin_us = period_stats_now_us();
+    ret = intf_configure(mixer, cls->intf, cls->dkv, &cls->intf_config, PLAYBACK, skv);
+    if (!ret)
+        ret = intf_configure(mixer, cls->c_intf, cls->c_dkv, &cls->c_intf_config, CAPTURE, skv);
+    if (!ret)
+        ret = set_agm_stream_metadata(mixer, s->device, skv, LOOPBACK, STREAM_PCM, 0);
+    if (!ret)
+        ret = connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, STREAM_PCM, true);
+    if (!ret) {
+        ret = connect_agm_audio_intf_to_stream(mixer, s->c_device, cls->c_intf, STREAM_PCM, true);
+        if (ret)
+            connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, STREAM_PCM, false);
+    }
+    if (!ret && connect_play_pcm_to_cap_pcm(mixer, s->device, s->c_device)) {
+        connect_agm_audio_intf_to_stream(mixer, s->c_device, cls->c_intf, STREAM_PCM, false);
+        connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, STREAM_PCM, false);
+        ret = -EIO;
+    }
+    stats_op(OP_SETUP, begin_us, ret);
+    if (ret)
+        return;
+
+    memset(&config, 0, sizeof(config));
+    config.channels = cls->channels;
+    config.rate = cls->rate;
+    config.period_size = cls->period_size;
+    config.period_count = cls->period_count;
+    config.format = cls->bits == 32 ? PCM_FORMAT_S32_LE :
+                    cls->bits == 24 ? PCM_FORMAT_S24_LE : PCM_FORMAT_S16_LE;
+
+    begin_us = period_stats_now_us();
+    p_pcm = pcm_open(card, s->device, PCM_OUT, &config);
+    c_pcm = pcm_open(card, s->c_device, PCM_IN, &config);
+    ret = (p_pcm && pcm_is_ready(p_pcm) && c_pcm && pcm_is_ready(c_pcm)) ? 0 : -EIO;
+    stats_op(OP_OPEN, begin_us, ret);
+    if (ret)
+        goto close;
+
+    begin_us = period_stats_now_us();
+    ret = pcm_start(p_pcm);
+    if (!ret)
+        ret = pcm_start(c_pcm);
+    stats_op(OP_START, begin_us, ret);
+    if (ret)
+        goto close;
+
+    /* no host data, the DSP moves it from the capture to the playback device */
+    stream_run_init(&ctx, w, s, PLAYBACK, STREAM_PCM, skv);
+    while (stream_run_step(&ctx))
+        usleep(HOSTLESS_POLL_US);
+    intf = ctx.intf;
+
+    begin_us = period_stats_now_us();
+    ret = pcm_stop(c_pcm);
+    if (pcm_stop(p_pcm))
+        ret = -EIO;
+    stats_op(OP_STOP, begin_us, ret);
+close:
+    begin_us = period_stats_now_us();
+    if (c_pcm)
+        pcm_close(c_pcm);
+    if (p_pcm)
+        pcm_close(p_pcm);
+    stats_op(OP_CLOSE, begin_us, 0);
+    connect_play_pcm_to_cap_pcm(mixer, -1, s->c_device);
+    connect_agm_audio_intf_to_stream(mixer, s->c_device, cls->c_intf, STREAM_PCM, false);
+    connect_agm_audio_intf_to_stream(mixer, s->device, intf, STREAM_PCM, false);
+}
+
+#ifdef AGMSTRESS_COMPRESS
+static void run_compress(struct stress_worker *w, struct stress_stream *s)
+{
+    struct stress_class *cls = s->cls;
+    struct mixer *mixer = w->mixer;
+    uint32_t skv = cls->skv ? cls->skv : COMPRESSED_OFFLOAD_PLAYBACK;
+    struct stream_run_ctx ctx;
+    struct compr_config config;
+    struct snd_codec codec;
+    struct compress *compress;
+    char *intf = cls->intf;
+    char *buffer = NULL;
+    bool started = false;
+    uint64_t begin_us;
+    FILE *file;
+    int ret, num_read, wrote;
+
+    file = fopen(cls->file, "rb");
+    if (!file) {
+        printf("Unable to open file '%s'\n", cls->file);
+        stats_io(0, true);
+        return;
+    }
+
+    begin_us = period_stats_now_us();
+    ret = intf_configure(mixer, cls->intf, cls->dkv, &cls->intf_config, PLAYBACK, skv);
+    if (!ret)
+        ret = set_agm_stream_metadata(mixer, s->device, skv, PLAYBACK, STREAM_COMPRESS,
+                                      cls->instance_kv);
+    if (!ret)
+        ret = connect_agm_audio_intf_to_stream(mixer, s->device, cls->intf, STREAM_COMPRESS,
+                                               true);
+    stats_op(OP_SETUP, begin_us, ret);
+    if (ret)
+        goto done;
+
+    memset(&codec, 0, sizeof(codec));
+    memset(&config, 0, sizeof(config));
+    codec.id = SND_AUDIOCODEC_MP3;
+    codec.ch_in = cls->channels;
+    codec.ch_out = cls->channels;
+    codec.sample_rate = cls->rate;
+    codec.bit_rate = cls->bits;
+    config.fragment_size = cls->frag_size;
+    config.fragments = cls->frags;
+    config.codec = &codec;
+
+    begin_us = period_stats_now_us();
+    compress = compress_open(card, s->device, COMPRESS_IN, &config);
+    ret = (compress && is_compress_ready(compress)) ? 0 : -EIO;
+    stats_op(OP_OPEN, begin_us, ret);
+    if (ret) {
+        if (compress)
+            compress_close(compress);
+        goto disconnect;
+    }
+
+    buffer = malloc(cls->frag_size);
+    if (!buffer)
+        goto close;
+
+    stream_run_init(&ctx, w, s, PLAYBACK, STREAM_COMPRESS, skv);
+    while (stream_run_step(&ctx)) {
+        num_read = fread(buffer, 1, cls->frag_size, file);
+        if (num_read <= 0) {
+            rewind(file);
+            continue;
+        }
+        wrote = compress_write(compress, buffer, num_read);
+        stats_io(wrote < 0 ? 0 : wrote, wrote < 0);
+        if (wrote < 0)
+            break;
+        /* the first fragment primes the buffer, then the stream is started */
+        if (!started) {
+            begin_us = period_stats_now_us();
+            ret = compress_start(compress);
+            stats_op(OP_START, begin_us, ret);
+            if (ret)
+                break;
+            started = true;
+        }
+    }
+    intf = ctx.intf;
+
+    if (started) {
+        begin_us = period_stats_now_us();
+        ret = compress_stop(compress);
+        stats_op(OP_STOP, begin_us, ret);
+    }
+close:
+    begin_us = period_stats_now_us();
+    compress_close(compress);
+    stats_op(OP_CLOSE, begin_us, 0);
+disconnect:
+    connect_agm_audio_intf_to_stream(mixer, s->device, intf, STREAM_COMPRESS, false);
+done:
+    free(buffer);
+    fclose(file);
+}
+#endif
+
+static struct stress_stream *stream_claim(void)
+{
+    uint64_t now_us = period_stats_now_us();
+    struct stress_stream *s = NULL;
+    unsigned int i, index;
+
+    pthread_mutex_lock(&stream_lock);
+    for (i = 0; i < num_streams; i++) {
+        index = (next_stream + i) % num_streams;
+        if (!streams[index].busy && streams[index].next_us <= now_us) {
+            s = &streams[index];
+            s->busy = true;
+            next_stream = index + 1;
+            active_streams++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&stream_lock);
+    return s;
+}
+
+static void stream_release(struct stress_worker *w, struct stress_stream *s)
+{
+    unsigned int off_ms = rand_between(w, s->cls->off_min_ms, s->cls->off_max_ms);
+
+    pthread_mutex_lock(&stream_lock);
+    s->busy = false;
+    s->next_us = period_stats_now_us() + off_ms * 1000ULL;
+    active_streams--;
+    pthread_mutex_unlock(&stream_lock);
+
+    pthread_mutex_lock(&stats_lock);
+    stats_total.cycles++;
+    stats_interval.cycles++;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void *worker_thread(void *arg)
+{
+    struct stress_worker *w = arg;
+    struct stress_stream *s;
+
+    /* one mixer per worker, controls of different streams never share it */
+    w->mixer = mixer_open(card);
+    if (!w->mixer) {
+        printf("Failed to open mixer\n");
+        return NULL;
+    }
+
+    while (!stop_f) {
+        s = stream_claim();
+        if (!s) {
+            usleep(IDLE_POLL_US);
+            continue;
+        }
+
+        switch (s->cls->type) {
+        case STRESS_PLAYBACK:
+        case STRESS_CAPTURE:
+            run_pcm(w, s);
+            break;
+        case STRESS_HOSTLESS:
+            run_hostless(w, s);
+            break;
+#ifdef AGMSTRESS_COMPRESS
+        case STRESS_COMPRESS:
+            run_compress(w, s);
+            break;
+#endif
+        default:
+            break;
+        }
+        stream_release(w, s);
+    }
+
+    mixer_close(w->mixer);
+    return NULL;
+}
+
+static int parse_range(char *val, unsigned int *min, unsigned int *max)
+{
+    char *end;
+
+    *min = strtoul(val, &end, 0);
+    if (*end == '-')
+        *max = strtoul(end + 1, &end, 0);
+    else
+        *max = *min;
+    return (*end || *max < *min) ? -EINVAL : 0;
+}
+
+static int load_param(struct stress_class *cls, char *path)
+{
+    FILE *fp;
+    long size;
+    int ret = 0;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        printf("Unable to open file '%s'\n", path);
+        return -ENOENT;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    free(cls->param);
+    cls->param = size > 0 ? malloc(size) : NULL;
+    if (!cls->param || fread(cls->param, 1, size, fp) != (size_t)size) {
+        free(cls->param);
+        cls->param = NULL;
+        ret = -EINVAL;
+    } else {
+        cls->param_size = size;
+    }
+    fclose(fp);
+    return ret;
+}
+
+static int parse_stream_key(struct stress_class *cls, char *key)
+{
+    char *val = strchr(key, '=');
+    char *sep;
+
+    if (!val)
+        return -EINVAL;
+    *val++ = '\0';
+
+    if (strcmp(key, "skv") == 0) {
+        cls->skv = convert_char_to_hex(val);
+    } else if (strcmp(key, "ikv") == 0) {
+        cls->instance_kv = convert_char_to_hex(val);
+    } else if (strcmp(key, "rate") == 0) {
+        cls->rate = atoi(val);
+    } else if (strcmp(key, "ch") == 0) {
+        cls->channels = atoi(val);
+    } else if (strcmp(key, "bits") == 0) {
+        cls->bits = atoi(val);
+    } else if (strcmp(key, "period") == 0) {
+        cls->period_size = atoi(val);
+    } else if (strcmp(key, "periods") == 0) {
+        cls->period_count = atoi(val);
+    } else if (strcmp(key, "frag") == 0) {
+        cls->frag_size = atoi(val);
+    } else if (strcmp(key, "frags") == 0) {
+        cls->frags = atoi(val);
+    } else if (strcmp(key, "on") == 0) {
+        return parse_range(val, &cls->on_min_ms, &cls->on_max_ms);
+    } else if (strcmp(key, "off") == 0) {
+        return parse_range(val, &cls->off_min_ms, &cls->off_max_ms);
+    } else if (strcmp(key, "switch") == 0) {
+        sep = strchr(val, ':');
+        if (!sep)
+            return -EINVAL;
+        *sep++ = '\0';
+        snprintf(cls->switch_intf, NAME_LEN, "%s", val);
+        cls->switch_dkv = convert_char_to_hex(sep);
+    } else if (strcmp(key, "param") == 0) {
+        return load_param(cls, val);
+    } else if (strcmp(key, "param_ms") == 0) {
+        cls->param_ms = atoi(val);
+    } else if (strcmp(key, "file") == 0) {
+        snprintf(cls->file, PATH_LEN, "%s", val);
+    } else if (strcmp(key, "cdev") == 0) {
+        cls->c_device = atoi(val);
+    } else if (strcmp(key, "cintf") == 0) {
+        snprintf(cls->c_intf, NAME_LEN, "%s", val);
+    } else if (strcmp(key, "cdkv") == 0) {
+        cls->c_dkv = convert_char_to_hex(val);
+    } else {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/* backend media config from the conf file, the stream format if it has none */
+static void intf_media_config(struct stress_class *cls, char *intf, struct device_config *config)
+{
+    if (get_device_media_config(BACKEND_CONF_FILE, intf, config)) {
+        config->rate = cls->rate;
+        config->ch = cls->channels;
+        config->bits = cls->bits;
+    }
+}
+
+static int parse_stream(char **save)
+{
+    struct stress_class *cls;
+    struct stress_stream *s;
+    char *args[5];
+    char *key;
+    unsigned int i;
+    int type;
+
+    if (num_classes == MAX_STREAM_CLASSES)
+        return -ENOSPC;
+
+    for (i = 0; i < 5; i++) {
+        args[i] = strtok_r(NULL, " \t\r\n", save);
+        if (!args[i])
+            return -EINVAL;
+    }
+
+    for (type = 0; type < STRESS_TYPE_MAX; type++) {
+        if (strcmp(args[0], stress_type_name[type]) == 0)
+            break;
+    }
+    if (type == STRESS_TYPE_MAX)
+        return -EINVAL;
+
+    cls = &classes[num_classes];
+    memset(cls, 0, sizeof(*cls));
+    cls->type = type;
+    cls->count = atoi(args[1]);
+    cls->device = atoi(args[2]);
+    snprintf(cls->intf, NAME_LEN, "%s", args[3]);
+    cls->dkv = convert_char_to_hex(args[4]);
+    cls->instance_kv = type == STRESS_HOSTLESS ? 0 : INSTANCE_1;
+    cls->rate = 48000;
+    cls->channels = 2;
+    cls->bits = 16;
+    cls->period_size = 1024;
+    cls->period_count = 4;
+    cls->frag_size = 32768;
+    cls->frags = 4;
+    cls->on_min_ms = 1000;
+    cls->on_max_ms = 5000;
+    cls->off_min_ms = 200;
+    cls->off_max_ms = 1000;
+    cls->param_ms = 500;
+
+    while ((key = strtok_r(NULL, " \t\r\n", save))) {
+        if (parse_stream_key(cls, key)) {
+            printf("Invalid stream option '%s'\n", key);
+            return -EINVAL;
+        }
+    }
+
+    if (!cls->count || num_streams + cls->count > MAX_STREAMS) {
+        printf("Stream count must be 1-%d in total\n", MAX_STREAMS);
+        return -EINVAL;
+    }
+    if (type == STRESS_HOSTLESS && !cls->c_intf[0]) {
+        printf("hostless streams need cintf=\n");
+        return -EINVAL;
+    }
+    if (type == STRESS_COMPRESS) {
+#ifdef AGMSTRESS_COMPRESS
+        if (!cls->file[0]) {
+            printf("compress streams need file=\n");
+            return -EINVAL;
+        }
+#else
+        printf("compress streams are not supported in this build\n");
+        return -EINVAL;
+#endif
+    }
+    if (cls->param && !cls->param_ms) {
+        printf("param_ms must not be 0\n");
+        return -EINVAL;
+    }
+
+    intf_media_config(cls, cls->intf, &cls->intf_config);
+    if (cls->switch_intf[0])
+        intf_media_config(cls, cls->switch_intf, &cls->switch_config);
+    if (cls->c_intf[0])
+        intf_media_config(cls, cls->c_intf, &cls->c_intf_config);
+
+    for (i = 0; i < cls->count; i++) {
+        s = &streams[num_streams++];
+        s->cls = cls;
+        s->device = cls->device + i;
+        s->c_device = cls->c_device + i;
+    }
+    num_classes++;
+    return 0;
+}
+
+/* two streams on one device would fail each other's setup */
+static int check_devices(void)
+{
+    unsigned int devices[MAX_STREAMS * 2];
+    unsigned int num = 0, i, j;
+
+    for (i = 0; i < num_streams; i++) {
+        devices[num++] = streams[i].device;
+        if (streams[i].cls->type == STRESS_HOSTLESS)
+            devices[num++] = streams[i].c_device;
+    }
+
+    for (i = 0; i < num; i++) {
+        for (j = i + 1; j < num; j++) {
+            if (devices[i] == devices[j]) {
+                printf("Device %u is used by more than one stream\n", devices[i]);
+                return -EINVAL;
+            }
+        }
+    }
+    return 0;
+}
+
+static int parse_scenario(const char *path, bool *seed_set)
+{
+    FILE *fp;
+    char line[1024];
+    char *tok, *val, *save;
+    unsigned int lineno = 0;
+    int ret = 0;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        printf("Unable to open scenario '%s'\n", path);
+        return -ENOENT;
+    }
+
+    while (!ret && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        tok = strchr(line, '#');
+        if (tok)
+            *tok = '\0';
+        tok = strtok_r(line, " \t\r\n", &save);
+        if (!tok)
+            continue;
+
+        if (strcmp(tok, "stream") == 0) {
+            ret = parse_stream(&save);
+        } else {
+            val = strtok_r(NULL, " \t\r\n", &save);
+            if (!val)
+                ret = -EINVAL;
+            else if (strcmp(tok, "threads") == 0)
+                num_threads = atoi(val);
+            else if (strcmp(tok, "duration") == 0)
+                duration_s = atoi(val);
+            else if (strcmp(tok, "report") == 0)
+                report_s = atoi(val);
+            else if (strcmp(tok, "card") == 0)
+                card = atoi(val);
+            else if (strcmp(tok, "seed") == 0) {
+                seed = strtoul(val, NULL, 0);
+                *seed_set = true;
+            } else
+                ret = -EINVAL;
+        }
+        if (ret)
+            printf("%s:%u: invalid line\n", path, lineno);
+    }
+    fclose(fp);
+
+    if (!ret && !num_streams) {
+        printf("%s: no streams\n", path);
+        ret = -EINVAL;
+    }
+    if (!ret)
+        ret = check_devices();
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    struct stress_worker workers[MAX_THREADS];
+    struct stress_stats interval;
+    struct stress_class *cls;
+    uint64_t start_us, last_us, now_us, next_report_us;
+    unsigned int i, active, started = 0;
+    bool seed_set = false;
+    int ret;
+
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (parse_scenario(argv[1], &seed_set))
+        return 1;
+
+    /* parse command line arguments */
+    argv += 2;
+    while (*argv) {
+        if (strcmp(*argv, "-D") == 0) {
+            argv++;
+            if (*argv)
+                card = atoi(*argv);
+        } else if (strcmp(*argv, "-t") == 0) {
+            argv++;
+            if (*argv)
+                num_threads = atoi(*argv);
+        } else if (strcmp(*argv, "-T") == 0) {
+            argv++;
+            if (*argv)
+                duration_s = atoi(*argv);
+        } else if (strcmp(*argv, "-R") == 0) {
+            argv++;
+            if (*argv)
+                report_s = atoi(*argv);
+        } else if (strcmp(*argv, "-s") == 0) {
+            argv++;
+            if (*argv) {
+                seed = strtoul(*argv, NULL, 0);
+                seed_set = true;
+            }
+        } else if (strcmp(*argv, "-help") == 0) {
+            usage();
+        }
+        if (*argv)
+            argv++;
+    }
+
+    if (!num_threads || num_threads > MAX_THREADS) {
+        printf("threads must be 1-%d\n", MAX_THREADS);
+        return 1;
+    }
+    if (!seed_set)
+        seed = (unsigned int)time(NULL);
+
+    printf("agmstress: %u streams, %u threads, card %u, seed %u, duration %us\n",
+           num_streams, num_threads, card, seed, duration_s);
+    for (i = 0; i < num_classes; i++) {
+        cls = &classes[i];
+        printf("    %-8s x%-3u devices %u-%u on %s\n", stress_type_name[cls->type],
+               cls->count, cls->device, cls->device + cls->count - 1, cls->intf);
+    }
+
+    signal(SIGINT, sigint_handler);
+    signal(SIGHUP, sigint_handler);
+    signal(SIGTERM, sigint_handler);
+
+    start_us = period_stats_now_us();
+    last_us = start_us;
+    for (i = 0; i < num_threads; i++) {
+        workers[i].seed = seed + i;
+        ret = pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]);
+        if (ret) {
+            printf("Failed to create worker thread %d\n", ret);
+            stop_f = 1;
+            break;
+        }
+        started++;
+    }
+
+    next_report_us = start_us + report_s * 1000000ULL;
+    while (!stop_f) {
+        usleep(100000);
+        now_us = period_stats_now_us();
+        if (duration_s && now_us - start_us >= duration_s * 1000000ULL)
+            stop_f = 1;
+        if (!report_s || now_us < next_report_us)
+            continue;
+
+        pthread_mutex_lock(&stats_lock);
+        interval = stats_interval;
+        memset(&stats_interval, 0, sizeof(stats_interval));
+        pthread_mutex_unlock(&stats_lock);
+        pthread_mutex_lock(&stream_lock);
+        active = active_streams;
+        pthread_mutex_unlock(&stream_lock);
+
+        stats_print(&interval, "interval", now_us - start_us, now_us - last_us, active);
+        last_us = now_us;
+        next_report_us += report_s * 1000000ULL;
+    }
+
+    printf("Stopping, waiting for running cycles to complete\n");
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    now_us = period_stats_now_us();
+    stats_print(&stats_total, "total", now_us - start_us, now_us - start_us, 0);
+
+    for (i = 0; i < num_classes; i++)
+        free(classes[i].param);
+
+    return stats_failures(&stats_total) ? 1 : 0;
+}
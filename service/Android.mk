@@ -20,6 +20,7 @@ LOCAL_CFLAGS        := -D_ANDROID_
 LOCAL_CFLAGS        += -Wno-tautological-compare -Wno-macro-redefined -Wall
 LOCAL_CFLAGS        += -D_GNU_SOURCE -DACDB_PATH=\"/vendor/etc/acdbdata/\"
 LOCAL_CFLAGS        += -DACDB_DELTA_FILE_PATH="/data/vendor/audio/acdbdata/delta"
+LOCAL_CFLAGS        += -DACDB_MANIFEST_FILE=\"/data/vendor/audio/acdbdata/agm_acdb_manifest\"
 
 LOCAL_C_INCLUDES    := $(LOCAL_PATH)/inc/public
 LOCAL_C_INCLUDES    += $(LOCAL_PATH)/inc/private
@@ -38,8 +39,12 @@ LOCAL_SRC_FILES  := \
     src/graph_module.c\
     src/metadata.c\
     src/session_obj.c\
+    src/session_async.c\
     src/device.c \
     src/utils.c \
+    src/perf.c \
+    src/dump.c \
+    src/trace.c \
     src/device_hw_ep.c
 
 LOCAL_HEADER_LIBRARIES := \
@@ -72,6 +77,10 @@ LOCAL_SHARED_LIBRARIES += libexpat
 LOCAL_HEADER_LIBRARIES += libaudiologutils_headers
 endif
 
+ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_TRACE)), true)
+LOCAL_CFLAGS           += -DAGM_TRACE_ENABLED
+endif
+
 include $(BUILD_SHARED_LIBRARY)
 
 endif
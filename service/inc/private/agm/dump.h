@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _DUMP_H_
+#define _DUMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <agm/agm_api.h>
+
+#define SNAPSHOT_MAX_AIFS     8
+#define SNAPSHOT_MAX_MODULES  16
+
+struct module_snapshot {
+    uint32_t tag;
+    uint32_t mid;
+    uint32_t miid;
+    bool is_configured;
+};
+
+/*plain copy of the graph state, safe to read without the graph lock*/
+struct graph_snapshot {
+    bool valid;
+    uint32_t state;
+    uint32_t mod_cfg_skip_cnt;
+    /*modules in the graph, only the first num_modules are copied*/
+    uint32_t total_modules;
+    uint32_t num_modules;
+    struct module_snapshot modules[SNAPSHOT_MAX_MODULES];
+};
+
+struct aif_snapshot {
+    uint32_t aif_id;
+    uint32_t state;
+};
+
+/*
+ *Plain copy of a session published by the control path on every state
+ *change, so that a dump never has to take the session lock.
+ */
+struct session_snapshot {
+    uint32_t state;
+    struct agm_session_config stream_config;
+    struct agm_media_config in_media_config;
+    struct agm_media_config out_media_config;
+    struct agm_buffer_config in_buffer_config;
+    struct agm_buffer_config out_buffer_config;
+    uint32_t loopback_sess_id;
+    bool loopback_state;
+    uint32_t ec_ref_aif_id;
+    bool ec_ref_state;
+    bool standby_enabled;
+    /*aifs of the session, only the first num_aifs are copied*/
+    uint32_t total_aifs;
+    uint32_t num_aifs;
+    struct aif_snapshot aifs[SNAPSHOT_MAX_AIFS];
+    struct graph_snapshot graph;
+};
+
+/*
+ *Single writer sequence lock around a session snapshot, the writer is
+ *serialized by the session lock and readers retry on a torn copy.
+ */
+struct session_snapshot_seq {
+    uint32_t seq;
+    struct session_snapshot data;
+};
+
+void snapshot_write_begin(struct session_snapshot_seq *snap);
+void snapshot_write_end(struct session_snapshot_seq *snap);
+void snapshot_read(const struct session_snapshot_seq *snap,
+                   struct session_snapshot *out);
+
+/*
+ *Dump the state of all sessions and devices, one JSON object per line.
+ *dump_to_buffer returns -ENOSPC and the required size in *size if buf
+ *is too small.
+ */
+int dump_to_fd(int fd);
+int dump_to_buffer(char *buf, size_t *size);
+void dump_to_log(void);
+
+#endif /*_DUMP_H_*/
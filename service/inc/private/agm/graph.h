@@ -38,6 +38,7 @@
 #include <agm/device.h>
 #include <agm/session_obj.h>
 #include <agm/agm_priv.h>
+#include <agm/dump.h>
 
 #define ATTRIBUTES_DATA_MODE_MASK 0x3
 #define DATA_MODE_FLAG_SHMEM 0x0 /**< shared memory mode */
@@ -319,6 +320,16 @@ int graph_set_cal(struct graph_obj *gph_obj,
 
 int graph_set_acdb_param(void *payload);
 
+/**
+ *\brief Apply a batch of acdb tunnel params with a single delta update
+ *\param [in] payload: struct agm_acdb_tunnel_batch
+ *\param [in] size: size of payload
+ *
+ *\return 0 on success, error code otherwise. Nothing is written when an
+ *        entry is malformed or its tag is not in the graph.
+ */
+int graph_set_acdb_param_batch(void *payload, size_t size);
+
 /**
  *\brief Issue eos to the associated graph
  *\param [in] graph_obj: associated graph obj
@@ -336,6 +347,13 @@ int graph_eos(struct graph_obj *gph_obj);
  */
 int graph_get_session_time(struct graph_obj *gph_obj, uint64_t *timestamp);
 
+/**
+ *\brief Copy the state and tagged modules of the graph
+ *\param [in] graph_obj: associated graph obj, may be NULL
+ *\param [out] snap: filled with the graph state
+ */
+void graph_get_snapshot(struct graph_obj *gph_obj, struct graph_snapshot *snap);
+
 /**
  *\brief Get timestamp of the last read buffer
  *\param [in] graph_obj: associated graph obj
@@ -423,5 +441,28 @@ int graph_get_tagged_data(const struct agm_key_vector_gsl *graph_key_vect,
 
 int32_t graph_enable_acdb_persistence(uint8_t enable_flag);
 
+/*
+ *Time spent in graph_init, broken down by phase. gsl_init_us covers acdb
+ *loading and the ready checks together, gsl does not report the split.
+ *It is the time of the last gsl_init call when a stale acdb manifest
+ *forced a retry.
+ */
+struct graph_init_stats {
+    int ret;
+    uint64_t total_us;
+    uint64_t card_wait_us;
+    uint64_t acdb_files_us;
+    bool acdb_manifest_hit;
+    bool acdb_manifest_retry;
+    uint32_t num_acdb_files;
+    bool acdb_delta_present;
+    uint64_t gsl_init_us;
+    uint32_t max_num_ready_checks;
+    uint32_t ready_check_interval_ms;
+};
+
+/*copy out the stats recorded by the last graph_init*/
+void graph_get_init_stats(struct graph_init_stats *stats);
+
 int graph_set_media_config_datapath(struct graph_obj *gph_obj);
 #endif /*GPH_OBJ_H*/
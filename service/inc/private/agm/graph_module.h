@@ -63,6 +63,8 @@
 */
 
 #define TAG_STREAM_SPR       0xC0000013
+/*words in a device channel map, see device_get_channel_map*/
+#define HW_EP_CHMAP_LEN 16
 #define ALIGN_PAYLOAD(x,a)   x = (((x) + (size_t)(a-1)) & ~(size_t)(a-1))
 #define PARAM_VAL_NATIVE     -1
 
@@ -124,6 +126,16 @@ struct module_info {
     struct device_obj *dev_obj;
     /*GKV which contains/describes this module*/
     struct agm_key_vector_gsl *gkv;
+    /*
+     *Device and group media config, gkv and channel map this module was
+     *last configured with, valid only if cfg_snapshot_valid is set. Used
+     *to skip reconfiguring hw ep modules whose inputs did not change.
+     */
+    struct agm_media_config cfg_media_config;
+    struct agm_group_media_config cfg_grp_media_config;
+    struct agm_key_vector_gsl *cfg_gkv;
+    uint32_t cfg_chmap[HW_EP_CHMAP_LEN];
+    bool cfg_snapshot_valid;
     /*
      *Every module defines its configuration api, which in turn
      *then is used by graph object to configure the module using
@@ -134,6 +146,13 @@ struct module_info {
 
 typedef struct module_info module_info_t;
 
+/*entry of the per graph tag index over tagged_mod_list*/
+struct graph_tag_entry {
+    uint32_t tag;
+    uint32_t miid;
+    module_info_t *mod;
+};
+
 struct graph_buf_info {
     /* timestamp updated in struct gsl_buff on gsl_read */
     uint64_t timestamp;
@@ -155,9 +174,40 @@ struct graph_obj {
     uint32_t spr_miid;
     struct graph_buf_info buf_info;
     bool is_config_buf_params_done;
+    /*number of module configurations skipped as their inputs were unchanged*/
+    uint32_t mod_cfg_skip_cnt;
+    /*
+     *set by graph_change, the next prepare may then skip hw ep modules
+     *whose inputs are unchanged. Other prepares configure them again.
+     */
+    bool hw_ep_skip_unchanged;
+    /*
+     *tagged_mod_list sorted by tag, modules sharing a tag are adjacent.
+     *Rebuilt under the graph lock whenever the module list changes.
+     */
+    struct graph_tag_entry *tag_table;
+    uint32_t tag_table_cnt;
 };
 
 void get_stream_module_list_array(module_info_t **info, size_t *size);
+int graph_gsl_ioctl(struct graph_obj *graph_obj, enum gsl_cmd_id cmd_id,
+                    void *payload, size_t payload_size);
+int graph_gsl_set_custom_config(struct graph_obj *graph_obj,
+                    const uint8_t *payload, size_t payload_size);
 void get_hw_ep_module_list_array(module_info_t **info, size_t *size);
 
+/*called with graph_obj->lock held*/
+int graph_tag_table_build(struct graph_obj *graph_obj);
+void graph_tag_table_free(struct graph_obj *graph_obj);
+/*index of the first entry for tag, tag_table_cnt if there is none*/
+uint32_t graph_tag_table_lookup(struct graph_obj *graph_obj, uint32_t tag);
+
+/*iterate over the modules of graph_obj carrying tag_id*/
+#define graph_for_each_tagged_module(graph_obj, tag_id, idx, module) \
+    for ((idx) = graph_tag_table_lookup((graph_obj), (tag_id)); \
+         (idx) < (graph_obj)->tag_table_cnt && \
+         (graph_obj)->tag_table[(idx)].tag == (tag_id) && \
+         ((module) = (graph_obj)->tag_table[(idx)].mod) != NULL; \
+         (idx)++)
+
 #endif /*GPH_MODULE_H*/
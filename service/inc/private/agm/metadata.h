@@ -31,6 +31,7 @@
 #define _METADATA_H_
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <agm/agm_priv.h>
 
 struct agm_meta_data_gsl* metadata_merge(int num, ...);
@@ -39,5 +40,8 @@ void metadata_free(struct agm_meta_data_gsl *metadata);
 void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
                              struct agm_key_vector_gsl *ckv);
 void metadata_print(struct agm_meta_data_gsl* metadata);
+/* compares graph and calibration key vectors of the two metadata */
+bool metadata_equal(const struct agm_meta_data_gsl *a,
+                    const struct agm_meta_data_gsl *b);
 
 #endif //METADATA_H
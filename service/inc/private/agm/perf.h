@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <agm/agm_api.h>
+
+/*
+ *Per-session operation counters. Writers update the counters with
+ *relaxed atomics so that neither the control nor the data path ever
+ *takes a lock for accounting, readers copy them out field by field.
+ */
+
+/*monotonic timestamp in us, used to mark the start of a measured call*/
+uint64_t perf_now_us(void);
+
+/*account one call of op which started at start_us and returned ret*/
+void perf_record(struct agm_perf_stats *stats, enum agm_perf_op op,
+                 uint64_t start_us, size_t bytes, int ret);
+
+/*copy the counters of stats into out*/
+void perf_snapshot(const struct agm_perf_stats *stats,
+                   struct agm_perf_stats *out);
+
+/*human readable name of op*/
+const char *perf_op_name(enum agm_perf_op op);
+
+#endif /*_PERF_H_*/
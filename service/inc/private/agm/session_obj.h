@@ -42,6 +42,8 @@
 #include <agm/agm_priv.h>
 #include <agm/metadata.h>
 #include <agm/graph.h>
+#include <agm/perf.h>
+#include <agm/dump.h>
 
 enum aif_state {
     AIF_CLOSED,
@@ -79,6 +81,24 @@ struct session_cb {
     void *client_data;
 };
 
+struct session_async_work {
+    struct listnode node;
+    enum agm_async_op op;
+    uint32_t aif_id;
+    bool aif_state;
+    uint64_t cookie;
+};
+
+/*per session worker running queued async operations in order*/
+struct session_async {
+    struct listnode work_list;
+    pthread_t thread;
+    bool thread_created;
+    bool exit;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
 struct session_obj {
     struct listnode node;
     uint32_t sess_id;
@@ -100,6 +120,15 @@ struct session_obj {
     bool ec_ref_state;
     uint32_t rx_metadata_sz;
     uint32_t tx_metadata_sz;
+    /*keep the prepared graph in standby on close for reuse on next open*/
+    bool standby_enabled;
+    /*graph of the current open was taken from the standby list*/
+    bool standby_reused;
+    /*operation counters, updated without taking the session lock*/
+    struct agm_perf_stats perf;
+    /*state copy published for agm_dump, see session_publish_snapshot*/
+    struct session_snapshot_seq snapshot;
+    struct session_async async;
     pthread_mutex_t lock;
     pthread_mutex_t cb_pool_lock;
 };
@@ -125,6 +154,13 @@ int session_obj_set_config(struct session_obj *session,
                              struct agm_buffer_config *buffer_config);
 int session_obj_prepare(struct session_obj *sess_obj);
 int session_obj_start(struct session_obj *sess_obj);
+int session_obj_launch(struct session_obj *sess_obj,
+                       struct agm_session_launch_config *config);
+int session_obj_async_queue(struct session_obj *sess_obj,
+                            enum agm_async_op op, uint32_t aif_id,
+                            bool aif_state, uint64_t cookie);
+void session_obj_async_init(struct session_obj *sess_obj);
+void session_obj_async_deinit(struct session_obj *sess_obj);
 int session_obj_stop(struct session_obj *sess_obj);
 int session_obj_close(struct session_obj *sess_obj);
 int session_obj_pause(struct session_obj *sess_obj);
@@ -147,6 +183,9 @@ int session_obj_set_sess_aif_params(struct session_obj *sess_obj,
                              void *payload, size_t size);
 int session_obj_get_sess_params(struct session_obj *sess_obj,
                              void *payload, size_t size);
+int session_obj_set_params_batch(struct session_obj *sess_obj,
+                             struct agm_params_batch_entry **entries,
+                             uint32_t num_entries);
 int session_obj_set_sess_aif_params_with_tag(struct session_obj *sess_obj,
                              uint32_t aif_id,
                              struct agm_tag_config *tag_config);
@@ -163,6 +202,7 @@ int session_dummy_get_tag_with_module_info(
                              void *payload, size_t *size);
 int session_dummy_rw_acdb_tunnel(
                              void *payload, bool is_param_set);
+int session_dummy_set_acdb_tunnel_batch(void *payload, size_t size);
 size_t session_obj_hw_processed_buff_cnt(struct session_obj *sess_obj,
                              enum direction dir);
 int session_obj_set_loopback(struct session_obj *sess_obj,
@@ -175,6 +215,9 @@ int session_obj_register_for_events(struct session_obj *sess_obj,
                              struct agm_event_reg_cfg *evt_reg_cfg);
 int session_obj_set_ec_ref(struct session_obj *sess_obj, uint32_t aif_id,
                              bool state);
+int session_obj_set_standby(struct session_obj *sess_obj, bool enable);
+int session_obj_get_perf_stats(struct session_obj *sess_obj,
+                             struct agm_perf_stats *stats);
 int session_obj_eos(struct session_obj *sess_obj);
 int session_obj_get_timestamp(struct session_obj *sess_obj,
                              uint64_t *timestamp);
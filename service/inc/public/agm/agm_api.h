@@ -399,6 +399,33 @@ struct agm_buffer_config {
     size_t max_metadata_size; /**< max metadata size a client attaches to a buffer */
 };
 
+/**
+ * Audio interface entry of a session launch
+ */
+struct agm_session_launch_aif {
+    uint32_t aif_id;                      /**< audio interface to connect */
+    bool set_media_config;                /**< apply media_config to the interface */
+    struct agm_media_config media_config; /**< interface media configuration */
+    uint32_t metadata_size;               /**< session-aif metadata size, 0 keeps current */
+    uint8_t *metadata;                    /**< session-aif metadata */
+};
+
+/**
+ * Everything needed to take a session from closed to started
+ */
+struct agm_session_launch_config {
+    uint32_t session_id;                    /**< audio session id */
+    enum agm_session_mode sess_mode;        /**< mode the session is opened in */
+    uint32_t metadata_size;                 /**< session metadata size, 0 keeps current */
+    uint8_t *metadata;                      /**< session metadata */
+    uint32_t num_aifs;                      /**< number of entries in aifs */
+    struct agm_session_launch_aif *aifs;    /**< audio interfaces to connect */
+    struct agm_session_config session_config; /**< session configuration */
+    struct agm_media_config media_config;   /**< session media configuration */
+    struct agm_buffer_config buffer_config; /**< session buffer configuration */
+    bool start;                             /**< start after prepare */
+};
+
 /**
  * Maps the modules instance id to module id for a single module
  */
@@ -433,6 +460,28 @@ struct agm_tag_config {
     struct agm_key_value kv[];   /**< tag key vector*/
 };
 
+/**
+ * Kind of a params batch entry
+ */
+enum agm_params_batch_type {
+    AGM_PARAMS_BATCH_SESSION,     /**< payload as for agm_session_set_params */
+    AGM_PARAMS_BATCH_SESSION_AIF, /**< payload as for agm_session_aif_set_params */
+    AGM_PARAMS_BATCH_TAG,         /**< payload is a struct agm_tag_config as for agm_set_params_with_tag */
+    AGM_PARAMS_BATCH_SESSION_GET, /**< payload as for agm_session_get_params, filled in place */
+};
+
+/**
+ * Single entry of a params batch
+ */
+struct agm_params_batch_entry {
+    enum agm_params_batch_type type; /**< entry kind */
+    uint32_t session_id;             /**< audio session id */
+    uint32_t aif_id;                 /**< audio interface id, aif and tag entries only */
+    void *payload;                   /**< param payload */
+    size_t size;                     /**< payload size in bytes */
+    int32_t status;                  /**< result of this entry, set by agm */
+};
+
 struct agm_cal_config {
     uint32_t num_ckvs;         /**< num  of tag key values*/
     struct agm_key_value kv[]; /**< tag key vector*/
@@ -455,6 +504,16 @@ struct agm_acdb_tunnel_param {
     uint8_t blob[];            /**< gkv + t/ckv + payload */
 };
 
+/**
+ * A batch of acdb tunnel params. num_params struct agm_acdb_tunnel_param
+ * entries follow back to back, each padded to a multiple of 8 bytes.
+ */
+struct agm_acdb_tunnel_batch {
+    uint32_t num_params;
+    uint32_t reserved;
+    uint8_t params[];
+};
+
 /**
  * Event types
  */
@@ -462,6 +521,7 @@ enum event_type
 {
     AGM_EVENT_DATA_PATH = 1,/**< Events on the Data path, READ_DONE or WRITE_DONE */
     AGM_EVENT_MODULE,       /**< Events raised by modules */
+    AGM_EVENT_CONTROL_PATH, /**< Completion of async control operations */
 };
 
 struct agm_event_read_write_done_payload {
@@ -522,9 +582,31 @@ enum agm_event_id {
 
     AGM_EVENT_EARLY_EOS = 0x08001126,
 
+   /**
+    * Indicates an async control operation has completed, payload is
+    * struct agm_event_async_done_payload
+    */
+    AGM_EVENT_ASYNC_DONE = 0x08001200,
+
     AGM_EVENT_ID_MAX
 };
 
+/** Control operations that can be issued asynchronously */
+enum agm_async_op {
+    AGM_ASYNC_OP_PREPARE,     /**< agm_session_prepare_async */
+    AGM_ASYNC_OP_START,       /**< agm_session_start_async */
+    AGM_ASYNC_OP_STOP,        /**< agm_session_stop_async */
+    AGM_ASYNC_OP_CLOSE,       /**< agm_session_close_async */
+    AGM_ASYNC_OP_AIF_CONNECT, /**< agm_session_aif_connect_async */
+};
+
+struct agm_event_async_done_payload {
+    uint32_t op;      /**< enum agm_async_op that completed */
+    uint32_t aif_id;  /**< audio interface of an aif connect */
+    int32_t status;   /**< 0 on success, error code otherwise */
+    uint64_t cookie;  /**< cookie passed when the operation was queued */
+};
+
 /** data that will be passed to client in the event callback */
 struct agm_event_cb_params {
 /**< identifies the module which generated event */
@@ -550,6 +632,47 @@ struct agm_dump_info {
     uint32_t uid;
 };
 
+/**
+ * Operations tracked by the per-session performance counters
+ */
+enum agm_perf_op {
+    AGM_PERF_OP_OPEN,                  /**< session open */
+    AGM_PERF_OP_PREPARE,               /**< session prepare */
+    AGM_PERF_OP_START,                 /**< session start */
+    AGM_PERF_OP_STOP,                  /**< session stop */
+    AGM_PERF_OP_CLOSE,                 /**< session close */
+    AGM_PERF_OP_GSL_IOCTL,             /**< gsl_ioctl issued by the graph */
+    AGM_PERF_OP_GSL_SET_CUSTOM_CONFIG, /**< gsl_set_custom_config issued by the graph */
+    AGM_PERF_OP_WRITE,                 /**< session write */
+    AGM_PERF_OP_READ,                  /**< session read */
+    AGM_PERF_OP_LAUNCH,                /**< compound session launch */
+    AGM_PERF_OP_MAX,
+};
+
+/**
+ * Number of latency histogram buckets, bucket 0 counts calls
+ * shorter than 1us and bucket i (i > 0) counts calls taking
+ * [2^(i-1), 2^i) us, the last bucket also counts anything longer.
+ */
+#define AGM_PERF_HIST_BUCKETS 24
+
+/** Counters of a single operation */
+struct agm_perf_op_stats {
+    uint64_t count;                /**< number of calls */
+    uint64_t errors;               /**< number of calls that failed */
+    uint64_t total_us;             /**< accumulated duration in us */
+    uint64_t max_us;               /**< longest call in us */
+    uint64_t bytes;                /**< bytes read/written, payload bytes
+                                        for gsl_set_custom_config */
+    uint32_t hist[AGM_PERF_HIST_BUCKETS]; /**< latency histogram */
+};
+
+/** Performance counters of a session */
+struct agm_perf_stats {
+    uint32_t session_id;
+    struct agm_perf_op_stats op[AGM_PERF_OP_MAX];
+};
+
 /**
  * \brief Callback function signature for events to client
  *
@@ -762,6 +885,21 @@ int agm_session_get_params(uint32_t session_id,
 int agm_set_params_with_tag(uint32_t session_id, uint32_t aif_id,
                               struct agm_tag_config *tag_config);
 
+/**
+ * \brief Apply a batch of param set/get entries that may span several
+ *        sessions and audio interfaces. Entries of a session are applied
+ *        in order, consecutive raw payloads going to the same graph are
+ *        sent with a single custom config.
+ *
+ * \param[in,out] entries - entries to apply, status of each is updated
+ * \param[in] num_entries - number of entries
+ *
+ *  \return 0 if every entry succeeded, error of the first failing
+ *       entry otherwise.
+ */
+int agm_params_batch(struct agm_params_batch_entry *entries,
+                     uint32_t num_entries);
+
 /**
  * \brief Set parameters for modules in b/w stream and audio interface
  *
@@ -790,6 +928,25 @@ int agm_set_params_with_tag_to_acdb(uint32_t session_id, uint32_t aif_id,
 
 int agm_set_params_to_acdb_tunnel(void *payload, size_t size);
 
+/**
+ * \brief Set a batch of parameters for modules at acdb without session
+ *
+ * All entries are validated before the first write, an entry that is
+ * malformed or carries a tag not present in its graph fails the batch
+ * with nothing written. The acdb delta file is updated once, after the
+ * last entry is applied. There is no rollback: if a write fails, the
+ * entries applied before it stay in acdb memory, the delta file is not
+ * updated by this call, and they are persisted by the next persisted
+ * acdb write.
+ *
+ * \param[in] payload - struct agm_acdb_tunnel_batch
+ * \param[in] size - size of payload
+ *
+ *  \return 0 on success, error code on failure.
+ */
+
+int agm_set_params_to_acdb_tunnel_batch(void *payload, size_t size);
+
 /**
   * \brief Open the session with specified session id.
   *
@@ -879,6 +1036,46 @@ int agm_session_prepare(uint64_t hndl);
 
 int agm_session_start(uint64_t hndl);
 
+/**
+  * \brief Asynchronous variants of prepare, start, stop, close and aif
+  *        connect. The operation is queued to the session worker and
+  *        the call returns without waiting for it. Operations of a
+  *        session run in the order they were queued, different
+  *        sessions progress in parallel. Completion is reported to the
+  *        callbacks registered with agm_session_register_cb for
+  *        AGM_EVENT_CONTROL_PATH as AGM_EVENT_ASYNC_DONE. Synchronous
+  *        calls on the session are not ordered against queued ones.
+  *
+  * \param[in] handle - Valid session handle obtained
+  *       from agm_session_open
+  * \param[in] cookie - client value returned in the completion event
+  *
+  * \return 0 if the operation was queued, error code otherwise
+  */
+int agm_session_prepare_async(uint64_t hndl, uint64_t cookie);
+int agm_session_start_async(uint64_t hndl, uint64_t cookie);
+int agm_session_stop_async(uint64_t hndl, uint64_t cookie);
+int agm_session_close_async(uint64_t hndl, uint64_t cookie);
+int agm_session_aif_connect_async(uint32_t session_id, uint32_t aif_id,
+                                  bool state, uint64_t cookie);
+
+/**
+  * \brief Launch a session in a single call. Sets the session and
+  *        session-aif metadata, the aif media configs, connects the
+  *        aifs, then opens, configures, prepares and optionally
+  *        starts the session. On failure everything done by the call
+  *        is undone except the aif media configs, and the session is
+  *        left closed.
+  *
+  * \param[in] config - launch descriptor, session must be closed
+  * \param[out] handle - updated with valid session
+  *       handle if the operation is successful.
+  *
+  * \return 0 on success, error code otherwise
+  */
+int agm_session_launch(struct agm_session_launch_config *config,
+                       uint64_t *handle);
+
 /**
   * \brief Stop the session. session must be in started/paused
   *        state before stopping.
@@ -1194,6 +1391,63 @@ int agm_aif_group_set_media_config(uint32_t aif_group_id,
  */
 int agm_session_write_datapath_params(uint32_t session_id, struct agm_buff *buff);
 
+/**
+  * \brief Enable or disable standby graph mode for a session.
+  *
+  *  When enabled, the prepared graph of the session is kept in standby on
+  *  close instead of being torn down. A subsequent open of the session with
+  *  the same metadata, device, media and buffer configuration reuses that
+  *  graph and is ready to be started without a new graph open/prepare.
+  *  Standby graphs are bounded by a memory budget and evicted in least
+  *  recently used order. Disabling the mode releases the standby graphs
+  *  held for the session.
+  *
+  * \param[in] session_id - Valid audio session id
+  * \param[in] enable - true to enable, false to disable standby mode
+  *
+  *  \return 0 on success, error code on failure.
+  */
+int agm_session_set_standby(uint32_t session_id, bool enable);
+
+/**
+  * \brief Get performance counters of a session.
+  *
+  *  Counters accumulate from service start and are updated without
+  *  locking, a snapshot taken while the session is active may mix
+  *  values from adjacent calls.
+  *
+  * \param[in] session_id - Valid audio session id
+  * \param[out] stats - counters of the session
+  *
+  *  \return 0 on success, error code on failure.
+  */
+int agm_session_get_perf_stats(uint32_t session_id,
+                               struct agm_perf_stats *stats);
+
+/**
+  * \brief Dump the state of all sessions and devices to a file
+  *        descriptor, one JSON object per line. Session state is read
+  *        from published snapshots and does not block the control path.
+  *
+  * \param[in] fd - writable file descriptor
+  *
+  *  \return 0 on success, error code on failure.
+  */
+int agm_dump_to_fd(int fd);
+
+/**
+  * \brief Dump the state of all sessions and devices to a buffer,
+  *        in the same format as agm_dump_to_fd.
+  *
+  * \param[in] buf - buffer to fill, can be NULL if size is 0
+  * \param[in,out] size - size of buf on input, size of the complete
+  *       dump on output
+  *
+  *  \return 0 on success, -ENOSPC if buf is too small for the complete
+  *          dump, error code on failure.
+  */
+int agm_dump_to_buffer(char *buf, size_t *size);
+
 /**
   * \brief Dump AGM information based on client
   *
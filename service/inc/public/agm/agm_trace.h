@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _AGM_TRACE_H_
+#define _AGM_TRACE_H_
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/*
+ *Timeline tracing of the AGM control and data paths, built only when
+ *AGM_TRACE_ENABLED is defined. Events are recorded into a per-thread
+ *ring and periodically appended to a Trace Event Format (JSON array)
+ *file that can be loaded in chrome://tracing or ui.perfetto.dev.
+ *
+ *Event names must be string literals, only the pointer is recorded.
+ *Without AGM_TRACE_ENABLED all macros compile to nothing, with it a
+ *disabled tracer costs one load and a predictable branch per event.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef AGM_TRACE_ENABLED
+
+extern bool agm_trace_on;
+
+/**
+  * \brief Start tracing to the file named by the AGM_TRACE_FILE
+  *        environment variable, or AGM_TRACE_FILE_PATH if unset.
+  *
+  *  \return 0 on success, error code on failure.
+  */
+int agm_trace_init(void);
+
+/**
+  * \brief Stop tracing, flush the pending events and close the file.
+  */
+void agm_trace_deinit(void);
+
+/**
+  * \brief Append the events recorded so far to the trace file.
+  *
+  *  \return 0 on success, error code on failure.
+  */
+int agm_trace_flush(void);
+
+void agm_trace_begin(const char *name);
+void agm_trace_end(const char *name);
+void agm_trace_instant(const char *name);
+
+#define AGM_TRACE_ACTIVE() __builtin_expect(agm_trace_on, 0)
+
+#define AGM_TRACE_BEGIN(name) \
+    do { if (AGM_TRACE_ACTIVE()) agm_trace_begin(name); } while (0)
+#define AGM_TRACE_END(name) \
+    do { if (AGM_TRACE_ACTIVE()) agm_trace_end(name); } while (0)
+#define AGM_TRACE_INSTANT(name) \
+    do { if (AGM_TRACE_ACTIVE()) agm_trace_instant(name); } while (0)
+
+/*records the time spent waiting for a mutex as a separate slice*/
+#define AGM_TRACE_MUTEX_LOCK(mutex, name) \
+    do { \
+        AGM_TRACE_BEGIN(name); \
+        pthread_mutex_lock(mutex); \
+        AGM_TRACE_END(name); \
+    } while (0)
+
+#define AGM_TRACE_CONCAT_(a, b) a##b
+#define AGM_TRACE_CONCAT(a, b) AGM_TRACE_CONCAT_(a, b)
+
+#ifdef __cplusplus
+}  /* extern "C" */
+
+/*slice covering the enclosing scope*/
+class AgmTraceScope {
+public:
+    explicit AgmTraceScope(const char *name)
+        : name_(AGM_TRACE_ACTIVE() ? name : nullptr) {
+        if (name_)
+            agm_trace_begin(name_);
+    }
+    ~AgmTraceScope() {
+        if (name_)
+            agm_trace_end(name_);
+    }
+private:
+    const char *name_;
+};
+
+#define AGM_TRACE_SCOPE(name) \
+    AgmTraceScope AGM_TRACE_CONCAT(agm_trace_scope_, __LINE__)(name)
+
+#else
+
+static inline const char *agm_trace_scope_begin(const char *name)
+{
+    if (!AGM_TRACE_ACTIVE())
+        return NULL;
+    agm_trace_begin(name);
+    return name;
+}
+
+static inline void agm_trace_scope_end(const char **name)
+{
+    if (*name)
+        agm_trace_end(*name);
+}
+
+/*slice covering the enclosing scope, ended on every return path*/
+#define AGM_TRACE_SCOPE(name) \
+    const char *AGM_TRACE_CONCAT(agm_trace_scope_, __LINE__) \
+        __attribute__((cleanup(agm_trace_scope_end), unused)) = \
+        agm_trace_scope_begin(name)
+
+#endif /* __cplusplus */
+
+#else
+
+#define AGM_TRACE_BEGIN(name) do { } while (0)
+#define AGM_TRACE_END(name) do { } while (0)
+#define AGM_TRACE_INSTANT(name) do { } while (0)
+#define AGM_TRACE_MUTEX_LOCK(mutex, name) pthread_mutex_lock(mutex)
+#define AGM_TRACE_SCOPE(name) do { } while (0)
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif /* AGM_TRACE_ENABLED */
+
+#endif /* _AGM_TRACE_H_ */
@@ -28,6 +28,7 @@
 **/
 
 #ifndef __UTILS_H__
+#define __UTILS_H__
 // Numbers inferred from define list in utils.c
 #define AR_EOK 0
 #define AR_EFAILED 1
@@ -60,10 +61,232 @@
 #include <log/log.h>
 #endif
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *Runtime log control. The level and masks are tested before a message's
+ *arguments are evaluated, so a disabled message costs a load and a
+ *predicted branch. They are reloaded by agm_log_config_update() on
+ *agm_init() and on every session open, in the service and in the client
+ *libraries, so a change takes effect with the next stream.
+ */
+enum agm_log_level {
+    AGM_LOG_LEVEL_ERROR = 0,
+    AGM_LOG_LEVEL_INFO,
+    AGM_LOG_LEVEL_DEBUG,
+    AGM_LOG_LEVEL_VERBOSE,
+};
+
+#define AGM_LOG_MOD_SESSION  (1u << 0)
+#define AGM_LOG_MOD_GRAPH    (1u << 1)
+#define AGM_LOG_MOD_DEVICE   (1u << 2)
+#define AGM_LOG_MOD_METADATA (1u << 3)
+#define AGM_LOG_MOD_IPC      (1u << 4)
+#define AGM_LOG_MOD_PLUGIN   (1u << 5)
+#define AGM_LOG_MOD_ALL      0xffffffffu
+
+/*sources can define their module before including this header*/
+#ifndef AGM_LOG_MODULE
+#define AGM_LOG_MODULE AGM_LOG_MOD_ALL
+#endif
+
+#ifndef AGM_LOG_LEVEL_DEFAULT
+#define AGM_LOG_LEVEL_DEFAULT AGM_LOG_LEVEL_DEBUG
+#endif
+
+struct agm_log_config {
+    int level;
+    uint32_t module_mask;
+    /*bit n enables session n, 0 enables every session*/
+    uint64_t session_mask;
+    /*data path messages per call site and interval, 0 disables the limit*/
+    uint32_t ratelimit_burst;
+    uint32_t ratelimit_interval_ms;
+};
+
+#define AGM_LOG_CONFIG_INIT \
+    { AGM_LOG_LEVEL_DEFAULT, AGM_LOG_MOD_ALL, 0, 10, 1000 }
+
+/*
+ *Defined once by the library implementing the agm api, libagm or the
+ *libagmclient in use, the plugins share the copy of the one they link.
+ */
+extern struct agm_log_config agm_log_cfg;
+
+#define AGM_LOG_ON(lvl) \
+    __builtin_expect(agm_log_cfg.level >= (lvl) && \
+                     (agm_log_cfg.module_mask & (AGM_LOG_MODULE)), 0)
+
+static inline bool agm_log_session_on(uint32_t sess_id)
+{
+    uint64_t mask = agm_log_cfg.session_mask;
+
+    return !mask || (sess_id < 64 && (mask & (1ULL << sess_id)));
+}
+
+struct agm_log_ratelimit {
+    int64_t begin_ms;
+    uint32_t count;
+    uint32_t missed;
+};
+
+/*
+ *Returns true if the call site may log, *missed is set to the number of
+ *messages dropped in the previous interval. The state is per call site
+ *and not locked, counts are approximate when threads share a call site.
+ */
+static inline bool agm_log_ratelimit_pass(struct agm_log_ratelimit *rl,
+                                          uint32_t *missed)
+{
+    struct timespec ts;
+    int64_t now_ms;
+
+    *missed = 0;
+    if (!agm_log_cfg.ratelimit_burst)
+        return true;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now_ms = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    if (now_ms - rl->begin_ms >= agm_log_cfg.ratelimit_interval_ms) {
+        *missed = rl->missed;
+        rl->begin_ms = now_ms;
+        rl->count = 0;
+        rl->missed = 0;
+    }
+
+    if (rl->count < agm_log_cfg.ratelimit_burst) {
+        rl->count++;
+        return true;
+    }
+    rl->missed++;
+    return false;
+}
+
+#ifdef __ANDROID__
+#define AGM_LOG_VALUE_MAX PROP_VALUE_MAX
+#else
+#define AGM_LOG_VALUE_MAX 92
+#endif
+
+/*Android reads the vendor.agm.log.* property, other builds AGM_LOG_**/
+static inline const char *agm_log_config_get(const char *prop,
+                                             const char *env, char *buf)
+{
+#ifdef __ANDROID__
+    (void)env;
+    return __system_property_get(prop, buf) > 0 ? buf : NULL;
+#else
+    (void)prop;
+    (void)buf;
+    return getenv(env);
+#endif
+}
+
+/*
+ *Fill cfg from vendor.agm.log.{level,modules,sessions,ratelimit}, or
+ *AGM_LOG_{LEVEL,MODULES,SESSIONS,RATELIMIT}, unset keys are left alone.
+ */
+static inline void agm_log_config_load(struct agm_log_config *cfg)
+{
+    char buf[AGM_LOG_VALUE_MAX];
+    unsigned int burst = 0, interval_ms = 0;
+    const char *val;
+
+    val = agm_log_config_get("vendor.agm.log.level", "AGM_LOG_LEVEL", buf);
+    if (val)
+        cfg->level = (int)strtol(val, NULL, 0);
+
+    val = agm_log_config_get("vendor.agm.log.modules", "AGM_LOG_MODULES", buf);
+    if (val)
+        cfg->module_mask = (uint32_t)strtoul(val, NULL, 0);
+
+    val = agm_log_config_get("vendor.agm.log.sessions", "AGM_LOG_SESSIONS",
+                             buf);
+    if (val)
+        cfg->session_mask = strtoull(val, NULL, 0);
+
+    /*"<burst>/<interval_ms>", a burst of 0 disables rate limiting*/
+    val = agm_log_config_get("vendor.agm.log.ratelimit", "AGM_LOG_RATELIMIT",
+                             buf);
+    if (val && sscanf(val, "%u/%u", &burst, &interval_ms) >= 1) {
+        cfg->ratelimit_burst = burst;
+        if (interval_ms)
+            cfg->ratelimit_interval_ms = interval_ms;
+    }
+}
+
+/*reload agm_log_cfg, see agm_log_config_load()*/
+void agm_log_config_update(void);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
 #define AGM_LOGE(arg,...) ALOGE("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__)
-#define AGM_LOGD(arg,...) ALOGD("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__)
-#define AGM_LOGI(arg,...) ALOGI("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__)
-#define AGM_LOGV(arg,...) ALOGV("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__)
+#define AGM_LOGI(arg,...) \
+    do { \
+        if (__builtin_expect(agm_log_cfg.level >= AGM_LOG_LEVEL_INFO, 1)) \
+            ALOGI("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+#define AGM_LOGD(arg,...) \
+    do { \
+        if (AGM_LOG_ON(AGM_LOG_LEVEL_DEBUG)) \
+            ALOGD("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+#define AGM_LOGV(arg,...) \
+    do { \
+        if (AGM_LOG_ON(AGM_LOG_LEVEL_VERBOSE)) \
+            ALOGV("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+
+/*messages about one session, filtered by the session mask*/
+#define AGM_LOGD_SESS(sess_id, arg,...) \
+    do { \
+        if (AGM_LOG_ON(AGM_LOG_LEVEL_DEBUG) && agm_log_session_on(sess_id)) \
+            ALOGD("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+
+/*per buffer data path messages, filtered by session and rate limited*/
+#define AGM_LOG_DP(lvl, prio, sess_id, arg,...) \
+    do { \
+        static struct agm_log_ratelimit agm_log_rl_; \
+        uint32_t agm_log_missed_; \
+        if (AGM_LOG_ON(lvl) && agm_log_session_on(sess_id) && \
+            agm_log_ratelimit_pass(&agm_log_rl_, &agm_log_missed_)) { \
+            if (agm_log_missed_) \
+                prio("%s: %d %u messages suppressed", __func__, __LINE__, \
+                     agm_log_missed_); \
+            prio("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+        } \
+    } while (0)
+#define AGM_LOGD_DP(sess_id, arg,...) \
+    AGM_LOG_DP(AGM_LOG_LEVEL_DEBUG, ALOGD, sess_id, arg, ##__VA_ARGS__)
+#define AGM_LOGV_DP(sess_id, arg,...) \
+    AGM_LOG_DP(AGM_LOG_LEVEL_VERBOSE, ALOGV, sess_id, arg, ##__VA_ARGS__)
+
+/*per buffer errors, only rate limited*/
+#define AGM_LOGE_DP(arg,...) \
+    do { \
+        static struct agm_log_ratelimit agm_log_rl_; \
+        uint32_t agm_log_missed_; \
+        if (agm_log_ratelimit_pass(&agm_log_rl_, &agm_log_missed_)) { \
+            if (agm_log_missed_) \
+                ALOGE("%s: %d %u messages suppressed", __func__, __LINE__, \
+                      agm_log_missed_); \
+            ALOGE("%s: %d "  arg, __func__, __LINE__, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 /*convert osal error codes to lnx error codes*/
 int ar_err_get_lnx_err_code(uint32_t error);
@@ -61,6 +61,7 @@
  */
 #define LOG_TAG "AGM: API"
 #include <agm/agm_api.h>
+#include <agm/agm_trace.h>
 #include <agm/device.h>
 #include <agm/session_obj.h>
 #include <agm/utils.h>
@@ -116,6 +117,7 @@ int agm_init()
     register_for_dynamic_logging("agm");
     log_utils_init();
 #endif
+    agm_log_config_update();
 
     pthread_attr_init (&tattr);
     pthread_attr_getschedparam (&tattr, &param);
@@ -127,6 +129,10 @@ int agm_init()
     if (ret)
         AGM_LOGE(" ats init thread creation failed\n");
 
+#ifdef AGM_TRACE_ENABLED
+    agm_trace_init();
+#endif
+
     ret = session_obj_init();
     if (0 != ret) {
         AGM_LOGE("Session_obj_init failed with %d", ret);
@@ -145,6 +151,9 @@ int agm_deinit()
         AGM_LOGD("Deinitializing ATS...");
         ats_deinit();
         session_obj_deinit();
+#ifdef AGM_TRACE_ENABLED
+        agm_trace_deinit();
+#endif
         agm_initialized = 0;
     }
 
@@ -467,6 +476,98 @@ done:
     return ret;
 }
 
+static int agm_params_batch_entry_apply(struct session_obj *obj,
+                                        struct agm_params_batch_entry *entry)
+{
+    struct agm_tag_config *tag_config = NULL;
+
+    switch (entry->type) {
+    case AGM_PARAMS_BATCH_TAG:
+        tag_config = (struct agm_tag_config *)entry->payload;
+        if (!tag_config || entry->size < sizeof(struct agm_tag_config) ||
+            entry->size < sizeof(struct agm_tag_config) +
+                          tag_config->num_tkvs * sizeof(struct agm_key_value))
+            return -EINVAL;
+        return session_obj_set_sess_aif_params_with_tag(obj, entry->aif_id,
+                                                        tag_config);
+    case AGM_PARAMS_BATCH_SESSION_GET:
+        return session_obj_get_sess_params(obj, entry->payload, entry->size);
+    default:
+        AGM_LOGE("Invalid params batch entry type %d\n", entry->type);
+        return -EINVAL;
+    }
+}
+
+int agm_params_batch(struct agm_params_batch_entry *entries,
+                     uint32_t num_entries)
+{
+    struct agm_params_batch_entry **run = NULL;
+    struct agm_params_batch_entry *entry = NULL;
+    struct session_obj *obj = NULL;
+    bool *done = NULL;
+    uint32_t i, j, count;
+    int ret = 0;
+
+    if (!entries || num_entries == 0) {
+        AGM_LOGE("Invalid params batch\n");
+        return -EINVAL;
+    }
+
+    run = calloc(num_entries, sizeof(*run));
+    done = calloc(num_entries, sizeof(*done));
+    if (!run || !done) {
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    /*graphs are per session, keep each session's entries in order*/
+    for (i = 0; i < num_entries; i++) {
+        if (done[i])
+            continue;
+
+        ret = session_obj_get(entries[i].session_id, &obj);
+        if (ret)
+            AGM_LOGE("Error:%d retrieving session obj with session id=%d\n",
+                     ret, entries[i].session_id);
+
+        count = 0;
+        for (j = i; j < num_entries; j++) {
+            entry = &entries[j];
+            if (done[j] || entry->session_id != entries[i].session_id)
+                continue;
+            done[j] = true;
+
+            if (ret) {
+                entry->status = ret;
+                continue;
+            }
+
+            if (entry->type == AGM_PARAMS_BATCH_SESSION ||
+                entry->type == AGM_PARAMS_BATCH_SESSION_AIF) {
+                run[count++] = entry;
+                continue;
+            }
+
+            if (count) {
+                session_obj_set_params_batch(obj, run, count);
+                count = 0;
+            }
+            entry->status = agm_params_batch_entry_apply(obj, entry);
+        }
+        if (count)
+            session_obj_set_params_batch(obj, run, count);
+    }
+
+    ret = 0;
+    for (i = 0; i < num_entries && !ret; i++)
+        ret = entries[i].status;
+
+done:
+    free(run);
+    free(done);
+    return ret;
+}
+
 int agm_set_params_with_tag_to_acdb(uint32_t session_id, uint32_t aif_id,
                                        void *payload, size_t size)
 {
@@ -536,6 +637,26 @@ error:
     return ret;
 }
 
+int agm_set_params_to_acdb_tunnel_batch(void *payload, size_t size)
+{
+    int ret = 0;
+
+    AGM_LOGD("enter\n");
+
+    if (!payload) {
+        AGM_LOGE("payload is nullptr");
+        return -EINVAL;
+    }
+
+    AGM_LOGD("payload size is 0x%zx", size);
+
+    ret = session_dummy_set_acdb_tunnel_batch(payload, size);
+    if (ret)
+        AGM_LOGE("Error:%d setting acdb tunnel batch", ret);
+
+    return ret;
+}
+
 int agm_session_register_cb(uint32_t session_id, agm_event_cb cb,
                             enum event_type evt_type, void *client_data)
 {
@@ -630,9 +751,95 @@ int agm_session_open(uint32_t session_id,
         AGM_LOGE("Invalid handle\n");
         return -EINVAL;
     }
+    agm_log_config_update();
     return session_obj_open(session_id, sess_mode, handle);
 }
 
+int agm_session_launch(struct agm_session_launch_config *config,
+                       uint64_t *hndl)
+{
+    struct session_obj *sess_obj = NULL;
+    uint32_t i;
+    int ret = 0;
+
+    if (!config || !hndl || (config->num_aifs && !config->aifs)) {
+        AGM_LOGE("Invalid launch config\n");
+        return -EINVAL;
+    }
+    agm_log_config_update();
+
+    for (i = 0; i < config->num_aifs; i++) {
+        if (!config->aifs[i].set_media_config)
+            continue;
+        ret = agm_aif_set_media_config(config->aifs[i].aif_id,
+                                       &config->aifs[i].media_config);
+        if (ret)
+            return ret;
+    }
+
+    ret = session_obj_get(config->session_id, &sess_obj);
+    if (ret) {
+        AGM_LOGE("Error getting session object\n");
+        return ret;
+    }
+
+    ret = session_obj_launch(sess_obj, config);
+    if (!ret)
+        *hndl = (uint64_t)sess_obj;
+
+    return ret;
+}
+
+static int agm_session_async(uint64_t hndl, enum agm_async_op op,
+                             uint64_t cookie)
+{
+    struct session_obj *handle = (struct session_obj *) hndl;
+
+    if (!handle || !session_obj_valid_check(hndl)) {
+        AGM_LOGE("Invalid handle\n");
+        return -EINVAL;
+    }
+
+    return session_obj_async_queue(handle, op, 0, false, cookie);
+}
+
+int agm_session_prepare_async(uint64_t hndl, uint64_t cookie)
+{
+    return agm_session_async(hndl, AGM_ASYNC_OP_PREPARE, cookie);
+}
+
+int agm_session_start_async(uint64_t hndl, uint64_t cookie)
+{
+    return agm_session_async(hndl, AGM_ASYNC_OP_START, cookie);
+}
+
+int agm_session_stop_async(uint64_t hndl, uint64_t cookie)
+{
+    return agm_session_async(hndl, AGM_ASYNC_OP_STOP, cookie);
+}
+
+int agm_session_close_async(uint64_t hndl, uint64_t cookie)
+{
+    return agm_session_async(hndl, AGM_ASYNC_OP_CLOSE, cookie);
+}
+
+int agm_session_aif_connect_async(uint32_t session_id, uint32_t aif_id,
+                                  bool state, uint64_t cookie)
+{
+    struct session_obj *obj = NULL;
+    int ret = 0;
+
+    ret = session_obj_get(session_id, &obj);
+    if (ret) {
+        AGM_LOGE("Error:%d retrieving session obj with session id=%d\n",
+                                                 ret, session_id);
+        return ret;
+    }
+
+    return session_obj_async_queue(obj, AGM_ASYNC_OP_AIF_CONNECT, aif_id,
+                                   state, cookie);
+}
+
 int agm_session_set_config(uint64_t hndl,
                            struct agm_session_config *stream_config,
                            struct agm_media_config *media_config,
@@ -885,6 +1092,29 @@ done:
     return ret;
 }
 
+int agm_session_set_standby(uint32_t session_id, bool enable)
+{
+    struct session_obj *obj = NULL;
+    int ret = 0;
+
+    ret = session_obj_get(session_id, &obj);
+    if (ret) {
+        AGM_LOGE("Error:%d retrieving session obj with session id=%d\n",
+                                         ret, session_id);
+        goto done;
+    }
+
+    ret = session_obj_set_standby(obj, enable);
+    if (ret) {
+        AGM_LOGE("Error:%d setting standby mode for session obj with \
+                       session id=%d\n", ret, session_id);
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
 int agm_session_eos(uint64_t handle)
 {
     if (!handle) {
@@ -1051,8 +1281,42 @@ int agm_session_write_datapath_params(uint32_t session_id, struct agm_buff *buff
     return session_obj_write_with_metadata(obj, buff, &consumed_size);
 }
 
+int agm_session_get_perf_stats(uint32_t session_id,
+                               struct agm_perf_stats *stats)
+{
+    struct session_obj *obj = NULL;
+    int ret = 0;
+
+    if (!stats) {
+        AGM_LOGE("Invalid stats\n");
+        return -EINVAL;
+    }
+
+    ret = session_obj_get(session_id, &obj);
+    if (ret) {
+        AGM_LOGE("Error:%d retrieving session obj with session id=%d\n",
+                                                 ret, session_id);
+        return ret;
+    }
+
+    return session_obj_get_perf_stats(obj, stats);
+}
+
+int agm_dump_to_fd(int fd)
+{
+    return dump_to_fd(fd);
+}
+
+int agm_dump_to_buffer(char *buf, size_t *size)
+{
+    return dump_to_buffer(buf, size);
+}
+
 int agm_dump(struct agm_dump_info *dump_info __unused)
 {
-    // Placeholder for future enhancements
+    dump_to_log();
+#ifdef AGM_TRACE_ENABLED
+    agm_trace_flush();
+#endif
     return 0;
 }
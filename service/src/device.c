@@ -28,6 +28,7 @@
 **/
 
 #define LOG_TAG "AGM: device"
+#define AGM_LOG_MODULE AGM_LOG_MOD_DEVICE
 
 #include <errno.h>
 #include <pthread.h>
@@ -39,6 +40,7 @@
 #include <unistd.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <agm/agm_trace.h>
 #include <agm/device.h>
 #include <agm/metadata.h>
 #include <agm/utils.h>
@@ -201,6 +203,7 @@ snd_pcm_format_t agm_to_alsa_format(enum agm_media_format format)
 
 int device_open(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_open");
     int ret = 0;
     snd_pcm_t *pcm;
     char pcm_name[80];
@@ -308,6 +311,7 @@ enum pcm_format agm_to_pcm_format(enum agm_media_format format)
 
 int device_open(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_open");
     int ret = 0;
     struct pcm *pcm = NULL;
     struct pcm_config config;
@@ -377,6 +381,7 @@ done:
 
 int device_prepare(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_prepare");
     int ret = 0;
     struct device_group_data *grp_data = NULL;
     struct device_obj *obj = NULL;
@@ -423,6 +428,7 @@ done:
 
 int device_start(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_start");
     int ret = 0;
     struct device_group_data *grp_data = NULL;
     struct device_obj *obj = NULL;
@@ -466,6 +472,7 @@ done:
 
 int device_stop(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_stop");
     int ret = 0;
     struct device_group_data *grp_data = NULL;
     struct device_obj *obj = NULL;
@@ -510,6 +517,7 @@ done:
 
 int device_close(struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("device_close");
     int ret = 0;
     struct device_group_data *grp_data = NULL;
     struct device_obj *obj = NULL;
@@ -61,6 +61,7 @@
 **/
 
 #define LOG_TAG "AGM: device"
+#define AGM_LOG_MODULE AGM_LOG_MOD_DEVICE
 
 #include <hw_intf_cmn_api.h>
 
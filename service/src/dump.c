@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#define LOG_TAG "AGM: dump"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <agm/dump.h>
+#include <agm/device.h>
+#include <agm/graph.h>
+#include <agm/session_obj.h>
+#include <agm/utils.h>
+
+/*
+ *The dump is a sequence of JSON objects, one per line:
+ *  {"type":"agm", ...}       header
+ *  {"type":"init", ...}      graph_init timing breakdown
+ *  {"type":"session", ...}   one per session, state/configs/aifs/graph
+ *  {"type":"perf", ...}      one per session, performance counters
+ *  {"type":"device", ...}    one per audio interface, refcounts/config
+ *Session state is read from the snapshot published by the control path
+ *and device state is copied field by field, so neither the session nor
+ *the device locks are taken. The output is formatted into memory first
+ *and written to a file descriptor only once the session pool lock is
+ *dropped, so a slow reader never blocks session open and close.
+ */
+
+#define DUMP_VERSION       1
+#define DUMP_LINE_MAX      4096
+#define DUMP_LOG_BUF_SIZE  (64 * 1024)
+
+struct dump_ctx {
+    /*destination buffer and its size*/
+    char *buf;
+    size_t size;
+    /*buf is owned by the dump and grown as needed*/
+    bool grow;
+    /*bytes produced so far, including the ones not fitting in buf*/
+    size_t len;
+    char line[DUMP_LINE_MAX];
+    size_t line_len;
+    int err;
+};
+
+void snapshot_write_begin(struct session_snapshot_seq *snap)
+{
+    __atomic_store_n(&snap->seq, snap->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void snapshot_write_end(struct session_snapshot_seq *snap)
+{
+    __atomic_store_n(&snap->seq, snap->seq + 1, __ATOMIC_RELEASE);
+}
+
+void snapshot_read(const struct session_snapshot_seq *snap,
+                   struct session_snapshot *out)
+{
+    uint32_t seq_begin, seq_end;
+
+    do {
+        seq_begin = __atomic_load_n(&snap->seq, __ATOMIC_ACQUIRE);
+        if (seq_begin & 1)
+            continue;
+        memcpy(out, &snap->data, sizeof(struct session_snapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_end = __atomic_load_n(&snap->seq, __ATOMIC_RELAXED);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+}
+
+static void dump_printf(struct dump_ctx *ctx, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+    size_t avail = DUMP_LINE_MAX - ctx->line_len;
+
+    va_start(ap, fmt);
+    n = vsnprintf(ctx->line + ctx->line_len, avail, fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+        return;
+    if ((size_t)n >= avail) {
+        AGM_LOGE("dump line truncated\n");
+        ctx->line_len = DUMP_LINE_MAX - 1;
+        return;
+    }
+    ctx->line_len += n;
+}
+
+/*JSON string, quoted and with quotes, backslashes and controls escaped*/
+static void dump_string(struct dump_ctx *ctx, const char *str)
+{
+    const unsigned char *c;
+
+    dump_printf(ctx, "\"");
+    for (c = (const unsigned char *)str; c && *c; c++) {
+        if (*c == '"' || *c == '\\')
+            dump_printf(ctx, "\\%c", *c);
+        else if (*c < 0x20)
+            dump_printf(ctx, "\\u%04x", *c);
+        else
+            dump_printf(ctx, "%c", *c);
+    }
+    dump_printf(ctx, "\"");
+}
+
+static void dump_end_line(struct dump_ctx *ctx)
+{
+    size_t n = 0;
+    char *buf = NULL;
+
+    dump_printf(ctx, "}\n");
+
+    if (ctx->grow && !ctx->err && ctx->len + ctx->line_len > ctx->size) {
+        n = ctx->size ? ctx->size : DUMP_LINE_MAX;
+        while (n < ctx->len + ctx->line_len)
+            n *= 2;
+        buf = realloc(ctx->buf, n);
+        if (!buf) {
+            AGM_LOGE("No memory for dump buffer\n");
+            ctx->err = -ENOMEM;
+        } else {
+            ctx->buf = buf;
+            ctx->size = n;
+        }
+    }
+
+    if (ctx->buf && ctx->len < ctx->size) {
+        n = ctx->size - ctx->len;
+        if (n > ctx->line_len)
+            n = ctx->line_len;
+        memcpy(ctx->buf + ctx->len, ctx->line, n);
+    }
+    ctx->len += ctx->line_len;
+    ctx->line_len = 0;
+}
+
+static void dump_media_config(struct dump_ctx *ctx, const char *name,
+                              const struct agm_media_config *config)
+{
+    dump_printf(ctx, "\"%s\":{\"rate\":%u,\"channels\":%u,\"format\":%d,"
+                "\"data_format\":%u}", name, config->rate, config->channels,
+                config->format, config->data_format);
+}
+
+static void dump_buffer_config(struct dump_ctx *ctx, const char *name,
+                               const struct agm_buffer_config *config)
+{
+    dump_printf(ctx, "\"%s\":{\"count\":%u,\"size\":%zu,"
+                "\"max_metadata_size\":%zu}", name, config->count,
+                config->size, config->max_metadata_size);
+}
+
+static const char *dump_session_state(uint32_t state)
+{
+    switch (state) {
+    case SESSION_CLOSED: return "CLOSED";
+    case SESSION_OPENED: return "OPENED";
+    case SESSION_PREPARED: return "PREPARED";
+    case SESSION_STARTED: return "STARTED";
+    case SESSION_STOPPED: return "STOPPED";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char *dump_aif_state(uint32_t state)
+{
+    switch (state) {
+    case AIF_CLOSED: return "CLOSED";
+    case AIF_CLOSE: return "CLOSE";
+    case AIF_OPEN: return "OPEN";
+    case AIF_OPENED: return "OPENED";
+    case AIF_STOPPED: return "STOPPED";
+    case AIF_PREPARED: return "PREPARED";
+    case AIF_STARTED: return "STARTED";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char *dump_graph_state(uint32_t state)
+{
+    switch (state) {
+    case CLOSED: return "CLOSED";
+    case OPENED: return "OPENED";
+    case PREPARED: return "PREPARED";
+    case STARTED: return "STARTED";
+    case STOPPED: return "STOPPED";
+    default: return "UNKNOWN";
+    }
+}
+
+static const char *dump_device_state(int state)
+{
+    switch (state) {
+    case DEV_CLOSED: return "CLOSED";
+    case DEV_OPENED: return "OPENED";
+    case DEV_PREPARED: return "PREPARED";
+    case DEV_STARTED: return "STARTED";
+    case DEV_STOPPED: return "STOPPED";
+    default: return "UNKNOWN";
+    }
+}
+
+static void dump_session(struct dump_ctx *ctx, uint32_t sess_id,
+                         const struct session_snapshot *snap)
+{
+    const struct module_snapshot *mod;
+    uint32_t i;
+
+    dump_printf(ctx, "{\"type\":\"session\",\"id\":%u,\"state\":\"%s\","
+                "\"sess_mode\":%d,\"dir\":%d,\"standby\":%s,",
+                sess_id, dump_session_state(snap->state),
+                snap->stream_config.sess_mode, snap->stream_config.dir,
+                snap->standby_enabled ? "true" : "false");
+    dump_printf(ctx, "\"loopback\":{\"enabled\":%s,\"session\":%u},"
+                "\"ec_ref\":{\"enabled\":%s,\"aif\":%u},",
+                snap->loopback_state ? "true" : "false",
+                snap->loopback_sess_id,
+                snap->ec_ref_state ? "true" : "false", snap->ec_ref_aif_id);
+    dump_media_config(ctx, "in_media_config", &snap->in_media_config);
+    dump_printf(ctx, ",");
+    dump_media_config(ctx, "out_media_config", &snap->out_media_config);
+    dump_printf(ctx, ",");
+    dump_buffer_config(ctx, "in_buffer_config", &snap->in_buffer_config);
+    dump_printf(ctx, ",");
+    dump_buffer_config(ctx, "out_buffer_config", &snap->out_buffer_config);
+
+    dump_printf(ctx, ",\"num_aifs\":%u,\"aifs_truncated\":%s,\"aifs\":[",
+                snap->total_aifs,
+                snap->total_aifs > snap->num_aifs ? "true" : "false");
+    for (i = 0; i < snap->num_aifs; i++)
+        dump_printf(ctx, "%s{\"id\":%u,\"state\":\"%s\"}", i ? "," : "",
+                    snap->aifs[i].aif_id, dump_aif_state(snap->aifs[i].state));
+    dump_printf(ctx, "]");
+
+    if (!snap->graph.valid) {
+        dump_printf(ctx, ",\"graph\":null");
+        dump_end_line(ctx);
+        return;
+    }
+    dump_printf(ctx, ",\"graph\":{\"state\":\"%s\",\"skipped_module_cfgs\":%u,"
+                "\"num_modules\":%u,\"modules_truncated\":%s,\"modules\":[",
+                dump_graph_state(snap->graph.state),
+                snap->graph.mod_cfg_skip_cnt, snap->graph.total_modules,
+                snap->graph.total_modules > snap->graph.num_modules ?
+                "true" : "false");
+    for (i = 0; i < snap->graph.num_modules; i++) {
+        mod = &snap->graph.modules[i];
+        dump_printf(ctx, "%s{\"tag\":\"0x%x\",\"mid\":\"0x%x\","
+                    "\"miid\":\"0x%x\",\"configured\":%s}", i ? "," : "",
+                    mod->tag, mod->mid, mod->miid,
+                    mod->is_configured ? "true" : "false");
+    }
+    dump_printf(ctx, "]}");
+    dump_end_line(ctx);
+}
+
+static void dump_perf(struct dump_ctx *ctx, const struct agm_perf_stats *stats)
+{
+    const struct agm_perf_op_stats *op_stats;
+    int op, i;
+
+    dump_printf(ctx, "{\"type\":\"perf\",\"session\":%u,\"ops\":{",
+                stats->session_id);
+    for (op = 0; op < AGM_PERF_OP_MAX; op++) {
+        op_stats = &stats->op[op];
+        dump_printf(ctx, "%s\"%s\":{\"count\":%" PRIu64 ",\"errors\":%" PRIu64
+                    ",\"total_us\":%" PRIu64 ",\"max_us\":%" PRIu64
+                    ",\"bytes\":%" PRIu64 ",\"hist\":[", op ? "," : "",
+                    perf_op_name(op), op_stats->count, op_stats->errors,
+                    op_stats->total_us, op_stats->max_us, op_stats->bytes);
+        for (i = 0; i < AGM_PERF_HIST_BUCKETS; i++)
+            dump_printf(ctx, "%s%u", i ? "," : "", op_stats->hist[i]);
+        dump_printf(ctx, "]}");
+    }
+    dump_printf(ctx, "}");
+    dump_end_line(ctx);
+}
+
+static void dump_device(struct dump_ctx *ctx, uint32_t idx,
+                        struct device_obj *dev_obj)
+{
+    struct agm_media_config media_config = dev_obj->media_config;
+
+    dump_printf(ctx, "{\"type\":\"device\",\"id\":%u,\"name\":", idx);
+    dump_string(ctx, dev_obj->name);
+    dump_printf(ctx, ",\"pcm_id\":%u,\"intf\":%u,\"dir\":%u,\"virtual\":%s,"
+                "\"state\":\"%s\",", dev_obj->pcm_id,
+                dev_obj->hw_ep_info.intf, dev_obj->hw_ep_info.dir,
+                dev_obj->is_virtual_device ? "true" : "false",
+                dump_device_state(device_get_state(dev_obj)));
+    dump_printf(ctx, "\"refcnt\":{\"open\":%d,\"prepare\":%d,\"start\":%d},",
+                dev_obj->refcnt.open, dev_obj->refcnt.prepare,
+                dev_obj->refcnt.start);
+    dump_media_config(ctx, "media_config", &media_config);
+    dump_end_line(ctx);
+}
+
+static void dump_init(struct dump_ctx *ctx)
+{
+    struct graph_init_stats stats;
+
+    graph_get_init_stats(&stats);
+    dump_printf(ctx, "{\"type\":\"init\",\"ret\":%d,\"total_us\":%" PRIu64
+                ",\"card_wait_us\":%" PRIu64 ",\"acdb_files_us\":%" PRIu64
+                ",\"acdb_manifest_hit\":%s,\"acdb_manifest_retry\":%s,"
+                "\"num_acdb_files\":%u,\"acdb_delta_present\":%s,",
+                stats.ret, stats.total_us,
+                stats.card_wait_us, stats.acdb_files_us,
+                stats.acdb_manifest_hit ? "true" : "false",
+                stats.acdb_manifest_retry ? "true" : "false",
+                stats.num_acdb_files,
+                stats.acdb_delta_present ? "true" : "false");
+    dump_printf(ctx, "\"gsl_init\":{\"total_us\":%" PRIu64
+                ",\"max_num_ready_checks\":%u,\"ready_check_interval_ms\":%u}",
+                stats.gsl_init_us, stats.max_num_ready_checks,
+                stats.ready_check_interval_ms);
+    dump_end_line(ctx);
+}
+
+static void dump_state(struct dump_ctx *ctx)
+{
+    struct session_obj *sess_obj;
+    struct session_snapshot *snap;
+    struct agm_perf_stats stats;
+    struct device_obj *dev_obj;
+    struct listnode *node;
+    size_t num_devices = 0;
+    size_t num_sessions = 0;
+    uint32_t i;
+
+    snap = calloc(1, sizeof(struct session_snapshot));
+    if (!snap) {
+        AGM_LOGE("No memory for session snapshot\n");
+        ctx->err = -ENOMEM;
+        return;
+    }
+
+    device_get_aif_info_list(NULL, &num_devices);
+    pthread_mutex_lock(&sess_pool->lock);
+    list_for_each(node, &sess_pool->session_list)
+        num_sessions++;
+
+    dump_printf(ctx, "{\"type\":\"agm\",\"version\":%d,\"timestamp_us\":%"
+                PRIu64 ",\"num_sessions\":%zu,\"num_devices\":%zu",
+                DUMP_VERSION, perf_now_us(), num_sessions, num_devices);
+    dump_end_line(ctx);
+    dump_init(ctx);
+
+    list_for_each(node, &sess_pool->session_list) {
+        sess_obj = node_to_item(node, struct session_obj, node);
+        snapshot_read(&sess_obj->snapshot, snap);
+        dump_session(ctx, sess_obj->sess_id, snap);
+        perf_snapshot(&sess_obj->perf, &stats);
+        dump_perf(ctx, &stats);
+    }
+    pthread_mutex_unlock(&sess_pool->lock);
+
+    for (i = 0; i < num_devices; i++) {
+        if (device_get_obj(i, &dev_obj))
+            continue;
+        dump_device(ctx, i, dev_obj);
+    }
+
+    free(snap);
+}
+
+int dump_to_fd(int fd)
+{
+    struct dump_ctx *ctx = NULL;
+    size_t n = 0;
+    ssize_t written;
+    int ret = 0;
+
+    if (fd < 0)
+        return -EINVAL;
+
+    ctx = calloc(1, sizeof(struct dump_ctx));
+    if (!ctx)
+        return -ENOMEM;
+
+    ctx->grow = true;
+    dump_state(ctx);
+    ret = ctx->err;
+
+    while (!ret && n < ctx->len) {
+        written = write(fd, ctx->buf + n, ctx->len - n);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            ret = -errno;
+            AGM_LOGE("dump write failed %d\n", ret);
+            break;
+        }
+        n += written;
+    }
+
+    free(ctx->buf);
+    free(ctx);
+    return ret;
+}
+
+int dump_to_buffer(char *buf, size_t *size)
+{
+    struct dump_ctx *ctx = NULL;
+    int ret = 0;
+
+    if (size == NULL || (buf == NULL && *size))
+        return -EINVAL;
+
+    ctx = calloc(1, sizeof(struct dump_ctx));
+    if (!ctx)
+        return -ENOMEM;
+
+    ctx->buf = buf;
+    ctx->size = *size;
+    dump_state(ctx);
+    ret = ctx->err;
+    if (!ret && ctx->len > ctx->size)
+        ret = -ENOSPC;
+    *size = ctx->len;
+    free(ctx);
+    return ret;
+}
+
+void dump_to_log(void)
+{
+    char *buf = NULL, *line = NULL, *next = NULL;
+    size_t size = DUMP_LOG_BUF_SIZE;
+    int ret = 0;
+
+    buf = calloc(1, size + 1);
+    if (!buf) {
+        AGM_LOGE("No memory for dump buffer\n");
+        return;
+    }
+
+    ret = dump_to_buffer(buf, &size);
+    if (ret && ret != -ENOSPC) {
+        AGM_LOGE("dump failed %d\n", ret);
+        goto done;
+    }
+    if (ret == -ENOSPC)
+        AGM_LOGI("dump truncated to %d of %zu bytes\n",
+                 DUMP_LOG_BUF_SIZE, size);
+
+    for (line = strtok_r(buf, "\n", &next); line != NULL;
+         line = strtok_r(NULL, "\n", &next))
+        AGM_LOGI("%s\n", line);
+
+done:
+    free(buf);
+}
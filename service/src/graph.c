@@ -60,16 +60,22 @@
  */
 
 #define LOG_TAG "AGM: graph"
+#define AGM_LOG_MODULE AGM_LOG_MOD_GRAPH
 
 #include <errno.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include "gsl_intf.h"
+#include <agm/agm_trace.h>
 #include <agm/graph.h>
 #include <agm/graph_module.h>
 #include <agm/metadata.h>
@@ -115,7 +121,133 @@ typedef struct module_info_link_list {
    struct listnode tagged_list;
 }module_info_link_list_t;
 
+#define IS_HW_EP_MODULE(mod) (((mod)->tag == DEVICE_HW_ENDPOINT_RX) || \
+                              ((mod)->tag == DEVICE_HW_ENDPOINT_TX))
+
+static bool gkv_equal(const struct agm_key_vector_gsl *a,
+                      const struct agm_key_vector_gsl *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    if (a->num_kvs != b->num_kvs)
+        return false;
+
+    return !memcmp(a->kv, b->kv, a->num_kvs * sizeof(struct agm_key_value));
+}
+
+static struct agm_key_vector_gsl *gkv_dup(const struct agm_key_vector_gsl *src)
+{
+    struct agm_key_vector_gsl *gkv = NULL;
+
+    gkv = calloc(1, sizeof(struct agm_key_vector_gsl));
+    if (!gkv) {
+        AGM_LOGE("No memory to allocate for gkv\n");
+        return NULL;
+    }
+    gkv->num_kvs = src->num_kvs;
+    gkv->kv = calloc(gkv->num_kvs, sizeof(struct agm_key_value));
+    if (!gkv->kv) {
+        AGM_LOGE("No memory to allocate for kv\n");
+        free(gkv);
+        return NULL;
+    }
+    memcpy(gkv->kv, src->kv, gkv->num_kvs * sizeof(struct agm_key_value));
+    return gkv;
+}
+
+/*codec dma and slimbus endpoints are configured from the channel map*/
+static bool hw_ep_uses_chmap(struct device_obj *dev_obj)
+{
+    return dev_obj->hw_ep_info.intf == CODEC_DMA ||
+           dev_obj->hw_ep_info.intf == SLIMBUS;
+}
+
+static void hw_ep_free_cfg_snapshot(module_info_t *mod)
+{
+    if (mod->cfg_gkv) {
+        free(mod->cfg_gkv->kv);
+        free(mod->cfg_gkv);
+        mod->cfg_gkv = NULL;
+    }
+    mod->cfg_snapshot_valid = false;
+}
+
+/**
+ *Remember the device inputs a hw ep module got configured with, so that
+ *a later device switch can tell whether the module needs reconfiguring.
+ */
+static void hw_ep_save_cfg_snapshot(module_info_t *mod)
+{
+    struct device_obj *dev_obj = mod->dev_obj;
+    uint32_t *chmap = NULL;
+
+    hw_ep_free_cfg_snapshot(mod);
+    if (!IS_HW_EP_MODULE(mod) || dev_obj == NULL || mod->gkv == NULL)
+        return;
+
+    memset(mod->cfg_chmap, 0, sizeof(mod->cfg_chmap));
+    if (hw_ep_uses_chmap(dev_obj)) {
+        if (device_get_channel_map(dev_obj, &chmap) || chmap == NULL)
+            return;
+        memcpy(mod->cfg_chmap, chmap, sizeof(mod->cfg_chmap));
+        free(chmap);
+    }
+
+    mod->cfg_gkv = gkv_dup(mod->gkv);
+    if (mod->cfg_gkv == NULL)
+        return;
+
+    mod->cfg_media_config = dev_obj->media_config;
+    if (dev_obj->group_data)
+        mod->cfg_grp_media_config = dev_obj->group_data->media_config;
+    else
+        memset(&mod->cfg_grp_media_config, 0,
+               sizeof(struct agm_group_media_config));
+    mod->cfg_snapshot_valid = true;
+}
+
+/**
+ *Returns true if the hw ep module has to be configured again, i.e
+ *it was never configured or its device, gkv, media config or channel
+ *map differ from the ones it was last configured with.
+ */
+static bool hw_ep_cfg_changed(module_info_t *mod, struct device_obj *dev_obj,
+                              const struct agm_key_vector_gsl *gkv)
+{
+    struct agm_group_media_config grp_config = {0};
+    uint32_t *chmap = NULL;
+    bool changed = false;
+
+    if (!mod->cfg_snapshot_valid || mod->dev_obj != dev_obj)
+        return true;
+
+    if (!gkv_equal(mod->cfg_gkv, gkv))
+        return true;
+
+    if (memcmp(&mod->cfg_media_config, &dev_obj->media_config,
+               sizeof(struct agm_media_config)))
+        return true;
+
+    if (dev_obj->group_data)
+        grp_config = dev_obj->group_data->media_config;
+
+    if (memcmp(&mod->cfg_grp_media_config, &grp_config,
+               sizeof(struct agm_group_media_config)))
+        return true;
+
+    if (!hw_ep_uses_chmap(dev_obj))
+        return false;
+
+    if (device_get_channel_map(dev_obj, &chmap) || chmap == NULL)
+        return true;
+    changed = memcmp(mod->cfg_chmap, chmap, sizeof(mod->cfg_chmap)) != 0;
+    free(chmap);
+    return changed;
+}
+
 static char acdb_path[ACDB_PATH_MAX_LENGTH];
+static struct graph_init_stats init_stats;
 static void print_graph_alias(const struct agm_meta_data_gsl *meta_data_kv);
 
 static int get_acdb_files_from_directory(const char* acdb_files_path,
@@ -172,6 +304,301 @@ done:
     return ret;
 }
 
+#ifdef ACDB_MANIFEST_FILE
+/*
+ *Listing of the acdb directory saved from a previous boot. The directory
+ *mtime changes whenever a file is added, removed or renamed, and each
+ *listed file is stat'ed against its recorded inode, size and mtime, which
+ *catches files replaced in place by an update. A manifest that still
+ *matches can stand in for the scan. It is a plain image of the gsl file
+ *list and is loaded with a single read.
+ */
+#define ACDB_MANIFEST_MAGIC   0x4d424441 /*"ADBM"*/
+#define ACDB_MANIFEST_VERSION 2
+
+struct acdb_manifest_file_st {
+    uint64_t ino;
+    int64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+};
+
+struct acdb_manifest {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t files_size;
+    uint32_t reserved;
+    uint64_t dir_ino;
+    int64_t dir_mtime_sec;
+    int64_t dir_mtime_nsec;
+    char dir[ACDB_PATH_MAX_LENGTH];
+    struct gsl_acdb_data_files files;
+    struct acdb_manifest_file_st file_st[GSL_MAX_NUM_OF_ACDB_FILES];
+};
+
+static int acdb_manifest_file_stat(const char *file_name,
+                                   struct acdb_manifest_file_st *file_st)
+{
+    struct stat st;
+
+    if (stat(file_name, &st))
+        return -errno;
+
+    file_st->ino = (uint64_t)st.st_ino;
+    file_st->size = (int64_t)st.st_size;
+    file_st->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    file_st->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    return 0;
+}
+
+static int acdb_manifest_load(const char *acdb_files_path,
+                              const struct stat *dir_st,
+                              struct gsl_acdb_data_files *data_files)
+{
+    struct acdb_manifest *manifest = NULL;
+    struct acdb_manifest_file_st file_st;
+    ssize_t len = 0;
+    uint32_t i;
+    int fd = -1;
+    int ret = -ENOENT;
+
+    manifest = calloc(1, sizeof(struct acdb_manifest));
+    if (!manifest)
+        return -ENOMEM;
+
+    fd = open(ACDB_MANIFEST_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        goto done;
+
+    len = read(fd, manifest, sizeof(struct acdb_manifest));
+    if (len != (ssize_t)sizeof(struct acdb_manifest) ||
+        manifest->magic != ACDB_MANIFEST_MAGIC ||
+        manifest->version != ACDB_MANIFEST_VERSION ||
+        manifest->files_size != sizeof(struct gsl_acdb_data_files) ||
+        manifest->dir_ino != (uint64_t)dir_st->st_ino ||
+        manifest->dir_mtime_sec != (int64_t)dir_st->st_mtim.tv_sec ||
+        manifest->dir_mtime_nsec != (int64_t)dir_st->st_mtim.tv_nsec ||
+        strncmp(manifest->dir, acdb_files_path, ACDB_PATH_MAX_LENGTH) ||
+        manifest->files.num_files == 0 ||
+        manifest->files.num_files > GSL_MAX_NUM_OF_ACDB_FILES) {
+        AGM_LOGI("acdb manifest is stale, rescanning %s\n", acdb_files_path);
+        goto done;
+    }
+
+    for (i = 0; i < manifest->files.num_files; i++) {
+        if (manifest->files.acdbFiles[i].fileNameLen >=
+                sizeof(manifest->files.acdbFiles[i].fileName) ||
+            manifest->files.acdbFiles[i].fileName[
+                manifest->files.acdbFiles[i].fileNameLen] != '\0') {
+            AGM_LOGE("corrupt acdb manifest entry %d\n", i);
+            goto done;
+        }
+        if (acdb_manifest_file_stat(manifest->files.acdbFiles[i].fileName,
+                                    &file_st) ||
+            memcmp(&file_st, &manifest->file_st[i], sizeof(file_st))) {
+            AGM_LOGI("acdb file %s changed, rescanning %s\n",
+                     manifest->files.acdbFiles[i].fileName, acdb_files_path);
+            goto done;
+        }
+        AGM_LOGI("Load file: %s\n", manifest->files.acdbFiles[i].fileName);
+    }
+
+    memcpy(data_files, &manifest->files, sizeof(struct gsl_acdb_data_files));
+    ret = 0;
+
+done:
+    if (fd >= 0)
+        close(fd);
+    free(manifest);
+    return ret;
+}
+
+static void acdb_manifest_save(const char *acdb_files_path,
+                               const struct stat *dir_st,
+                               const struct gsl_acdb_data_files *data_files)
+{
+    struct acdb_manifest *manifest = NULL;
+    char tmp_path[] = ACDB_MANIFEST_FILE ".tmp";
+    size_t off = 0;
+    ssize_t len = 0;
+    uint32_t i;
+    int fd = -1;
+
+    manifest = calloc(1, sizeof(struct acdb_manifest));
+    if (!manifest)
+        return;
+
+    manifest->magic = ACDB_MANIFEST_MAGIC;
+    manifest->version = ACDB_MANIFEST_VERSION;
+    manifest->files_size = sizeof(struct gsl_acdb_data_files);
+    manifest->dir_ino = (uint64_t)dir_st->st_ino;
+    manifest->dir_mtime_sec = (int64_t)dir_st->st_mtim.tv_sec;
+    manifest->dir_mtime_nsec = (int64_t)dir_st->st_mtim.tv_nsec;
+    strlcpy(manifest->dir, acdb_files_path, ACDB_PATH_MAX_LENGTH);
+    memcpy(&manifest->files, data_files, sizeof(struct gsl_acdb_data_files));
+    for (i = 0; i < data_files->num_files; i++) {
+        if (acdb_manifest_file_stat(data_files->acdbFiles[i].fileName,
+                                    &manifest->file_st[i])) {
+            AGM_LOGD("cannot stat %s, manifest not saved\n",
+                     data_files->acdbFiles[i].fileName);
+            goto done;
+        }
+    }
+
+    /*write aside and rename, a reader never sees a partial manifest*/
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        AGM_LOGD("cannot create %s, errno %d\n", tmp_path, errno);
+        goto done;
+    }
+    while (off < sizeof(struct acdb_manifest)) {
+        len = write(fd, (uint8_t *)manifest + off,
+                    sizeof(struct acdb_manifest) - off);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            AGM_LOGE("acdb manifest write failed, errno %d\n", errno);
+            break;
+        }
+        off += len;
+    }
+    if (close(fd) || off != sizeof(struct acdb_manifest) ||
+        rename(tmp_path, ACDB_MANIFEST_FILE)) {
+        AGM_LOGE("acdb manifest not saved, errno %d\n", errno);
+        unlink(tmp_path);
+    }
+
+done:
+    free(manifest);
+}
+#endif
+
+/*fill data_files from the acdb manifest, scanning the directory on a miss*/
+static int get_acdb_files(const char *acdb_files_path,
+                          struct gsl_acdb_data_files *data_files)
+{
+    int ret = 0;
+#ifdef ACDB_MANIFEST_FILE
+    struct stat dir_st;
+    bool have_st = false;
+
+    if (!stat(acdb_files_path, &dir_st)) {
+        have_st = true;
+        if (!acdb_manifest_load(acdb_files_path, &dir_st, data_files)) {
+            init_stats.acdb_manifest_hit = true;
+            return 0;
+        }
+    }
+#endif
+
+    ret = get_acdb_files_from_directory(acdb_files_path, data_files);
+
+#ifdef ACDB_MANIFEST_FILE
+    if (!ret && have_st && data_files->num_files)
+        acdb_manifest_save(acdb_files_path, &dir_st, data_files);
+#endif
+    return ret;
+}
+
+/*
+ *Tag lookups go through a sorted array instead of walking
+ *tagged_mod_list, the list stays the owner of the module objects.
+ *On failure the previous table is left in place, callers undo their
+ *list changes so it still matches the list.
+ */
+int graph_tag_table_build(struct graph_obj *graph_obj)
+{
+    struct graph_tag_entry *table = NULL, entry;
+    struct listnode *node = NULL;
+    module_info_t *mod = NULL;
+    uint32_t cnt = 0, i, j;
+
+    list_for_each(node, &graph_obj->tagged_mod_list)
+        cnt++;
+
+    if (cnt) {
+        table = calloc(cnt, sizeof(struct graph_tag_entry));
+        if (!table) {
+            AGM_LOGE("No memory for tag table of %u modules\n", cnt);
+            return -ENOMEM;
+        }
+    }
+
+    /*insertion sort, stable so modules sharing a tag keep list order*/
+    i = 0;
+    list_for_each(node, &graph_obj->tagged_mod_list) {
+        mod = node_to_item(node, module_info_t, list);
+        entry.tag = mod->tag;
+        entry.miid = mod->miid;
+        entry.mod = mod;
+        for (j = i; j > 0 && table[j - 1].tag > entry.tag; j--)
+            table[j] = table[j - 1];
+        table[j] = entry;
+        i++;
+    }
+
+    free(graph_obj->tag_table);
+    graph_obj->tag_table = table;
+    graph_obj->tag_table_cnt = cnt;
+    return 0;
+}
+
+void graph_tag_table_free(struct graph_obj *graph_obj)
+{
+    free(graph_obj->tag_table);
+    graph_obj->tag_table = NULL;
+    graph_obj->tag_table_cnt = 0;
+}
+
+uint32_t graph_tag_table_lookup(struct graph_obj *graph_obj, uint32_t tag)
+{
+    uint32_t lo = 0, hi = graph_obj->tag_table_cnt, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (graph_obj->tag_table[mid].tag < tag)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ *gsl wrappers used for all graph commands and module configuration, they
+ *account each call in the performance counters of the owning session.
+ */
+int graph_gsl_ioctl(struct graph_obj *graph_obj, enum gsl_cmd_id cmd_id,
+                    void *payload, size_t payload_size)
+{
+    AGM_TRACE_SCOPE("graph_gsl_ioctl");
+    int ret = 0;
+    uint64_t start_us = perf_now_us();
+
+    ret = gsl_ioctl(graph_obj->graph_handle, cmd_id, payload,
+                    (uint32_t)payload_size);
+    if (graph_obj->sess_obj)
+        perf_record(&graph_obj->sess_obj->perf, AGM_PERF_OP_GSL_IOCTL,
+                    start_us, 0, ret);
+    return ret;
+}
+
+int graph_gsl_set_custom_config(struct graph_obj *graph_obj,
+                                const uint8_t *payload, size_t payload_size)
+{
+    AGM_TRACE_SCOPE("graph_gsl_set_custom_config");
+    int ret = 0;
+    uint64_t start_us = perf_now_us();
+
+    ret = gsl_set_custom_config(graph_obj->graph_handle, payload,
+                                (uint32_t)payload_size);
+    if (graph_obj->sess_obj)
+        perf_record(&graph_obj->sess_obj->perf,
+                    AGM_PERF_OP_GSL_SET_CUSTOM_CONFIG, start_us,
+                    payload_size, ret);
+    return ret;
+}
+
 #define PULL_PUSH_SHMEM_ENDPOINT SHMEM_ENDPOINT /** Temp: till pull mode keys are defined */
 int configure_buffer_params(struct graph_obj *gph_obj,
                             struct session_obj *sess_obj)
@@ -227,7 +654,7 @@ int configure_buffer_params(struct graph_obj *gph_obj,
 
         cmd_id = GSL_CMD_CONFIGURE_READ_PARAMS;
 
-        ret = gsl_ioctl(gph_obj->graph_handle, cmd_id, &buf_config, size);
+        ret = graph_gsl_ioctl(gph_obj, cmd_id, &buf_config, size);
         if (ret != 0)
             goto done;
 
@@ -245,7 +672,7 @@ int configure_buffer_params(struct graph_obj *gph_obj,
         buf_config.shmem_ep_tag = WR_SHMEM_ENDPOINT;
         cmd_id = GSL_CMD_CONFIGURE_WRITE_PARAMS;
 
-        ret = gsl_ioctl(gph_obj->graph_handle, cmd_id, &buf_config, size);
+        ret = graph_gsl_ioctl(gph_obj, cmd_id, &buf_config, size);
 
     } else {
         if (sess_obj->stream_config.dir == TX)
@@ -299,7 +726,7 @@ int configure_buffer_params(struct graph_obj *gph_obj,
         else
            cmd_id = GSL_CMD_CONFIGURE_READ_PARAMS;
 
-        ret = gsl_ioctl(gph_obj->graph_handle, cmd_id, &buf_config, size);
+        ret = graph_gsl_ioctl(gph_obj, cmd_id, &buf_config, size);
     }
 done:
     if (ret != 0) {
@@ -342,6 +769,9 @@ int graph_init()
     const char *delta_file_path;
     char file_path_extn[FILE_PATH_EXTN_MAX_SIZE] = {0};
     bool snd_card_found = false;
+    struct stat delta_st;
+    uint64_t init_start_us = perf_now_us();
+    uint64_t start_us = init_start_us;
 
 #ifndef ACDB_PATH
 #  error "Define -DACDB_PATH="PATH" in the makefile to compile"
@@ -349,7 +779,9 @@ int graph_init()
     /*Populate acdbfiles from the shared file path*/
     acdb_files.num_files = 0;
 
+    memset(&init_stats, 0, sizeof(init_stats));
     snd_card_found = get_file_path_extn(file_path_extn);
+    init_stats.card_wait_us = perf_now_us() - start_us;
     if (snd_card_found) {
         if (get_soc_id() == ARRAX_SOC_ID) {
             snprintf(acdb_path, ACDB_PATH_MAX_LENGTH, "%s%s%s", ACDB_PATH, file_path_extn, ARRAX_FILE_PATH_EXTN);
@@ -362,7 +794,10 @@ int graph_init()
     }
     AGM_LOGI("acdb file path: %s\n", acdb_path);
 
-    ret = get_acdb_files_from_directory(acdb_path, &acdb_files);
+    start_us = perf_now_us();
+    ret = get_acdb_files(acdb_path, &acdb_files);
+    init_stats.acdb_files_us = perf_now_us() - start_us;
+    init_stats.num_acdb_files = acdb_files.num_files;
     if (ret)
        goto err;
 
@@ -375,6 +810,9 @@ int graph_init()
     }
     delta_file.fileNameLen = strlen(delta_file_path) + 1;
     ret = strlcpy(delta_file.fileName, delta_file_path, delta_file.fileNameLen);
+    init_stats.acdb_delta_present = !stat(delta_file_path, &delta_st);
+    if (!init_stats.acdb_delta_present)
+        AGM_LOGI("acdb delta path %s not present yet\n", delta_file_path);
 #else
 #  error "Define -DACDB_DELTA_FILE_PATH="PATH" in the makefile to compile"
 #endif
@@ -384,26 +822,68 @@ int graph_init()
     init_data.acdb_addr = 0x0;
     init_data.max_num_ready_checks = 1;
     init_data.ready_check_interval_ms = 1000;
+    init_stats.max_num_ready_checks = init_data.max_num_ready_checks;
+    init_stats.ready_check_interval_ms = init_data.ready_check_interval_ms;
+
+    start_us = perf_now_us();
     ret = gsl_init(&init_data);
+    init_stats.gsl_init_us = perf_now_us() - start_us;
+
+#ifdef ACDB_MANIFEST_FILE
+    /*the cached listing may be wrong, drop it and retry with a real scan*/
+    if (ret != 0 && init_stats.acdb_manifest_hit) {
+        AGM_LOGE("gsl_init failed error %d with cached acdb listing\n", ret);
+        unlink(ACDB_MANIFEST_FILE);
+        init_stats.acdb_manifest_hit = false;
+        init_stats.acdb_manifest_retry = true;
+        memset(&acdb_files, 0, sizeof(acdb_files));
+        ret = get_acdb_files(acdb_path, &acdb_files);
+        init_stats.num_acdb_files = acdb_files.num_files;
+        if (ret)
+            goto err;
+        start_us = perf_now_us();
+        ret = gsl_init(&init_data);
+        init_stats.gsl_init_us = perf_now_us() - start_us;
+    }
+#endif
+
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("gsl_init failed error %d \n", ret);
     }
 
 err:
+    init_stats.total_us = perf_now_us() - init_start_us;
+    init_stats.ret = ret;
+    AGM_LOGI("init took %" PRIu64 " us: card %" PRIu64 " acdb files %" PRIu64
+             " (manifest %s) gsl_init %" PRIu64 "\n",
+             init_stats.total_us, init_stats.card_wait_us,
+             init_stats.acdb_files_us,
+             init_stats.acdb_manifest_hit ? "hit" :
+             init_stats.acdb_manifest_retry ? "retried" : "miss",
+             init_stats.gsl_init_us);
     return ret;
 }
 
+void graph_get_init_stats(struct graph_init_stats *stats)
+{
+    memcpy(stats, &init_stats, sizeof(struct graph_init_stats));
+}
+
+static void acdb_tag_cache_clear(void);
+
 int graph_deinit()
 {
 
     gsl_deinit();
+    acdb_tag_cache_clear();
     return 0;
 }
 
 void gsl_callback_func(struct gsl_event_cb_params *event_params,
                        void *client_data)
 {
+    AGM_TRACE_SCOPE("gsl_callback_func");
      struct graph_obj *graph_obj = (struct graph_obj *) client_data;
      struct agm_event_cb_params *ev;
      struct gsl_event_read_write_done_payload *rw_done_payload;
@@ -535,6 +1015,7 @@ int graph_open(struct agm_meta_data_gsl *meta_data_kv,
                struct session_obj *sess_obj, struct device_obj *dev_obj,
                struct graph_obj **gph_obj)
 {
+    AGM_TRACE_SCOPE("graph_open");
     struct graph_obj *graph_obj = NULL;
     int ret = 0;
     struct listnode *temp_node, *node = NULL, *node_list = NULL;
@@ -699,6 +1180,10 @@ tag_list:
 no_config:
     graph_obj->sess_obj = sess_obj;
 
+    ret = graph_tag_table_build(graph_obj);
+    if (ret != 0)
+        goto free_graph_obj;
+
     ret = gsl_open((struct gsl_key_vector *)&meta_data_kv->gkv,
                    (struct gsl_key_vector *)&meta_data_kv->ckv,
                    &graph_obj->graph_handle);
@@ -732,8 +1217,10 @@ free_graph_obj:
             free(temp_mod->gkv->kv);
             free(temp_mod->gkv);
         }
+        hw_ep_free_cfg_snapshot(temp_mod);
         free(temp_mod);
     }
+    graph_tag_table_free(graph_obj);
     pthread_mutex_destroy(&graph_obj->lock);
     free(graph_obj);
 done:
@@ -760,6 +1247,7 @@ done:
 
 int graph_close(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_close");
     int ret = 0;
     struct listnode *temp_node,*node = NULL;
     module_info_t *temp_mod = NULL;
@@ -784,8 +1272,10 @@ int graph_close(struct graph_obj *graph_obj)
             free(temp_mod->gkv->kv);
             free(temp_mod->gkv);
         }
+        hw_ep_free_cfg_snapshot(temp_mod);
         free(temp_mod);
     }
+    graph_tag_table_free(graph_obj);
     pthread_mutex_unlock(&graph_obj->lock);
     pthread_mutex_destroy(&graph_obj->lock);
     free(graph_obj);
@@ -795,6 +1285,7 @@ int graph_close(struct graph_obj *graph_obj)
 
 int graph_prepare(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_prepare");
     int ret = 0;
     struct listnode *node = NULL;
     module_info_t *mod = NULL;
@@ -827,10 +1318,21 @@ int graph_prepare(struct graph_obj *graph_obj)
     list_for_each(node, &graph_obj->tagged_mod_list) {
         mod = node_to_item(node, module_info_t, list);
         if (mod->is_configured) {
-            if ((mod->tag == DEVICE_HW_ENDPOINT_RX) || (mod->tag == DEVICE_HW_ENDPOINT_TX))
+            /**
+             *hw ep modules are always configured again, except right
+             *after a graph_change when the device inputs did not change
+             *since they were last configured.
+             */
+            if (IS_HW_EP_MODULE(mod) &&
+                (!graph_obj->hw_ep_skip_unchanged ||
+                 hw_ep_cfg_changed(mod, mod->dev_obj, mod->gkv)))
                 goto force_configure;
-            else
-                continue;
+            if (IS_HW_EP_MODULE(mod)) {
+                AGM_LOGD("skip configuring unchanged module miid %x tag %x\n",
+                         mod->miid, mod->tag);
+                graph_obj->mod_cfg_skip_cnt++;
+            }
+            continue;
         }
         if ((mod->tag == STREAM_INPUT_MEDIA_FORMAT) &&
              (stream_config.sess_mode == AGM_SESSION_NO_HOST)) {
@@ -866,6 +1368,7 @@ force_configure:
                     goto done;
                 }
                 mod->is_configured = true;
+                hw_ep_save_cfg_snapshot(mod);
             }
 
         }
@@ -881,7 +1384,7 @@ force_configure:
             goto done;
         }
     }
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_PREPARE, NULL, 0);
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_PREPARE, NULL, 0);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_prepare failed %d\n", ret);
@@ -890,6 +1393,7 @@ force_configure:
     graph_obj->state = PREPARED;
 
 done:
+    graph_obj->hw_ep_skip_unchanged = false;
     pthread_mutex_unlock(&graph_obj->lock);
     AGM_LOGD("exit, ret %d", ret);
     return ret;
@@ -897,6 +1401,7 @@ done:
 
 int graph_start(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_start");
     int ret = 0;
 
     if (graph_obj == NULL) {
@@ -907,7 +1412,7 @@ int graph_start(struct graph_obj *graph_obj)
     pthread_mutex_lock(&graph_obj->lock);
     AGM_LOGD("entry graph_handle %p", graph_obj->graph_handle);
 
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_START, NULL, 0);
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_START, NULL, 0);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_start failed %d\n", ret);
@@ -924,6 +1429,7 @@ done:
 int graph_stop(struct graph_obj *graph_obj,
                struct agm_meta_data_gsl *meta_data)
 {
+    AGM_TRACE_SCOPE("graph_stop");
     int ret = 0;
     struct gsl_cmd_properties gsl_cmd_prop = {0};
 
@@ -950,14 +1456,14 @@ int graph_stop(struct graph_obj *graph_obj,
         gsl_cmd_prop.property_values = meta_data->sg_props.values;
 
         if (graph_obj->state & (STARTED)) {
-            ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_STOP,
+            ret = graph_gsl_ioctl(graph_obj, GSL_CMD_STOP,
                             &gsl_cmd_prop, sizeof(struct gsl_cmd_properties));
             /* Continue to close graph even stop fails */
             if (ret !=0)
                 AGM_LOGE("graph stop with prop failed %d\n", ret);
         }
 
-        ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_CLOSE_WITH_PROPS,
+        ret = graph_gsl_ioctl(graph_obj, GSL_CMD_CLOSE_WITH_PROPS,
                         &gsl_cmd_prop, sizeof(struct gsl_cmd_properties));
         if (ret !=0) {
             ret = ar_err_get_lnx_err_code(ret);
@@ -968,7 +1474,7 @@ int graph_stop(struct graph_obj *graph_obj,
            AGM_LOGE("graph object is already in STOP state\n");
            goto done;
         }
-        ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_STOP, NULL, 0);
+        ret = graph_gsl_ioctl(graph_obj, GSL_CMD_STOP, NULL, 0);
         graph_obj->state = STOPPED;
         if (ret !=0) {
             ret = ar_err_get_lnx_err_code(ret);
@@ -984,8 +1490,9 @@ done:
 
 int graph_pause_resume(struct graph_obj *graph_obj, bool pause)
 {
+    AGM_TRACE_SCOPE("graph_pause_resume");
     int ret = 0;
-    struct listnode *node = NULL;
+    uint32_t idx;
     module_info_t *mod;
     struct apm_module_param_data_t *header;
     size_t payload_size = 0;
@@ -996,46 +1503,42 @@ int graph_pause_resume(struct graph_obj *graph_obj, bool pause)
         return -EINVAL;
     }
 
+    pthread_mutex_lock(&graph_obj->lock);
     /* Pause module info is retrived and added to list in graph_open */
-    list_for_each(node, &graph_obj->tagged_mod_list) {
-        mod = node_to_item(node, module_info_t, list);
-        if (mod->tag == TAG_PAUSE) {
-            AGM_LOGD("Soft Pause module IID 0x%x, Pause: %d\n", mod->miid, pause);
+    graph_for_each_tagged_module(graph_obj, TAG_PAUSE, idx, mod) {
+        AGM_LOGD("Soft Pause module IID 0x%x, Pause: %d\n", mod->miid, pause);
 
-            payload_size = sizeof(struct apm_module_param_data_t);
-            ALIGN_PAYLOAD(payload_size, 8);
+        payload_size = sizeof(struct apm_module_param_data_t);
+        ALIGN_PAYLOAD(payload_size, 8);
 
-            payload = calloc(1, (size_t)payload_size);
-            if (!payload) {
-                AGM_LOGE("No memory to allocate for payload\n");
-                ret = -ENOMEM;
-                goto done;
-            }
+        payload = calloc(1, (size_t)payload_size);
+        if (!payload) {
+            AGM_LOGE("No memory to allocate for payload\n");
+            ret = -ENOMEM;
+            goto done;
+        }
 
-            header = (struct apm_module_param_data_t*)payload;
-            header->module_instance_id = mod->miid;
-            if (pause)
-                header->param_id = PARAM_ID_SOFT_PAUSE_START;
-            else
-                header->param_id = PARAM_ID_SOFT_PAUSE_RESUME;
-
-            header->error_code = 0x0;
-            header->param_size = 0x0;
-
-            pthread_mutex_lock(&graph_obj->lock);
-            ret = gsl_set_custom_config(graph_obj->graph_handle,
-                                         payload, payload_size);
-            if (ret !=0) {
-                ret = ar_err_get_lnx_err_code(ret);
-                AGM_LOGE("graph_set_custom_config failed %d\n", ret);
-            }
-            pthread_mutex_unlock(&graph_obj->lock);
-            free(payload);
-            break;
+        header = (struct apm_module_param_data_t*)payload;
+        header->module_instance_id = mod->miid;
+        if (pause)
+            header->param_id = PARAM_ID_SOFT_PAUSE_START;
+        else
+            header->param_id = PARAM_ID_SOFT_PAUSE_RESUME;
+
+        header->error_code = 0x0;
+        header->param_size = 0x0;
+
+        ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
+        if (ret !=0) {
+            ret = ar_err_get_lnx_err_code(ret);
+            AGM_LOGE("graph_set_custom_config failed %d\n", ret);
         }
+        free(payload);
+        break;
     }
 
 done:
+    pthread_mutex_unlock(&graph_obj->lock);
     return ret;
 }
 
@@ -1047,6 +1550,7 @@ int graph_pause(struct graph_obj *graph_obj)
 
 int graph_flush(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_flush");
     int ret = 0;
 
     if (graph_obj == NULL) {
@@ -1057,7 +1561,7 @@ int graph_flush(struct graph_obj *graph_obj)
     pthread_mutex_lock(&graph_obj->lock);
     AGM_LOGD("entry graph_handle %p\n", graph_obj->graph_handle);
 
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_FLUSH, NULL, 0);
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_FLUSH, NULL, 0);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_flush failed %d\n", ret);
@@ -1078,6 +1582,7 @@ int graph_resume(struct graph_obj *graph_obj)
 
 int graph_suspend(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_suspend");
     int ret = 0;
 
     AGM_LOGD("Enter");
@@ -1089,7 +1594,7 @@ int graph_suspend(struct graph_obj *graph_obj)
     pthread_mutex_lock(&graph_obj->lock);
     AGM_LOGD("entry graph_handle %p\n", graph_obj->graph_handle);
 
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_SUSPEND, NULL, 0);
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_SUSPEND, NULL, 0);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_suspend failed %d\n", ret);
@@ -1105,6 +1610,7 @@ done:
 int graph_set_config(struct graph_obj *graph_obj, void *payload,
                      size_t payload_size)
 {
+    AGM_TRACE_SCOPE("graph_set_config");
     int ret = 0;
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
@@ -1113,7 +1619,7 @@ int graph_set_config(struct graph_obj *graph_obj, void *payload,
 
     pthread_mutex_lock(&graph_obj->lock);
     AGM_LOGD("entry graph_handle %p", graph_obj->graph_handle);
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_set_config failed %d\n", ret);
@@ -1127,6 +1633,7 @@ int graph_set_config(struct graph_obj *graph_obj, void *payload,
 int graph_get_config(struct graph_obj *graph_obj, void *payload,
                      size_t payload_size)
 {
+    AGM_TRACE_SCOPE("graph_get_config");
     int ret = 0;
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object");
@@ -1149,6 +1656,7 @@ int graph_set_config_with_tag(struct graph_obj *graph_obj,
                               struct agm_key_vector_gsl *gkv,
                               struct agm_tag_config_gsl *tag_config)
 {
+    AGM_TRACE_SCOPE("graph_set_config_with_tag");
      int ret = 0;
 
      if (graph_obj == NULL) {
@@ -1173,6 +1681,7 @@ int graph_set_config_with_tag(struct graph_obj *graph_obj,
 int graph_set_cal(struct graph_obj *graph_obj,
                   struct agm_meta_data_gsl *metadata)
 {
+    AGM_TRACE_SCOPE("graph_set_cal");
      int ret = 0;
 
      if (graph_obj == NULL) {
@@ -1194,121 +1703,292 @@ int graph_set_cal(struct graph_obj *graph_obj,
      return ret;
 }
 
-int graph_set_acdb_param(void *payload)
+/*
+ *Tag to MIID mappings used by the ACDB tunnel, cached per GKV so that
+ *repeated calibration writes from tuning tools skip the GSL tag query.
+ *The mappings come from the ACDB graph definitions and stay valid until
+ *GSL is deinitialized. The cache is small and kept in LRU order.
+ */
+#define ACDB_TAG_CACHE_MAX 8
+
+struct acdb_tag_miid {
+    uint32_t tag;
+    uint32_t miid;
+};
+
+struct acdb_tag_cache_entry {
+    struct listnode node;
+    uint32_t gkv_hash;
+    struct agm_key_vector_gsl *gkv;
+    uint32_t num_tags;
+    /*sorted by tag*/
+    struct acdb_tag_miid *tags;
+};
+
+static struct listnode acdb_tag_cache = {&acdb_tag_cache, &acdb_tag_cache};
+static uint32_t acdb_tag_cache_cnt;
+static pthread_mutex_t acdb_tag_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t gkv_hash(const struct agm_key_vector_gsl *gkv)
 {
-    int ret = 0;
-    struct agm_acdb_tunnel_param *payloadACDBTunnelInfo = NULL;
-    uint32_t i = 0;
-    uint32_t *ptr = NULL;
-    uint8_t *ptr_to_param = NULL;
-    size_t actual_size = 0;
-    uint32_t tag = 0;
-    uint32_t miid = 0;
-    struct agm_key_vector_gsl gkv = {0, NULL};
-    struct agm_key_vector_gsl kv = {0, NULL};
-    struct apm_module_param_data_t* header;
-    size_t size = 0;
-    struct gsl_tag_module_info *tag_info;
+    const uint8_t *data = (const uint8_t *)gkv->kv;
+    size_t len = gkv->num_kvs * sizeof(struct agm_key_value), i;
+    uint32_t hash = 2166136261u;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+static void acdb_tag_cache_entry_free(struct acdb_tag_cache_entry *entry)
+{
+    if (entry->gkv) {
+        free(entry->gkv->kv);
+        free(entry->gkv);
+    }
+    free(entry->tags);
+    free(entry);
+}
+
+static int acdb_tag_cache_create(struct agm_key_vector_gsl *gkv,
+                                 struct acdb_tag_cache_entry **entry_out)
+{
+    struct acdb_tag_cache_entry *entry = NULL;
+    struct gsl_tag_module_info *tag_info = NULL;
     struct gsl_tag_module_info_entry *tag_entry;
-    uint32_t offset = 0;
-    uint32_t total_parsed_size = 0;
-    uint8_t tag_pool[TAGGED_MOD_SIZE_BYTES] = { 0 };
+    struct acdb_tag_miid item;
+    uint8_t *end;
+    size_t size = 0;
+    uint32_t i, j;
+    int ret;
 
-    AGM_LOGD("enter");
+    ret = get_tags_with_module_info(gkv, (void **)&tag_info, &size);
+    if (ret || !tag_info) {
+        AGM_LOGE("failed to get tag pool ret = %d size=0x%zx", ret, size);
+        return ret ? ret : -EINVAL;
+    }
 
-    if (!payload) {
-        AGM_LOGE("payload is nullptr");
+    /*the pool is variable length, never read past what GSL returned*/
+    end = (uint8_t *)tag_info + size;
+    if ((uint8_t *)&tag_info->tag_module_entry[0] > end) {
+        AGM_LOGE("tag pool of %zu bytes has no header\n", size);
+        free(tag_info);
         return -EINVAL;
     }
 
-    payloadACDBTunnelInfo = (struct agm_acdb_tunnel_param *)payload;
-    AGM_LOGD("istkv=%x num_gkvs=0x%x num_kvs=0x%x blob_size=0x%x",
-        payloadACDBTunnelInfo->isTKV,
-        payloadACDBTunnelInfo->num_gkvs,
-        payloadACDBTunnelInfo->num_kvs,
-        payloadACDBTunnelInfo->blob_size);
+    ret = -ENOMEM;
+    entry = calloc(1, sizeof(struct acdb_tag_cache_entry));
+    if (!entry)
+        goto err;
+    entry->gkv = gkv_dup(gkv);
+    if (!entry->gkv)
+        goto err;
+    entry->gkv_hash = gkv_hash(gkv);
+    if (tag_info->num_tags) {
+        entry->tags = calloc(tag_info->num_tags, sizeof(struct acdb_tag_miid));
+        if (!entry->tags)
+            goto err;
+    }
 
-    ptr = payloadACDBTunnelInfo->blob;
-    for (i = 0; i < payloadACDBTunnelInfo->blob_size / 4; i++) {
-        AGM_LOGV("%d data = 0x%x", i, *ptr++);
+    AGM_LOGD("num of tags is %d\n", tag_info->num_tags);
+    tag_entry = (struct gsl_tag_module_info_entry *)
+                                 (&tag_info->tag_module_entry[0]);
+    for (i = 0; i < tag_info->num_tags; i++) {
+        /*the entry header first, then the modules it claims to have*/
+        if ((uint8_t *)&tag_entry->module_entry[0] > end ||
+            (uint8_t *)&tag_entry->module_entry[tag_entry->num_modules] > end) {
+            AGM_LOGE("tag pool truncated at tag %d\n", i);
+            break;
+        }
+        AGM_LOGV("tag id[%d] = 0x%x, num_modules = 0x%x\n", i,
+                 tag_entry->tag_id, tag_entry->num_modules);
+        if (tag_entry->num_modules) {
+            item.tag = tag_entry->tag_id;
+            item.miid = tag_entry->module_entry[0].module_iid;
+            /*stable, the first module of a repeated tag wins on lookup*/
+            for (j = entry->num_tags; j > 0 &&
+                 entry->tags[j - 1].tag > item.tag; j--)
+                entry->tags[j] = entry->tags[j - 1];
+            entry->tags[j] = item;
+            entry->num_tags++;
+        }
+        tag_entry = (struct gsl_tag_module_info_entry *)
+                        &tag_entry->module_entry[tag_entry->num_modules];
     }
+    free(tag_info);
+    *entry_out = entry;
+    return 0;
 
-    ptr = payloadACDBTunnelInfo->blob + sizeof(struct agm_key_value) *
-            (payloadACDBTunnelInfo->num_gkvs + payloadACDBTunnelInfo->num_kvs);
-    header = (struct apm_module_param_data_t *)ptr;
-    ptr_to_param = header;
+err:
+    AGM_LOGE("No memory for acdb tag cache entry\n");
+    if (entry)
+        acdb_tag_cache_entry_free(entry);
+    free(tag_info);
+    return ret;
+}
 
-    // tag is stored at miid. Convertion happens next.
-    tag = *ptr;
-    AGM_LOGD("tag to be translated is 0x%x", tag);
+static int acdb_tag_cache_get_miid(struct agm_key_vector_gsl *gkv,
+                                   uint32_t tag, uint32_t *miid)
+{
+    struct acdb_tag_cache_entry *entry = NULL, *found = NULL;
+    struct listnode *node = NULL;
+    uint32_t hash = gkv_hash(gkv), lo, hi, mid;
+    int ret = -EINVAL;
 
-    gkv.num_kvs = payloadACDBTunnelInfo->num_gkvs;
-    gkv.kv = payloadACDBTunnelInfo->blob;
+    pthread_mutex_lock(&acdb_tag_cache_lock);
+    list_for_each(node, &acdb_tag_cache) {
+        entry = node_to_item(node, struct acdb_tag_cache_entry, node);
+        if (entry->gkv_hash == hash && gkv_equal(entry->gkv, gkv)) {
+            found = entry;
+            list_remove(&found->node);
+            break;
+        }
+    }
 
-    ret = gsl_get_tags_with_module_info(&gkv, NULL, &size);
-    if (ret) {
-        AGM_LOGE("failed to get tag info size = %d size=0x%x", ret, size);
-        return ret;
+    if (!found) {
+        ret = acdb_tag_cache_create(gkv, &found);
+        if (ret)
+            goto done;
+        ret = -EINVAL;
+        if (acdb_tag_cache_cnt == ACDB_TAG_CACHE_MAX) {
+            entry = node_to_item(list_tail(&acdb_tag_cache),
+                                 struct acdb_tag_cache_entry, node);
+            list_remove(&entry->node);
+            acdb_tag_cache_entry_free(entry);
+        } else {
+            acdb_tag_cache_cnt++;
+        }
     }
+    list_add_head(&acdb_tag_cache, &found->node);
 
-    ret = gsl_get_tags_with_module_info(&gkv, tag_pool, &size);
-    if (ret) {
-        AGM_LOGE("failed to get tag pool ret = %d size=0x%x", ret, size);
-        return ret;
+    lo = 0;
+    hi = found->num_tags;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (found->tags[mid].tag < tag)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < found->num_tags && found->tags[lo].tag == tag) {
+        *miid = found->tags[lo].miid;
+        ret = 0;
     }
 
-    tag_info = (struct gsl_tag_module_info *)tag_pool;
-    AGM_LOGD("num of tags is %d\n", tag_info->num_tags);
-    ret = -1;
-    tag_entry = (struct gsl_tag_module_info_entry *)(&tag_info->tag_module_entry[0]);
+done:
+    pthread_mutex_unlock(&acdb_tag_cache_lock);
+    return ret;
+}
 
-    offset = 0;
-    for (i = 0; i < tag_info->num_tags; i++) {
-        tag_entry += offset/sizeof(struct gsl_tag_module_info_entry);
-
-        AGM_LOGD("tag id[%d] = 0x%x, num_modules = 0x%x\n", i,
-                    tag_entry->tag_id, tag_entry->num_modules);
-        offset = sizeof(struct gsl_tag_module_info_entry) +
-                    (tag_entry->num_modules *
-                    sizeof(struct gsl_module_id_info_entry));
-        if (tag_entry->tag_id == tag) {
-            struct gsl_module_id_info_entry *mod_info_entry;
-
-            if (tag_entry->num_modules) {
-                 mod_info_entry = &tag_entry->module_entry[0];
-                 miid = mod_info_entry->module_iid;
-                 AGM_LOGI("MIID is 0x%x\n", miid);
-                 ret = 0;
-                 break;
-            }
+static void acdb_tag_cache_clear(void)
+{
+    struct acdb_tag_cache_entry *entry = NULL;
+    struct listnode *node = NULL, *temp_node = NULL;
+
+    pthread_mutex_lock(&acdb_tag_cache_lock);
+    list_for_each_safe(node, temp_node, &acdb_tag_cache) {
+        entry = node_to_item(node, struct acdb_tag_cache_entry, node);
+        list_remove(&entry->node);
+        acdb_tag_cache_entry_free(entry);
+    }
+    acdb_tag_cache_cnt = 0;
+    pthread_mutex_unlock(&acdb_tag_cache_lock);
+}
+
+/*one ACDB tunnel write, with the tag in the payload resolved to a MIID*/
+struct acdb_tunnel_write {
+    bool is_tkv;
+    uint32_t tag;
+    struct agm_key_vector_gsl gkv;
+    struct agm_key_vector_gsl kv;
+    uint8_t *payload;
+    size_t payload_size;
+    bool miid_found;
+};
+
+static int acdb_tunnel_write_prepare(
+                        struct agm_acdb_tunnel_param *payloadACDBTunnelInfo,
+                        struct acdb_tunnel_write *wr)
+{
+    uint32_t i = 0;
+    uint32_t *ptr = NULL;
+    uint32_t miid = 0;
+    struct apm_module_param_data_t* header;
+    size_t kv_size = 0;
+    uint32_t offset = 0;
+    uint32_t total_parsed_size = 0;
+    int ret = 0;
+
+    AGM_LOGD("istkv=%x num_gkvs=0x%x num_kvs=0x%x blob_size=0x%x",
+        payloadACDBTunnelInfo->isTKV,
+        payloadACDBTunnelInfo->num_gkvs,
+        payloadACDBTunnelInfo->num_kvs,
+        payloadACDBTunnelInfo->blob_size);
+
+    kv_size = sizeof(struct agm_key_value) *
+            ((size_t)payloadACDBTunnelInfo->num_gkvs +
+             payloadACDBTunnelInfo->num_kvs);
+    if (payloadACDBTunnelInfo->blob_size <
+            kv_size + sizeof(struct apm_module_param_data_t)) {
+        AGM_LOGE("blob size 0x%x too small for %d gkvs and %d kvs",
+                 payloadACDBTunnelInfo->blob_size,
+                 payloadACDBTunnelInfo->num_gkvs,
+                 payloadACDBTunnelInfo->num_kvs);
+        return -EINVAL;
+    }
+
+    if (AGM_LOG_ON(AGM_LOG_LEVEL_VERBOSE)) {
+        ptr = (uint32_t *)payloadACDBTunnelInfo->blob;
+        for (i = 0; i < payloadACDBTunnelInfo->blob_size / 4; i++) {
+            AGM_LOGV("%d data = 0x%x", i, *ptr++);
         }
     }
 
+    header = (struct apm_module_param_data_t *)
+                        (payloadACDBTunnelInfo->blob + kv_size);
+    wr->payload = (uint8_t *)header;
+    wr->is_tkv = payloadACDBTunnelInfo->isTKV;
+
+    // tag is stored at miid. Convertion happens next.
+    wr->tag = header->module_instance_id;
+    AGM_LOGD("tag to be translated is 0x%x", wr->tag);
+
+    wr->gkv.num_kvs = payloadACDBTunnelInfo->num_gkvs;
+    wr->gkv.kv = (struct agm_key_value *)payloadACDBTunnelInfo->blob;
+
+    ret = acdb_tag_cache_get_miid(&wr->gkv, wr->tag, &miid);
+    if (ret)
+        AGM_LOGE("no module with tag 0x%x in the graph, ret %d", wr->tag, ret);
+    else
+        AGM_LOGI("MIID is 0x%x\n", miid);
+    wr->miid_found = !ret;
+
     AGM_LOGI("originally tag = 0x%x", header->module_instance_id);
     header->module_instance_id = miid;
     AGM_LOGI("translated miid is = 0x%x", header->module_instance_id);
-    kv.num_kvs = payloadACDBTunnelInfo->num_kvs;
-    kv.kv = payloadACDBTunnelInfo->blob +
-        payloadACDBTunnelInfo->num_gkvs * sizeof(struct agm_key_value);
+    wr->kv.num_kvs = payloadACDBTunnelInfo->num_kvs;
+    wr->kv.kv = (struct agm_key_value *)(payloadACDBTunnelInfo->blob +
+        payloadACDBTunnelInfo->num_gkvs * sizeof(struct agm_key_value));
 
     AGM_LOGD("blob size = %d", payloadACDBTunnelInfo->blob_size);
-    actual_size = payloadACDBTunnelInfo->blob_size -
-        (payloadACDBTunnelInfo->num_gkvs + payloadACDBTunnelInfo->num_kvs) *
-                sizeof(struct agm_key_value);
-    AGM_LOGD("actual size = 0x%x", actual_size);
-    AGM_LOGI("num kvs = %d", kv.num_kvs);
-    ptr = kv.kv;
-    for (i = 0; i < kv.num_kvs; i++) {
-        AGM_LOGI("kv %d %x", i, *ptr++);
-        AGM_LOGI("kv %d %x", i, *ptr++);
-    }
+    wr->payload_size = payloadACDBTunnelInfo->blob_size - kv_size;
+    AGM_LOGD("actual size = 0x%zx", wr->payload_size);
+    AGM_LOGI("num kvs = %d", wr->kv.num_kvs);
+    for (i = 0; i < wr->kv.num_kvs; i++)
+        AGM_LOGI("kv %d %x %x", i, wr->kv.kv[i].key, wr->kv.kv[i].value);
 
     // for multiple param, we have to fill the miid in each line item.
     offset = sizeof(struct apm_module_param_data_t) + header->param_size;
     ALIGN_PAYLOAD(offset, 8);
     total_parsed_size = offset;
-    while (total_parsed_size < actual_size) {
+    while (total_parsed_size < wr->payload_size) {
         AGM_LOGI("multiple param: offset=0x%x", offset);
+        if (total_parsed_size + sizeof(struct apm_module_param_data_t) >
+                wr->payload_size) {
+            AGM_LOGE("truncated param header at offset 0x%x",
+                     total_parsed_size);
+            return -EINVAL;
+        }
         header = (struct apm_module_param_data_t*)((uint8_t *)header + offset);
         header->module_instance_id = miid;
         offset = sizeof(struct apm_module_param_data_t) + header->param_size;
@@ -1318,21 +1998,171 @@ int graph_set_acdb_param(void *payload)
             total_parsed_size, header->param_size, offset);
     }
 
-    ptr = ptr_to_param;
-    for (i = 0; i < actual_size / 4; i++) {
-        AGM_LOGV("%d data to acdb = 0x%x", i, *ptr++);
+    if (AGM_LOG_ON(AGM_LOG_LEVEL_VERBOSE)) {
+        ptr = (uint32_t *)wr->payload;
+        for (i = 0; i < wr->payload_size / 4; i++) {
+            AGM_LOGV("%d data to acdb = 0x%x", i, *ptr++);
+        }
     }
 
-    if (payloadACDBTunnelInfo->isTKV)
-        ret = gsl_set_tag_data_to_acdb(&gkv, tag, &kv, ptr_to_param, actual_size);
+    return 0;
+}
+
+/*
+ *Serializes ACDB writes and persistence toggles so that a batch can switch
+ *delta persistence off and back on without another writer landing in
+ *between.
+ */
+static pthread_mutex_t acdb_write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*caller holds acdb_write_lock*/
+static int acdb_persistence_set(uint8_t enable_flag)
+{
+    return gsl_enable_acdb_persistence(enable_flag);
+}
+
+static int acdb_tunnel_write(struct acdb_tunnel_write *wr)
+{
+    int ret = 0;
+
+    if (wr->is_tkv)
+        ret = gsl_set_tag_data_to_acdb((struct gsl_key_vector *)&wr->gkv,
+                     wr->tag, (struct gsl_key_vector *)&wr->kv,
+                     wr->payload, wr->payload_size);
     else
-        ret = gsl_set_cal_data_to_acdb(&gkv, &kv, ptr_to_param, actual_size);
+        ret = gsl_set_cal_data_to_acdb((struct gsl_key_vector *)&wr->gkv,
+                     (struct gsl_key_vector *)&wr->kv,
+                     wr->payload, wr->payload_size);
 
     return ar_err_get_lnx_err_code(ret);
 }
 
+int graph_set_acdb_param(void *payload)
+{
+    AGM_TRACE_SCOPE("graph_set_acdb_param");
+    struct acdb_tunnel_write wr;
+    int ret = 0;
+
+    AGM_LOGD("enter");
+
+    if (!payload) {
+        AGM_LOGE("payload is nullptr");
+        return -EINVAL;
+    }
+
+    memset(&wr, 0, sizeof(wr));
+    /*an unknown tag is still written, with the miid left as 0*/
+    ret = acdb_tunnel_write_prepare((struct agm_acdb_tunnel_param *)payload,
+                                    &wr);
+    if (ret)
+        return ret;
+
+    pthread_mutex_lock(&acdb_write_lock);
+    ret = acdb_tunnel_write(&wr);
+    pthread_mutex_unlock(&acdb_write_lock);
+
+    return ret;
+}
+
+int graph_set_acdb_param_batch(void *payload, size_t size)
+{
+    AGM_TRACE_SCOPE("graph_set_acdb_param_batch");
+    struct agm_acdb_tunnel_batch *batch = NULL;
+    struct agm_acdb_tunnel_param *param = NULL;
+    struct acdb_tunnel_write *wr = NULL;
+    size_t offset = 0, entry_size = 0;
+    uint32_t i = 0;
+    int ret = 0, pret = 0;
+
+    if (!payload || size < sizeof(struct agm_acdb_tunnel_batch)) {
+        AGM_LOGE("Invalid batch payload %pK size %zu", payload, size);
+        return -EINVAL;
+    }
+
+    batch = (struct agm_acdb_tunnel_batch *)payload;
+    if (!batch->num_params)
+        return 0;
+
+    wr = calloc(batch->num_params, sizeof(struct acdb_tunnel_write));
+    if (!wr) {
+        AGM_LOGE("No memory for %d acdb writes", batch->num_params);
+        return -ENOMEM;
+    }
+
+    /*
+     *Resolve and validate every entry before the first write, so a
+     *malformed entry or unknown tag leaves ACDB untouched.
+     */
+    size -= offsetof(struct agm_acdb_tunnel_batch, params);
+    for (i = 0; i < batch->num_params; i++) {
+        if (size - offset < sizeof(struct agm_acdb_tunnel_param)) {
+            ret = -EINVAL;
+            break;
+        }
+        param = (struct agm_acdb_tunnel_param *)(batch->params + offset);
+        if (param->blob_size > size - offset -
+                               sizeof(struct agm_acdb_tunnel_param)) {
+            ret = -EINVAL;
+            break;
+        }
+        ret = acdb_tunnel_write_prepare(param, &wr[i]);
+        if (!ret && !wr[i].miid_found)
+            ret = -EINVAL;
+        if (ret)
+            break;
+        entry_size = sizeof(struct agm_acdb_tunnel_param) + param->blob_size;
+        ALIGN_PAYLOAD(entry_size, 8);
+        offset += entry_size;
+        if (offset > size)
+            offset = size;
+    }
+    if (ret) {
+        AGM_LOGE("batch entry %d of %d rejected, ret %d, nothing written",
+                 i, batch->num_params, ret);
+        goto done;
+    }
+
+    /*
+     *Apply with delta persistence off and turn it back on for the last
+     *write only: ACDB saves the whole delta on a persisted write, so the
+     *batch costs a single delta file update.
+     */
+    pthread_mutex_lock(&acdb_write_lock);
+    ret = acdb_persistence_set(0);
+    if (ret) {
+        AGM_LOGE("failed to disable acdb persistence, ret %d", ret);
+        goto unlock;
+    }
+    for (i = 0; i < batch->num_params; i++) {
+        if (i == batch->num_params - 1) {
+            ret = acdb_persistence_set(1);
+            if (ret) {
+                AGM_LOGE("failed to enable acdb persistence, ret %d", ret);
+                break;
+            }
+        }
+        ret = acdb_tunnel_write(&wr[i]);
+        if (ret) {
+            AGM_LOGE("batch write %d of %d failed, ret %d, not persisted",
+                     i, batch->num_params, ret);
+            break;
+        }
+    }
+    /*other ACDB writers expect persistence to be on*/
+    pret = acdb_persistence_set(1);
+    if (pret)
+        AGM_LOGE("failed to restore acdb persistence, ret %d", pret);
+
+unlock:
+    pthread_mutex_unlock(&acdb_write_lock);
+done:
+    free(wr);
+    return ret;
+}
+
 int graph_write(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *size)
 {
+    AGM_TRACE_SCOPE("graph_write");
     int ret = 0;
     struct gsl_buff gsl_buff = {0};
     uint32_t size_written = 0;
@@ -1365,9 +2195,11 @@ int graph_write(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *si
                     write_mod_tag, &gsl_buff, &size_written);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
-        AGM_LOGE("gsl_write for size %zu failed with error %d\n", *size, ret);
+        AGM_LOGE_DP("gsl_write for size %zu failed with error %d\n", *size, ret);
         goto done;
     }
+    AGM_LOGV_DP(graph_obj->sess_obj->sess_id, "sess_id %d wrote %u of %zu\n",
+                graph_obj->sess_obj->sess_id, size_written, *size);
     *size = (size_t)size_written;
 done:
     return ret;
@@ -1375,6 +2207,7 @@ done:
 
 int graph_read(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *size)
 {
+    AGM_TRACE_SCOPE("graph_read");
     int ret = 0;
     struct gsl_buff gsl_buff = {0};
     int size_read = 0;
@@ -1412,8 +2245,12 @@ int graph_read(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *siz
         ((size_read == 0) &&
          (graph_obj->sess_obj->stream_config.sess_mode != AGM_SESSION_NON_TUNNEL))) {
         ret = ar_err_get_lnx_err_code(ret);
-        AGM_LOGE("size_requested %zu size_read %d error %d\n",
-                  *size, size_read, ret);
+        AGM_LOGE_DP("size_requested %zu size_read %d error %d\n",
+                    *size, size_read, ret);
+    } else {
+        AGM_LOGV_DP(graph_obj->sess_obj->sess_id,
+                    "sess_id %d read %d of %zu\n",
+                    graph_obj->sess_obj->sess_id, size_read, *size);
     }
     *size = size_read;
     graph_obj->buf_info.timestamp = gsl_buff.timestamp;
@@ -1425,12 +2262,14 @@ int graph_add(struct graph_obj *graph_obj,
               struct agm_meta_data_gsl *meta_data_kv,
               struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("graph_add");
     int ret = 0;
 
     struct gsl_cmd_graph_select add_graph;
     module_info_t *mod = NULL;
     struct agm_key_vector_gsl *gkv;
     struct listnode *node = NULL;
+    uint32_t idx;
 
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
@@ -1460,7 +2299,7 @@ int graph_add(struct graph_obj *graph_obj,
                                      meta_data_kv->ckv.kv;
     metadata_print(meta_data_kv);
     print_graph_alias(meta_data_kv);
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_ADD_GRAPH, &add_graph,
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_ADD_GRAPH, &add_graph,
                     sizeof(struct gsl_cmd_graph_select));
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
@@ -1498,8 +2337,7 @@ int graph_add(struct graph_obj *graph_obj,
          *present in the graph object with the one returned from the above api.
          *if it is a new module we add it to the list and configure it.
          */
-        list_for_each(node, &graph_obj->tagged_mod_list) {
-            temp_mod = node_to_item(node, module_info_t, list);
+        graph_for_each_tagged_module(graph_obj, mod->tag, idx, temp_mod) {
             if (temp_mod->miid == module_info->module_entry[0].module_iid) {
                 mod_present = true;
                 /**
@@ -1508,6 +2346,7 @@ int graph_add(struct graph_obj *graph_obj,
                  * Ex: back to back device switch scenario.
                  */
                 temp_mod->is_configured = false;
+                temp_mod->cfg_snapshot_valid = false;
                 break;
             }
         }
@@ -1525,6 +2364,12 @@ int graph_add(struct graph_obj *graph_obj,
             }
             add_module->miid = module_info->module_entry[0].module_iid;
             add_module->mid = module_info->module_entry[0].module_id;
+            ret = graph_tag_table_build(graph_obj);
+            if (ret) {
+                list_remove(&add_module->list);
+                free(add_module);
+                goto done;
+            }
             gkv = calloc(1, sizeof(struct agm_key_vector_gsl));
             if (!gkv) {
                 AGM_LOGE("No memory to allocate for gkv\n");
@@ -1573,6 +2418,7 @@ int graph_add(struct graph_obj *graph_obj,
                 if (ret != 0)
                     goto done;
                 mod->is_configured = true;
+                hw_ep_save_cfg_snapshot(mod);
             }
         }
     }
@@ -1587,12 +2433,15 @@ int graph_change(struct graph_obj *graph_obj,
                      struct agm_meta_data_gsl *meta_data_kv,
                      struct device_obj *dev_obj)
 {
+    AGM_TRACE_SCOPE("graph_change");
     int ret = 0;
 
     struct gsl_cmd_graph_select change_graph;
     module_info_t *mod = NULL;
-    struct agm_key_vector_gsl *gkv;
+    struct agm_key_vector_gsl *gkv = NULL;
     struct listnode *node, *temp_node = NULL;
+    struct listnode stale_list;
+    uint32_t cfg_cnt = 0, skip_cnt = 0, idx;
 
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
@@ -1604,7 +2453,8 @@ int graph_change(struct graph_obj *graph_obj,
 
     if (dev_obj != NULL) {
         mod = NULL;
-        module_info_t *add_module, *temp_mod = NULL;
+        module_info_t *add_module = NULL, *temp_mod = NULL;
+        module_info_t *present_mod = NULL;
         size_t module_info_size;
         struct gsl_module_id_info *module_info;
         bool mod_present = false;
@@ -1634,28 +2484,43 @@ int graph_change(struct graph_obj *graph_obj,
          *as it is not part of the graph anymore (would have been removed as a
          *part of graph_remove).
          */
-        list_for_each(node, &graph_obj->tagged_mod_list) {
-            temp_mod = node_to_item(node, module_info_t, list);
+        graph_for_each_tagged_module(graph_obj, mod->tag, idx, temp_mod) {
             if (temp_mod->miid == module_info->module_entry[0].module_iid) {
                 AGM_LOGV("info for module %x, config flag = %d\n", temp_mod->tag, temp_mod->is_configured);
                 mod_present = true;
-                temp_mod->is_configured = false;
+                /**
+                 *The same module instance stays in the graph, configure
+                 *it again only if the device, gkv or media config changed.
+                 */
+                if (temp_mod->is_configured &&
+                    !hw_ep_cfg_changed(temp_mod, dev_obj, &meta_data_kv->gkv)) {
+                    skip_cnt++;
+                    break;
+                }
+                /*updated only once every allocation below has succeeded*/
+                present_mod = temp_mod;
+                if (!gkv_equal(temp_mod->gkv, &meta_data_kv->gkv)) {
+                    gkv = gkv_dup(&meta_data_kv->gkv);
+                    if (!gkv) {
+                        ret = -ENOMEM;
+                        goto done;
+                    }
+                }
                 break;
             }
         }
-        /* Delete the current hw_ep(Device module) from the list */
+        /**
+         *Move the current hw_ep(Device module) out of the list, it is only
+         *freed once the tag table no longer points to it.
+         */
+        list_init(&stale_list);
         list_for_each_safe(node, temp_node, &graph_obj->tagged_mod_list) {
             temp_mod = node_to_item(node, module_info_t, list);
             if (((temp_mod->tag == DEVICE_HW_ENDPOINT_TX) ||
                 (temp_mod->tag == DEVICE_HW_ENDPOINT_RX)) &&
                 (temp_mod->miid != module_info->module_entry[0].module_iid)) {
                 list_remove(node);
-                if (temp_mod->gkv) {
-                    free(temp_mod->gkv->kv);
-                    free(temp_mod->gkv);
-                }
-                free(temp_mod);
-                temp_mod = NULL;
+                list_add_tail(&stale_list, node);
             }
         }
         if (!mod_present) {
@@ -1664,30 +2529,59 @@ int graph_change(struct graph_obj *graph_obj,
             if (!add_module) {
                 AGM_LOGE("No memory to allocate for add_module\n");
                 ret = -ENOMEM;
-                goto done;
+            } else {
+                add_module->miid = module_info->module_entry[0].module_iid;
+                add_module->mid = module_info->module_entry[0].module_id;
+                /*Make a local copy of gkv and use when we query gsl
+                for tagged data*/
+                add_module->gkv = gkv_dup(&meta_data_kv->gkv);
+                if (!add_module->gkv)
+                    ret = -ENOMEM;
             }
-            add_module->miid = module_info->module_entry[0].module_iid;
-            add_module->mid = module_info->module_entry[0].module_id;
-            /*Make a local copy of gkv and use when we query gsl
-            for tagged data*/
-            gkv = calloc(1, sizeof(struct agm_key_vector_gsl));
-            if (!gkv) {
-                AGM_LOGE("No memory to allocate for gkv\n");
-                ret = -ENOMEM;
-                goto done;
+        }
+        if (!ret)
+            ret = graph_tag_table_build(graph_obj);
+        if (ret) {
+            /*keep the previous table valid, restore the list it indexes*/
+            if (add_module) {
+                list_remove(&add_module->list);
+                if (add_module->gkv) {
+                    free(add_module->gkv->kv);
+                    free(add_module->gkv);
+                }
+                free(add_module);
             }
-            gkv->num_kvs = meta_data_kv->gkv.num_kvs;
-            gkv->kv = calloc(gkv->num_kvs, sizeof(struct agm_key_value));
-            if (!gkv->kv) {
-                AGM_LOGE("No memory to allocate for kv\n");
+            if (gkv) {
+                free(gkv->kv);
                 free(gkv);
-                ret = -ENOMEM;
-                goto done;
             }
-            memcpy(gkv->kv, meta_data_kv->gkv.kv,
-                    gkv->num_kvs * sizeof(struct agm_key_value));
-            add_module->gkv = gkv;
-            gkv = NULL;
+            list_for_each_safe(node, temp_node, &stale_list) {
+                list_remove(node);
+                list_add_tail(&graph_obj->tagged_mod_list, node);
+            }
+            goto done;
+        }
+        if (present_mod) {
+            present_mod->is_configured = false;
+            present_mod->cfg_snapshot_valid = false;
+            present_mod->dev_obj = dev_obj;
+            if (gkv) {
+                if (present_mod->gkv) {
+                    free(present_mod->gkv->kv);
+                    free(present_mod->gkv);
+                }
+                present_mod->gkv = gkv;
+            }
+        }
+        list_for_each_safe(node, temp_node, &stale_list) {
+            temp_mod = node_to_item(node, module_info_t, list);
+            list_remove(node);
+            if (temp_mod->gkv) {
+                free(temp_mod->gkv->kv);
+                free(temp_mod->gkv);
+            }
+            hw_ep_free_cfg_snapshot(temp_mod);
+            free(temp_mod);
         }
     }
     /*Send the new GKV for CHANGE_GRAPH*/
@@ -1699,14 +2593,14 @@ int graph_change(struct graph_obj *graph_obj,
                                      meta_data_kv->ckv.kv;
     metadata_print(meta_data_kv);
     print_graph_alias(meta_data_kv);
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_CHANGE_GRAPH, &change_graph,
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_CHANGE_GRAPH, &change_graph,
                     sizeof(struct gsl_cmd_graph_select));
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph add failed with error %d\n", ret);
         goto done;
     }
-    /*configure modules again*/
+    /*configure modules again, only the ones whose inputs changed*/
     list_for_each(node, &graph_obj->tagged_mod_list) {
         mod = node_to_item(node, module_info_t, list);
         if (mod->configure && !mod->is_configured &&
@@ -1715,8 +2609,14 @@ int graph_change(struct graph_obj *graph_obj,
             if (ret != 0)
                 goto done;
             mod->is_configured = true;
+            hw_ep_save_cfg_snapshot(mod);
+            cfg_cnt++;
         }
     }
+    graph_obj->mod_cfg_skip_cnt += skip_cnt;
+    graph_obj->hw_ep_skip_unchanged = true;
+    AGM_LOGI("graph change reconfigured %u modules, skipped %u unchanged\n",
+             cfg_cnt, skip_cnt);
 done:
     pthread_mutex_unlock(&graph_obj->lock);
     AGM_LOGD("exit, ret %d", ret);
@@ -1726,8 +2626,11 @@ done:
 int graph_remove(struct graph_obj *graph_obj,
                  struct agm_meta_data_gsl *meta_data_kv)
 {
+    AGM_TRACE_SCOPE("graph_remove");
     int ret = 0;
     struct gsl_cmd_remove_graph rm_graph;
+    struct listnode *node = NULL;
+    module_info_t *mod = NULL;
 
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
@@ -1742,12 +2645,18 @@ int graph_remove(struct graph_obj *graph_obj,
      *graph_change/graph_add if reconfiguration of modules is needed, otherwise
      *graph_start will suffice.graph remove wont reconfigure the modules.
      */
+    list_for_each(node, &graph_obj->tagged_mod_list) {
+        mod = node_to_item(node, module_info_t, list);
+        /*removed subgraphs lose their configuration on the DSP*/
+        if (IS_HW_EP_MODULE(mod))
+            mod->cfg_snapshot_valid = false;
+    }
     rm_graph.graph_key_vector.num_kvps = meta_data_kv->gkv.num_kvs;
     rm_graph.graph_key_vector.kvp = (struct gsl_key_value_pair *)
                                      meta_data_kv->gkv.kv;
     metadata_print(meta_data_kv);
     print_graph_alias(meta_data_kv);
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_REMOVE_GRAPH, &rm_graph,
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_REMOVE_GRAPH, &rm_graph,
                     sizeof(struct gsl_cmd_remove_graph));
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
@@ -1828,7 +2737,7 @@ int graph_register_for_events(struct graph_obj *gph_obj,
           evt_reg_cfg->event_config_payload,
           evt_reg_cfg->event_config_payload_size);
 
-    ret = gsl_ioctl(gph_obj->graph_handle, GSL_CMD_REGISTER_CUSTOM_EVENT,
+    ret = graph_gsl_ioctl(gph_obj, GSL_CMD_REGISTER_CUSTOM_EVENT,
                                            reg_ev_payload, payload_size);
     if (ret != 0) {
        ret = ar_err_get_lnx_err_code(ret);
@@ -1856,13 +2765,14 @@ size_t graph_get_hw_processed_buff_cnt(struct graph_obj *graph_obj,
 
 int graph_eos(struct graph_obj *graph_obj)
 {
+    AGM_TRACE_SCOPE("graph_eos");
     int ret = 0;
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
         return -EINVAL;
     }
     AGM_LOGE("enter");
-    ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_EOS, NULL, 0);
+    ret = graph_gsl_ioctl(graph_obj, GSL_CMD_EOS, NULL, 0);
     AGM_LOGE("exit, ret %d", ret);
     return ar_err_get_lnx_err_code(ret);
 }
@@ -1938,6 +2848,34 @@ done:
     return ret;
 }
 
+void graph_get_snapshot(struct graph_obj *graph_obj, struct graph_snapshot *snap)
+{
+    struct listnode *node = NULL;
+    module_info_t *mod = NULL;
+    struct module_snapshot *mod_snap = NULL;
+
+    memset(snap, 0, sizeof(struct graph_snapshot));
+    if (graph_obj == NULL)
+        return;
+
+    pthread_mutex_lock(&graph_obj->lock);
+    snap->valid = true;
+    snap->state = graph_obj->state;
+    snap->mod_cfg_skip_cnt = graph_obj->mod_cfg_skip_cnt;
+    list_for_each(node, &graph_obj->tagged_mod_list) {
+        snap->total_modules++;
+        if (snap->num_modules == SNAPSHOT_MAX_MODULES)
+            continue;
+        mod = node_to_item(node, module_info_t, list);
+        mod_snap = &snap->modules[snap->num_modules++];
+        mod_snap->tag = mod->tag;
+        mod_snap->mid = mod->mid;
+        mod_snap->miid = mod->miid;
+        mod_snap->is_configured = mod->is_configured;
+    }
+    pthread_mutex_unlock(&graph_obj->lock);
+}
+
 int graph_get_buffer_timestamp(struct graph_obj *graph_obj, uint64_t *tstamp)
 {
     int ret = 0;
@@ -1993,7 +2931,7 @@ static int graph_fill_buf_info(struct graph_obj *gph_obj,
         goto free_shbuf_info;
     }
 
-    ret = gsl_ioctl(gph_obj->graph_handle, cmd_id, shmem_buf_info,
+    ret = graph_gsl_ioctl(gph_obj, cmd_id, shmem_buf_info,
         sizeof(struct gsl_cmd_get_shmem_buf_info) + sizeof(struct gsl_shmem_buf));
     if (ret != 0) {
         AGM_LOGE("Buffer info get failed error %d", ret);
@@ -2076,7 +3014,7 @@ int graph_set_gapless_metadata(struct graph_obj *graph_obj,
                                uint32_t silence)
 {
     int ret = 0;
-    struct listnode *node = NULL;
+    uint32_t idx;
     struct module_info *mod;
     struct apm_module_param_data_t *header;
     struct param_id_remove_initial_silence_t *pid_is;
@@ -2091,13 +3029,11 @@ int graph_set_gapless_metadata(struct graph_obj *graph_obj,
     }
     pthread_mutex_lock(&graph_obj->lock);
 
-    list_for_each(node, &graph_obj->tagged_mod_list) {
-        mod = node_to_item(node, module_info_t, list);
-        if (mod->tag == TAG_STREAM_PLACEHOLDER_DECODER) {
-            AGM_LOGD("Decoder module IID %x", mod->miid);
-            decoder_miid = mod->miid;
-            break;
-        }
+    graph_for_each_tagged_module(graph_obj, TAG_STREAM_PLACEHOLDER_DECODER,
+                                 idx, mod) {
+        AGM_LOGD("Decoder module IID %x", mod->miid);
+        decoder_miid = mod->miid;
+        break;
     }
     if (decoder_miid == 0) {
         AGM_LOGE("Decoder MIID not found");
@@ -2131,7 +3067,7 @@ int graph_set_gapless_metadata(struct graph_obj *graph_obj,
         goto error;
     }
     pid_is->samples_per_ch_to_remove = silence;
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret !=0)
         AGM_LOGE("failed to set %d type silence with ret = %d", type, ret);
 
@@ -2147,9 +3083,15 @@ int graph_set_tag_data_to_acdb(
     struct agm_key_vector_gsl *tag_key_vect, uint8_t *payload,
     uint32_t payload_size)
 {
-    return gsl_set_tag_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
+    int ret = 0;
+
+    pthread_mutex_lock(&acdb_write_lock);
+    ret = gsl_set_tag_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
                  tag_id, (struct gsl_key_vector *)tag_key_vect,
                  payload, payload_size);
+    pthread_mutex_unlock(&acdb_write_lock);
+
+    return ret;
 }
 
 int graph_set_cal_data_to_acdb(
@@ -2157,9 +3099,15 @@ int graph_set_cal_data_to_acdb(
     struct agm_key_vector_gsl *cal_key_vect, uint8_t *payload,
     uint32_t payload_size)
 {
-    return gsl_set_cal_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
+    int ret = 0;
+
+    pthread_mutex_lock(&acdb_write_lock);
+    ret = gsl_set_cal_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
                 (struct gsl_key_vector *)cal_key_vect,
                 payload, payload_size);
+    pthread_mutex_unlock(&acdb_write_lock);
+
+    return ret;
 }
 
 int graph_get_tagged_data(
@@ -2174,7 +3122,13 @@ int graph_get_tagged_data(
 
 int graph_enable_acdb_persistence(uint8_t enable_flag)
 {
-    return gsl_enable_acdb_persistence(enable_flag);
+    int ret = 0;
+
+    pthread_mutex_lock(&acdb_write_lock);
+    ret = acdb_persistence_set(enable_flag);
+    pthread_mutex_unlock(&acdb_write_lock);
+
+    return ret;
 }
 
 static bool is_media_config_needed_on_datapath(enum agm_media_format format)
@@ -2201,19 +3155,17 @@ static bool is_media_config_needed_on_datapath(enum agm_media_format format)
 int graph_set_media_config_datapath(struct graph_obj *graph_obj)
 {
     int ret = 0;
-    struct listnode *node = NULL;
+    uint32_t idx;
     module_info_t *mod = NULL;
     struct session_obj *sess_obj = graph_obj->sess_obj;
 
     if (is_media_config_needed_on_datapath(sess_obj->out_media_config.format)) {
-        list_for_each(node, &graph_obj->tagged_mod_list) {
-            mod = node_to_item(node, module_info_t, list);
-            if (mod->tag == STREAM_INPUT_MEDIA_FORMAT) {
-                ret = mod->configure(mod, graph_obj);
-                if (ret != 0) {
-                    AGM_LOGE("Module configuration for miid %x, mid %x, tag %x, failed:%d\n",
-                              mod->miid, mod->mid, mod->tag, ret);
-                }
+        graph_for_each_tagged_module(graph_obj, STREAM_INPUT_MEDIA_FORMAT,
+                                     idx, mod) {
+            ret = mod->configure(mod, graph_obj);
+            if (ret != 0) {
+                AGM_LOGE("Module configuration for miid %x, mid %x, tag %x, failed:%d\n",
+                          mod->miid, mod->mid, mod->tag, ret);
             }
         }
     } else {
@@ -62,6 +62,7 @@
  */
 
 #define LOG_TAG "AGM: graph_module"
+#define AGM_LOG_MODULE AGM_LOG_MOD_GRAPH
 
 #include <errno.h>
 #include <pthread.h>
@@ -280,7 +281,7 @@ static int configure_codec_dma_ep(struct module_info *mod,
               codec_config->lpaif_type, codec_config->intf_indx,
               codec_config->active_channels_mask);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_sz);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_sz);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config for module %d failed with error %d",
@@ -371,7 +372,7 @@ static int configure_i2s_ep(struct module_info *mod,
               i2s_config->lpaif_type, i2s_config->intf_idx,
               i2s_config->sd_line_idx, i2s_config->ws_src);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_sz);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_sz);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config for module %d failed with error %d",
@@ -466,7 +467,7 @@ static int configure_tdm_ep(struct module_info *mod,
     AGM_LOGV("inv_sync_pulse %d sync_data_delay %d",
              tdm_config->ctrl_invert_sync_pulse, tdm_config->ctrl_sync_data_delay);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_sz);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_sz);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config for module %d failed with error %d",
@@ -554,7 +555,7 @@ static int configure_aux_pcm_ep(struct module_info *mod,
              aux_pcm_cfg->slot_mask, aux_pcm_cfg->frame_setting,
              aux_pcm_cfg->aux_mode);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_sz);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_sz);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config for module %d failed with error %d",
@@ -632,7 +633,7 @@ static int configure_slimbus_ep(struct module_info *mod,
         AGM_LOGV("shared_chnl_mapping[%d] = 0x%x\n", i, slimbus_cfg->shared_channel_mapping[i]);
     }
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_sz);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_sz);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config for module %d failed with error %d",
@@ -693,7 +694,7 @@ int configure_hw_ep_media_config(struct module_info *mod,
                     hw_ep_media_conf->bit_width, media_config.channels,
                     media_config.data_format);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config command for module %d failed with error %d",
@@ -908,7 +909,7 @@ int configure_output_media_format(struct module_info *mod,
      */
     get_default_channel_map(channel_map, num_channels);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config command for module %d failed with error %d",
@@ -950,7 +951,7 @@ static int configure_pcm_encoder_frame_size(struct module_info *mod,
     frame_size_payload->frame_size_type = 1; /* frame_size_in_samples */
     frame_size_payload->frame_size_in_samples = frame_size_samples;
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("pcm encoder frame size config for module %d failed with error %d",
@@ -1312,7 +1313,7 @@ int configure_encoder_output_media_format(struct module_info *mod,
     header->param_id = PARAM_ID_ENCODER_OUTPUT_CONFIG;
     header->error_code = 0x0;
     header->param_size = sizeof(struct param_id_encoder_output_config_t);
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE(
@@ -1358,7 +1359,7 @@ int configure_encoder_output_media_format(struct module_info *mod,
     header->param_id = PARAM_ID_ENC_BITRATE;
     header->error_code = 0x0;
     header->param_size = sizeof(struct param_id_enc_bitrate_param_t);
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE(
@@ -1511,7 +1512,7 @@ int configure_compress_shared_mem_ep(struct module_info *mod,
         goto free_payload;
     }
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config command for module %d failed with error %d",
@@ -1667,7 +1668,7 @@ int configure_pcm_shared_mem_ep(struct module_info *mod,
      */
     get_default_channel_map(channel_map, num_channels);
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config command for module %d failed with error %d",
@@ -1776,7 +1777,7 @@ int configure_rd_shared_mem_ep(struct module_info *mod,
         AGM_LOGD("compress capture uses 1 frame per buffer");
     }
 
-    ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
+    ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("custom_config command for module %d failed with error %d",
@@ -1794,7 +1795,7 @@ int configure_spr(struct module_info *spr_mod,
 {
     int ret = 0;
 
-    struct listnode *node = NULL;
+    uint32_t idx;
     struct module_info *mod;
     struct apm_module_param_data_t *header;
     struct param_id_spr_delay_path_end_t *spr_hwep_delay;
@@ -1821,16 +1822,13 @@ int configure_spr(struct module_info *spr_mod,
     header->error_code = 0x0;
     header->param_size = sizeof(struct param_id_spr_delay_path_end_t);
 
-    list_for_each(node, &graph_obj->tagged_mod_list) {
-        mod = node_to_item(node, module_info_t, list);
-        if (mod->tag == DEVICE_HW_ENDPOINT_RX) {
-            AGM_LOGD("HW EP module IID %x", mod->miid);
-            spr_hwep_delay->module_instance_id = mod->miid;
-            ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
-            if (ret !=0) {
-                ret = ar_err_get_lnx_err_code(ret);
-                AGM_LOGE("graph_set_custom_config failed %d", ret);
-            }
+    graph_for_each_tagged_module(graph_obj, DEVICE_HW_ENDPOINT_RX, idx, mod) {
+        AGM_LOGD("HW EP module IID %x", mod->miid);
+        spr_hwep_delay->module_instance_id = mod->miid;
+        ret = graph_gsl_set_custom_config(graph_obj, payload, payload_size);
+        if (ret !=0) {
+            ret = ar_err_get_lnx_err_code(ret);
+            AGM_LOGE("graph_set_custom_config failed %d", ret);
         }
     }
 done:
@@ -1873,7 +1871,7 @@ int configure_gapless(struct module_info *gapless_mod,
     reg_ev_payload->event_config_payload_size = 0;
     reg_ev_payload->is_register = 1;
 
-    ret = gsl_ioctl(gph_obj->graph_handle, GSL_CMD_REGISTER_CUSTOM_EVENT,
+    ret = graph_gsl_ioctl(gph_obj, GSL_CMD_REGISTER_CUSTOM_EVENT,
                                            reg_ev_payload, payload_size);
     if (ret != 0) {
        ret = ar_err_get_lnx_err_code(ret);
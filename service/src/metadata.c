@@ -27,6 +27,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #define LOG_TAG "AGM: metadata"
+#define AGM_LOG_MODULE AGM_LOG_MOD_METADATA
 #include <stdio.h>
 #include <malloc.h>
 #include <string.h>
@@ -76,6 +77,11 @@
 void metadata_print(struct agm_meta_data_gsl* metadata)
 {
     int i, count = metadata->gkv.num_kvs;
+
+    /*one check instead of one per key*/
+    if (!AGM_LOG_ON(AGM_LOG_LEVEL_DEBUG))
+        return;
+
     AGM_LOGD("*************************Metadata*************************\n");
     AGM_LOGD("GKV size:%d\n", count);
     for (i = 0; i < count; i++) {
@@ -360,3 +366,25 @@ void metadata_free(struct agm_meta_data_gsl *metadata)
         memset(metadata, 0, sizeof(struct agm_meta_data_gsl));
     }
 }
+
+static bool metadata_kv_equal(const struct agm_key_vector_gsl *a,
+                              const struct agm_key_vector_gsl *b)
+{
+    if (a->num_kvs != b->num_kvs)
+        return false;
+
+    if (a->num_kvs == 0)
+        return true;
+
+    return !memcmp(a->kv, b->kv, a->num_kvs * sizeof(struct agm_key_value));
+}
+
+bool metadata_equal(const struct agm_meta_data_gsl *a,
+                    const struct agm_meta_data_gsl *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return metadata_kv_equal(&a->gkv, &b->gkv) &&
+           metadata_kv_equal(&a->ckv, &b->ckv);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#define LOG_TAG "AGM: perf"
+
+#include <string.h>
+#include <time.h>
+
+#include <agm/perf.h>
+
+#define PERF_ADD(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define PERF_LOAD(x)   __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+static const char *perf_op_names[AGM_PERF_OP_MAX] = {
+    [AGM_PERF_OP_OPEN] = "open",
+    [AGM_PERF_OP_PREPARE] = "prepare",
+    [AGM_PERF_OP_START] = "start",
+    [AGM_PERF_OP_STOP] = "stop",
+    [AGM_PERF_OP_CLOSE] = "close",
+    [AGM_PERF_OP_GSL_IOCTL] = "gsl_ioctl",
+    [AGM_PERF_OP_GSL_SET_CUSTOM_CONFIG] = "gsl_set_custom_config",
+    [AGM_PERF_OP_WRITE] = "write",
+    [AGM_PERF_OP_READ] = "read",
+    [AGM_PERF_OP_LAUNCH] = "launch",
+};
+
+uint64_t perf_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t perf_hist_bucket(uint64_t us)
+{
+    uint32_t bucket = 0;
+
+    /*bucket i holds [2^(i-1), 2^i) us*/
+    while (us && bucket < AGM_PERF_HIST_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void perf_record(struct agm_perf_stats *stats, enum agm_perf_op op,
+                 uint64_t start_us, size_t bytes, int ret)
+{
+    struct agm_perf_op_stats *op_stats;
+    uint64_t duration, max;
+
+    if (stats == NULL || op >= AGM_PERF_OP_MAX)
+        return;
+
+    duration = perf_now_us() - start_us;
+    op_stats = &stats->op[op];
+
+    PERF_ADD(op_stats->count, 1);
+    PERF_ADD(op_stats->total_us, duration);
+    PERF_ADD(op_stats->hist[perf_hist_bucket(duration)], 1);
+    if (bytes)
+        PERF_ADD(op_stats->bytes, bytes);
+    if (ret)
+        PERF_ADD(op_stats->errors, 1);
+
+    max = PERF_LOAD(op_stats->max_us);
+    while (duration > max &&
+           !__atomic_compare_exchange_n(&op_stats->max_us, &max, duration,
+                               true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void perf_snapshot(const struct agm_perf_stats *stats,
+                   struct agm_perf_stats *out)
+{
+    const struct agm_perf_op_stats *src;
+    struct agm_perf_op_stats *dst;
+    int op, i;
+
+    out->session_id = stats->session_id;
+    for (op = 0; op < AGM_PERF_OP_MAX; op++) {
+        src = &stats->op[op];
+        dst = &out->op[op];
+        dst->count = PERF_LOAD(src->count);
+        dst->errors = PERF_LOAD(src->errors);
+        dst->total_us = PERF_LOAD(src->total_us);
+        dst->max_us = PERF_LOAD(src->max_us);
+        dst->bytes = PERF_LOAD(src->bytes);
+        for (i = 0; i < AGM_PERF_HIST_BUCKETS; i++)
+            dst->hist[i] = PERF_LOAD(src->hist[i]);
+    }
+}
+
+const char *perf_op_name(enum agm_perf_op op)
+{
+    if (op >= AGM_PERF_OP_MAX)
+        return "unknown";
+
+    return perf_op_names[op];
+}
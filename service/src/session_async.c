@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#define LOG_TAG "AGM: session_async"
+#define AGM_LOG_MODULE AGM_LOG_MOD_SESSION
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <agm/agm_trace.h>
+#include <agm/session_obj.h>
+#include <agm/utils.h>
+
+static void session_async_notify(struct session_obj *sess_obj,
+                                 struct session_async_work *work, int status)
+{
+    struct agm_event_cb_params *event_params = NULL;
+    struct agm_event_async_done_payload *payload = NULL;
+    struct session_cb *sess_cb;
+    struct listnode *node, *next;
+
+    event_params = calloc(1, sizeof(struct agm_event_cb_params) +
+                             sizeof(struct agm_event_async_done_payload));
+    if (!event_params) {
+        AGM_LOGE("Not enough memory for event_params");
+        return;
+    }
+
+    event_params->event_id = AGM_EVENT_ASYNC_DONE;
+    event_params->event_payload_size =
+                             sizeof(struct agm_event_async_done_payload);
+    payload = (struct agm_event_async_done_payload *)event_params->event_payload;
+    payload->op = work->op;
+    payload->aif_id = work->aif_id;
+    payload->status = status;
+    payload->cookie = work->cookie;
+
+    pthread_mutex_lock(&sess_obj->cb_pool_lock);
+    list_for_each_safe(node, next, &sess_obj->cb_pool) {
+        sess_cb = node_to_item(node, struct session_cb, node);
+        if (sess_cb && sess_cb->cb &&
+            sess_cb->evt_type == AGM_EVENT_CONTROL_PATH)
+            sess_cb->cb(sess_obj->sess_id, event_params,
+                        sess_cb->client_data);
+    }
+    pthread_mutex_unlock(&sess_obj->cb_pool_lock);
+    free(event_params);
+}
+
+static int session_async_run(struct session_obj *sess_obj,
+                             struct session_async_work *work)
+{
+    AGM_TRACE_SCOPE("session_async_run");
+
+    switch (work->op) {
+    case AGM_ASYNC_OP_PREPARE:
+        return session_obj_prepare(sess_obj);
+    case AGM_ASYNC_OP_START:
+        return session_obj_start(sess_obj);
+    case AGM_ASYNC_OP_STOP:
+        return session_obj_stop(sess_obj);
+    case AGM_ASYNC_OP_CLOSE:
+        return session_obj_close(sess_obj);
+    case AGM_ASYNC_OP_AIF_CONNECT:
+        return session_obj_sess_aif_connect(sess_obj, work->aif_id,
+                                            work->aif_state);
+    default:
+        return -EINVAL;
+    }
+}
+
+static void *session_async_thread(void *arg)
+{
+    struct session_obj *sess_obj = (struct session_obj *)arg;
+    struct session_async *async = &sess_obj->async;
+    struct session_async_work *work = NULL;
+    int ret = 0;
+
+    pthread_mutex_lock(&async->lock);
+    while (!async->exit) {
+        if (list_empty(&async->work_list)) {
+            pthread_cond_wait(&async->cond, &async->lock);
+            continue;
+        }
+        work = node_to_item(list_head(&async->work_list),
+                            struct session_async_work, node);
+        list_remove(&work->node);
+        pthread_mutex_unlock(&async->lock);
+
+        ret = session_async_run(sess_obj, work);
+        if (ret)
+            AGM_LOGE("Error:%d async op %d on sess_id:%d\n", ret, work->op,
+                     sess_obj->sess_id);
+        session_async_notify(sess_obj, work, ret);
+        free(work);
+
+        pthread_mutex_lock(&async->lock);
+    }
+    pthread_mutex_unlock(&async->lock);
+    return NULL;
+}
+
+int session_obj_async_queue(struct session_obj *sess_obj,
+                            enum agm_async_op op, uint32_t aif_id,
+                            bool aif_state, uint64_t cookie)
+{
+    struct session_async *async = &sess_obj->async;
+    struct session_async_work *work = NULL;
+    int ret = 0;
+
+    work = calloc(1, sizeof(struct session_async_work));
+    if (!work) {
+        AGM_LOGE("No memory for async op on sess_id:%d\n", sess_obj->sess_id);
+        return -ENOMEM;
+    }
+    work->op = op;
+    work->aif_id = aif_id;
+    work->aif_state = aif_state;
+    work->cookie = cookie;
+
+    pthread_mutex_lock(&async->lock);
+    if (async->exit) {
+        ret = -ESHUTDOWN;
+        goto done;
+    }
+
+    /*worker is started on the first async operation of the session*/
+    if (!async->thread_created) {
+        ret = -pthread_create(&async->thread, NULL, session_async_thread,
+                              sess_obj);
+        if (ret) {
+            AGM_LOGE("Error:%d creating async worker for sess_id:%d\n",
+                     ret, sess_obj->sess_id);
+            goto done;
+        }
+        async->thread_created = true;
+    }
+
+    list_add_tail(&async->work_list, &work->node);
+    work = NULL;
+    pthread_cond_signal(&async->cond);
+
+done:
+    pthread_mutex_unlock(&async->lock);
+    free(work);
+    return ret;
+}
+
+void session_obj_async_init(struct session_obj *sess_obj)
+{
+    struct session_async *async = &sess_obj->async;
+
+    list_init(&async->work_list);
+    pthread_mutex_init(&async->lock, (const pthread_mutexattr_t *) NULL);
+    pthread_cond_init(&async->cond, (const pthread_condattr_t *) NULL);
+}
+
+/*must be called without the session lock held, the worker takes it*/
+void session_obj_async_deinit(struct session_obj *sess_obj)
+{
+    struct session_async *async = &sess_obj->async;
+    struct session_async_work *work = NULL;
+    struct listnode *node, *next;
+
+    pthread_mutex_lock(&async->lock);
+    async->exit = true;
+    pthread_cond_signal(&async->cond);
+    pthread_mutex_unlock(&async->lock);
+
+    if (async->thread_created) {
+        pthread_join(async->thread, NULL);
+        async->thread_created = false;
+    }
+
+    /*operations still queued are reported as cancelled*/
+    list_for_each_safe(node, next, &async->work_list) {
+        work = node_to_item(node, struct session_async_work, node);
+        list_remove(&work->node);
+        session_async_notify(sess_obj, work, -ECANCELED);
+        free(work);
+    }
+
+    pthread_cond_destroy(&async->cond);
+    pthread_mutex_destroy(&async->lock);
+}
@@ -32,9 +32,11 @@
  * SPDX-License-Identifier: BSD-3-Clause-Clear
  */
 #define LOG_TAG "AGM: session"
+#define AGM_LOG_MODULE AGM_LOG_MOD_SESSION
 
 #include <malloc.h>
 #include <string.h>
+#include <agm/agm_trace.h>
 #include <agm/session_obj.h>
 #include <agm/utils.h>
 
@@ -262,10 +264,16 @@ static void session_pool_free()
     struct listnode *node, *next;
     int ret = 0;
 
+    /*stop the async workers first, a queued start takes the pool lock*/
+    list_for_each(node, &sess_pool->session_list) {
+        sess_obj = node_to_item(node, struct session_obj, node);
+        session_obj_async_deinit(sess_obj);
+    }
+
     pthread_mutex_lock(&sess_pool->lock);
     list_for_each_safe(node, next, &sess_pool->session_list) {
         sess_obj = node_to_item(node, struct session_obj, node);
-        pthread_mutex_lock(&sess_obj->lock);
+        AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
         ret = session_close(sess_obj);
         if (ret) {
             AGM_LOGE("Error:%d closing session with session id:%d\n",
@@ -281,6 +289,47 @@ static void session_pool_free()
     free(sess_pool);
 }
 
+/*
+ *Publish a plain copy of the session state for agm_dump, must be called
+ *with the session lock held.
+ */
+static void session_publish_snapshot(struct session_obj *sess_obj)
+{
+    struct session_snapshot *snap = &sess_obj->snapshot.data;
+    struct listnode *node;
+    struct aif *aif_obj;
+    struct graph_snapshot graph_snap;
+
+    /*query the graph first to keep the write side of the seqlock short*/
+    graph_get_snapshot(sess_obj->graph, &graph_snap);
+
+    snapshot_write_begin(&sess_obj->snapshot);
+    snap->state = sess_obj->state;
+    snap->stream_config = sess_obj->stream_config;
+    snap->in_media_config = sess_obj->in_media_config;
+    snap->out_media_config = sess_obj->out_media_config;
+    snap->in_buffer_config = sess_obj->in_buffer_config;
+    snap->out_buffer_config = sess_obj->out_buffer_config;
+    snap->loopback_sess_id = sess_obj->loopback_sess_id;
+    snap->loopback_state = sess_obj->loopback_state;
+    snap->ec_ref_aif_id = sess_obj->ec_ref_aif_id;
+    snap->ec_ref_state = sess_obj->ec_ref_state;
+    snap->standby_enabled = sess_obj->standby_enabled;
+    snap->total_aifs = 0;
+    snap->num_aifs = 0;
+    list_for_each(node, &sess_obj->aif_pool) {
+        snap->total_aifs++;
+        if (snap->num_aifs == SNAPSHOT_MAX_AIFS)
+            continue;
+        aif_obj = node_to_item(node, struct aif, node);
+        snap->aifs[snap->num_aifs].aif_id = aif_obj->aif_id;
+        snap->aifs[snap->num_aifs].state = aif_obj->state;
+        snap->num_aifs++;
+    }
+    snap->graph = graph_snap;
+    snapshot_write_end(&sess_obj->snapshot);
+}
+
 static struct session_obj* session_obj_create(int session_id)
 {
     struct session_obj *obj = NULL;
@@ -292,10 +341,12 @@ static struct session_obj* session_obj_create(int session_id)
     }
 
     obj->sess_id = session_id;
+    obj->perf.session_id = session_id;
     list_init(&obj->aif_pool);
     list_init(&obj->cb_pool);
     pthread_mutex_init(&obj->lock, (const pthread_mutexattr_t *) NULL);
     pthread_mutex_init(&obj->cb_pool_lock, (const pthread_mutexattr_t *) NULL);
+    session_obj_async_init(obj);
 
     return obj;
 }
@@ -539,7 +590,7 @@ static int session_disconnect_aif(struct session_obj *sess_obj,
         goto done;
     }
 
-    pthread_mutex_lock(&hwep_lock);
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
     if (opened_count == 1) {
         //this is SSSD condition, hence stop just the stream/stream-device,
         //merged only sess-aif, aif
@@ -600,6 +651,7 @@ done:
 static void graph_event_cb(struct agm_event_cb_params *event_params,
                          void *client_data)
 {
+    AGM_TRACE_SCOPE("graph_event_cb");
     struct session_obj *sess_obj = NULL;
     struct session_cb *sess_cb;
     struct listnode *node, *next;
@@ -991,7 +1043,7 @@ static int session_prepare(struct session_obj *sess_obj)
         }
 
         if ((sess_obj->state != SESSION_STARTED)) {
-            pthread_mutex_lock(&hwep_lock);
+            AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
             ret = graph_prepare(sess_obj->graph);
             pthread_mutex_unlock(&hwep_lock);
             if (ret) {
@@ -1083,7 +1135,7 @@ static int session_start(struct session_obj *sess_obj)
             }
         }
 
-        pthread_mutex_lock(&hwep_lock);
+        AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
 
         //For Slimbus EP - First configure the slave ports via device_prepare/start
         //and then start the master side via graph_start.
@@ -1168,10 +1220,11 @@ static int session_start(struct session_obj *sess_obj)
     }
 
     sess_obj->state = SESSION_STARTED;
+    sess_obj->standby_reused = false;
     goto done;
 
 unwind:
-    pthread_mutex_lock(&hwep_lock);
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
     graph_stop(sess_obj->graph, NULL);
 device_stop:
     if (sess_mode != AGM_SESSION_NON_TUNNEL  && sess_mode != AGM_SESSION_NO_CONFIG) {
@@ -1206,7 +1259,7 @@ static int session_stop(struct session_obj *sess_obj)
     }
 
     if (sess_mode != AGM_SESSION_NON_TUNNEL  && sess_mode != AGM_SESSION_NO_CONFIG) {
-        pthread_mutex_lock(&hwep_lock);
+        AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
         if (dir == RX) {
             ret = graph_stop(sess_obj->graph, NULL);
             if (ret) {
@@ -1252,6 +1305,331 @@ done:
     return ret;
 }
 
+/*
+ *Standby graphs: when enabled on a session, the prepared graph is kept
+ *on close instead of being torn down, and handed back on the next open
+ *of the session if the metadata, device, media and buffer configuration
+ *did not change. The list is ordered least recently used first and its
+ *approximate memory footprint is bounded by STANDBY_GRAPH_MEM_BUDGET.
+ */
+#define STANDBY_GRAPH_MEM_BUDGET   (512 * 1024)
+/*approximate footprint of a graph apart from its data buffers*/
+#define STANDBY_GRAPH_BASE_SIZE    (16 * 1024)
+
+struct standby_graph {
+    struct listnode node;
+    uint32_t sess_id;
+    uint32_t aif_id;
+    struct agm_meta_data_gsl *metadata;
+    struct agm_media_config dev_media_config;
+    struct agm_session_config stream_config;
+    struct agm_media_config in_media_config;
+    struct agm_media_config out_media_config;
+    struct agm_buffer_config in_buffer_config;
+    struct agm_buffer_config out_buffer_config;
+    struct graph_obj *graph;
+    size_t mem_size;
+};
+
+static list_declare(standby_list);
+static size_t standby_mem_size;
+static pthread_mutex_t standby_lock = PTHREAD_MUTEX_INITIALIZER;
+/*set on deinit so that closing sessions no longer park their graphs*/
+static bool standby_disabled;
+
+static struct aif *session_standby_get_aif(struct session_obj *sess_obj,
+                                           enum aif_state state)
+{
+    struct listnode *node;
+    struct aif *temp = NULL, *aif_obj = NULL;
+
+    list_for_each(node, &sess_obj->aif_pool) {
+        temp = node_to_item(node, struct aif, node);
+        if (temp->state < state)
+            continue;
+        /*only single device sessions are kept in standby*/
+        if (aif_obj)
+            return NULL;
+        aif_obj = temp;
+    }
+
+    return aif_obj;
+}
+
+static bool session_standby_supported(struct session_obj *sess_obj)
+{
+    return sess_obj->standby_enabled &&
+           sess_obj->stream_config.sess_mode == AGM_SESSION_DEFAULT &&
+           !sess_obj->loopback_state && !sess_obj->ec_ref_state;
+}
+
+static struct agm_meta_data_gsl *session_standby_metadata(
+                 struct session_obj *sess_obj, struct aif *aif_obj)
+{
+    struct agm_meta_data_gsl *merged_metadata = NULL;
+
+    pthread_mutex_lock(&aif_obj->dev_obj->lock);
+    merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
+                         &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
+    pthread_mutex_unlock(&aif_obj->dev_obj->lock);
+
+    return merged_metadata;
+}
+
+static bool session_standby_config_match(struct standby_graph *sg,
+                                         struct session_obj *sess_obj)
+{
+    return !memcmp(&sg->stream_config, &sess_obj->stream_config,
+                   sizeof(struct agm_session_config)) &&
+           !memcmp(&sg->in_media_config, &sess_obj->in_media_config,
+                   sizeof(struct agm_media_config)) &&
+           !memcmp(&sg->out_media_config, &sess_obj->out_media_config,
+                   sizeof(struct agm_media_config)) &&
+           !memcmp(&sg->in_buffer_config, &sess_obj->in_buffer_config,
+                   sizeof(struct agm_buffer_config)) &&
+           !memcmp(&sg->out_buffer_config, &sess_obj->out_buffer_config,
+                   sizeof(struct agm_buffer_config));
+}
+
+static void session_standby_free(struct standby_graph *sg)
+{
+    int ret = 0;
+
+    if (sg->graph) {
+        ret = graph_close(sg->graph);
+        if (ret)
+            AGM_LOGE("Error:%d closing standby graph of session id:%d\n",
+                     ret, sg->sess_id);
+    }
+    if (sg->metadata) {
+        metadata_free(sg->metadata);
+        free(sg->metadata);
+    }
+    free(sg);
+}
+
+/*Must be called with standby_lock held*/
+static void session_standby_evict(size_t needed)
+{
+    struct standby_graph *sg = NULL;
+
+    while (!list_empty(&standby_list) &&
+           (standby_mem_size + needed > STANDBY_GRAPH_MEM_BUDGET)) {
+        sg = node_to_item(list_head(&standby_list), struct standby_graph, node);
+        list_remove(&sg->node);
+        standby_mem_size -= sg->mem_size;
+        AGM_LOGD_SESS(sg->sess_id,
+                      "evicting standby graph of session id:%d, %zu bytes\n",
+                      sg->sess_id, sg->mem_size);
+        session_standby_free(sg);
+    }
+}
+
+/*
+ *Releases standby graphs of the given session, or of all sessions if
+ *sess_id is UINT_MAX. Must be called with hwep_lock held.
+ */
+static void session_standby_flush(uint32_t sess_id)
+{
+    struct standby_graph *sg = NULL;
+    struct listnode *node, *next;
+
+    pthread_mutex_lock(&standby_lock);
+    list_for_each_safe(node, next, &standby_list) {
+        sg = node_to_item(node, struct standby_graph, node);
+        if (sess_id != UINT_MAX && sg->sess_id != sess_id)
+            continue;
+        list_remove(&sg->node);
+        standby_mem_size -= sg->mem_size;
+        session_standby_free(sg);
+    }
+    pthread_mutex_unlock(&standby_lock);
+}
+
+/*
+ *Prepares the (stopped) graph of a closing session and moves it to the
+ *standby list. On failure the caller closes the graph as usual.
+ *Must be called with hwep_lock held.
+ */
+static int session_standby_park(struct session_obj *sess_obj)
+{
+    int ret = 0;
+    struct aif *aif_obj = NULL;
+    struct standby_graph *sg = NULL;
+    size_t mem_size = 0, in_use;
+
+    if (standby_disabled || !session_standby_supported(sess_obj) ||
+        sess_obj->graph == NULL)
+        return -EINVAL;
+
+    aif_obj = session_standby_get_aif(sess_obj, AIF_OPENED);
+    if (!aif_obj)
+        return -EINVAL;
+
+    mem_size = STANDBY_GRAPH_BASE_SIZE +
+               sess_obj->in_buffer_config.size * sess_obj->in_buffer_config.count +
+               sess_obj->out_buffer_config.size * sess_obj->out_buffer_config.count;
+    if (mem_size > STANDBY_GRAPH_MEM_BUDGET) {
+        AGM_LOGD_SESS(sess_obj->sess_id,
+                      "session id:%d graph of %zu bytes exceeds standby budget\n",
+                      sess_obj->sess_id, mem_size);
+        return -ENOSPC;
+    }
+
+    sg = calloc(1, sizeof(struct standby_graph));
+    if (!sg) {
+        AGM_LOGE("No memory to create standby graph\n");
+        return -ENOMEM;
+    }
+
+    sg->metadata = session_standby_metadata(sess_obj, aif_obj);
+    if (!sg->metadata) {
+        AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
+                 sess_obj->sess_id, aif_obj->aif_id);
+        ret = -ENOMEM;
+        goto free_sg;
+    }
+
+    ret = graph_prepare(sess_obj->graph);
+    if (ret) {
+        AGM_LOGE("Error:%d preparing standby graph session id:%d\n",
+                 ret, sess_obj->sess_id);
+        goto free_sg;
+    }
+
+    sg->sess_id = sess_obj->sess_id;
+    sg->aif_id = aif_obj->aif_id;
+    sg->dev_media_config = aif_obj->dev_obj->media_config;
+    sg->stream_config = sess_obj->stream_config;
+    sg->in_media_config = sess_obj->in_media_config;
+    sg->out_media_config = sess_obj->out_media_config;
+    sg->in_buffer_config = sess_obj->in_buffer_config;
+    sg->out_buffer_config = sess_obj->out_buffer_config;
+    sg->graph = sess_obj->graph;
+    sg->mem_size = mem_size;
+
+    pthread_mutex_lock(&standby_lock);
+    session_standby_evict(mem_size);
+    list_add_tail(&standby_list, &sg->node);
+    standby_mem_size += mem_size;
+    in_use = standby_mem_size;
+    pthread_mutex_unlock(&standby_lock);
+
+    AGM_LOGI("session id:%d graph kept in standby, %zu/%d bytes in use\n",
+             sess_obj->sess_id, in_use, STANDBY_GRAPH_MEM_BUDGET);
+    sess_obj->graph = NULL;
+    return 0;
+
+free_sg:
+    sg->graph = NULL;
+    session_standby_free(sg);
+    return ret;
+}
+
+/*
+ *Looks for a standby graph matching the session about to be opened and,
+ *if found, opens the device and hands the prepared graph to the session.
+ */
+static int session_standby_reuse(struct session_obj *sess_obj)
+{
+    int ret = 0;
+    struct aif *aif_obj = NULL;
+    struct agm_meta_data_gsl *merged_metadata = NULL;
+    struct standby_graph *sg = NULL, *temp = NULL;
+    struct listnode *node;
+
+    if (!session_standby_supported(sess_obj) || sess_obj->params)
+        return -ENOENT;
+
+    aif_obj = session_standby_get_aif(sess_obj, AIF_OPEN);
+    if (!aif_obj || aif_obj->state != AIF_OPEN ||
+        aif_obj->params || aif_obj->tag_config)
+        return -ENOENT;
+
+    merged_metadata = session_standby_metadata(sess_obj, aif_obj);
+    if (!merged_metadata)
+        return -ENOMEM;
+
+    pthread_mutex_lock(&standby_lock);
+    list_for_each(node, &standby_list) {
+        temp = node_to_item(node, struct standby_graph, node);
+        if (temp->sess_id == sess_obj->sess_id &&
+            temp->aif_id == aif_obj->aif_id &&
+            !memcmp(&temp->dev_media_config, &aif_obj->dev_obj->media_config,
+                    sizeof(struct agm_media_config)) &&
+            session_standby_config_match(temp, sess_obj) &&
+            metadata_equal(temp->metadata, merged_metadata)) {
+            sg = temp;
+            list_remove(&sg->node);
+            standby_mem_size -= sg->mem_size;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&standby_lock);
+
+    metadata_free(merged_metadata);
+    free(merged_metadata);
+
+    if (!sg)
+        return -ENOENT;
+
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
+    ret = device_open(aif_obj->dev_obj);
+    if (ret) {
+        AGM_LOGE("Error:%d opening device object with id:%d \n",
+            ret, aif_obj->aif_id);
+        session_standby_free(sg);
+        pthread_mutex_unlock(&hwep_lock);
+        return ret;
+    }
+
+    sess_obj->graph = sg->graph;
+    sess_obj->standby_reused = true;
+    aif_obj->state = AIF_OPENED;
+    sg->graph = NULL;
+    session_standby_free(sg);
+    pthread_mutex_unlock(&hwep_lock);
+
+    AGM_LOGI("session id:%d reusing standby graph\n", sess_obj->sess_id);
+    return 0;
+}
+
+/*
+ *The client changed the configuration of a session opened from a
+ *standby graph before starting it, drop the graph and open a new one.
+ */
+static int session_standby_reopen(struct session_obj *sess_obj)
+{
+    int ret = 0;
+    struct aif *aif_obj = NULL;
+
+    AGM_LOGD_SESS(sess_obj->sess_id,
+                  "session id:%d config changed, reopening standby graph\n",
+                  sess_obj->sess_id);
+    sess_obj->standby_reused = false;
+    aif_obj = session_standby_get_aif(sess_obj, AIF_OPENED);
+
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
+    ret = graph_close(sess_obj->graph);
+    if (ret)
+        AGM_LOGE("Error:%d closing graph\n", ret);
+    sess_obj->graph = NULL;
+    if (aif_obj) {
+        device_close(aif_obj->dev_obj);
+        aif_obj->state = AIF_OPEN;
+    }
+    pthread_mutex_unlock(&hwep_lock);
+    sess_obj->state = SESSION_CLOSED;
+
+    ret = session_open_with_first_device(sess_obj);
+    if (ret) {
+        AGM_LOGE("Error:%d reopening session id:%d\n", ret, sess_obj->sess_id);
+        return ret;
+    }
+    sess_obj->state = SESSION_OPENED;
+    return 0;
+}
+
 static int session_close(struct session_obj *sess_obj)
 {
     int ret = 0;
@@ -1267,7 +1645,7 @@ static int session_close(struct session_obj *sess_obj)
         goto done;
     }
 
-    pthread_mutex_lock(&hwep_lock);
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
     if (sess_obj->state == SESSION_STARTED) {
         ret = graph_stop(sess_obj->graph, NULL);
         if (ret) {
@@ -1275,9 +1653,12 @@ static int session_close(struct session_obj *sess_obj)
         }
     }
 
-    ret = graph_close(sess_obj->graph);
-    if (ret) {
-        AGM_LOGE("Error:%d closing graph\n", ret);
+    sess_obj->standby_reused = false;
+    if (session_standby_park(sess_obj) != 0) {
+        ret = graph_close(sess_obj->graph);
+        if (ret) {
+            AGM_LOGE("Error:%d closing graph\n", ret);
+        }
     }
     sess_obj->graph = NULL;
     sess_obj->ec_ref_state = false;
@@ -1315,6 +1696,15 @@ done:
 
 int session_obj_deinit()
 {
+    /*
+     *Drop the standby graphs and stop parking before the sessions are
+     *closed and freed, a graph parked by session_pool_free would outlive
+     *its session object.
+     */
+    AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
+    standby_disabled = true;
+    session_standby_flush(UINT_MAX);
+    pthread_mutex_unlock(&hwep_lock);
     session_pool_free();
     device_deinit();
     graph_deinit();
@@ -1344,6 +1734,7 @@ int session_obj_init()
         goto graph_deinit;
     }
     pthread_mutex_init(&hwep_lock, (const pthread_mutexattr_t *) NULL);
+    standby_disabled = false;
     goto done;
 
 graph_deinit:
@@ -1362,7 +1753,7 @@ int session_obj_set_sess_metadata(struct session_obj *sess_obj,
 
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     metadata_free(&(sess_obj->sess_meta));
     ret = metadata_copy(&(sess_obj->sess_meta), size, metadata);
     pthread_mutex_unlock(&sess_obj->lock);
@@ -1370,13 +1761,12 @@ int session_obj_set_sess_metadata(struct session_obj *sess_obj,
     return ret;
 }
 
-int session_obj_set_sess_params(struct session_obj *sess_obj,
+/*called with sess_obj->lock held*/
+static int session_set_sess_params(struct session_obj *sess_obj,
     void *payload, size_t size)
 {
    int ret = 0;
 
-   pthread_mutex_lock(&sess_obj->lock);
-
    if (sess_obj->params) {
        free(sess_obj->params);
        sess_obj->params = NULL;
@@ -1386,6 +1776,16 @@ int session_obj_set_sess_params(struct session_obj *sess_obj,
    if ((size == 0) ||(payload == NULL))
        goto done;
 
+   /*an open graph takes the params right away, only cache them otherwise*/
+   if (sess_obj->state != SESSION_CLOSED) {
+       ret = graph_set_config(sess_obj->graph, payload, size);
+       if (ret) {
+           AGM_LOGE("Error:%d setting for sess params on sess_id:%d\n",
+                   ret, sess_obj->sess_id);
+       }
+       goto done;
+   }
+
    sess_obj->params = calloc(1, size);
    if (!sess_obj->params) {
        AGM_LOGE("No memory for sess params on sess_id:%d\n",
@@ -1397,31 +1797,30 @@ int session_obj_set_sess_params(struct session_obj *sess_obj,
    memcpy(sess_obj->params, payload, size);
    sess_obj->params_size = size;
 
-   if (sess_obj->state != SESSION_CLOSED) {
-       ret = graph_set_config(sess_obj->graph, sess_obj->params,
-                                         sess_obj->params_size);
-       if (ret) {
-           AGM_LOGE("Error:%d setting for sess params on sess_id:%d\n",
-                   ret, sess_obj->sess_id);
-       }
-       free(sess_obj->params);
-       sess_obj->params = NULL;
-       sess_obj->params_size = 0;
-   }
-
 done:
-   pthread_mutex_unlock(&sess_obj->lock);
    return ret;
 }
 
-int session_obj_set_sess_aif_params(struct session_obj *sess_obj,
+int session_obj_set_sess_params(struct session_obj *sess_obj,
+    void *payload, size_t size)
+{
+    AGM_TRACE_SCOPE("session_obj_set_sess_params");
+    int ret = 0;
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    ret = session_set_sess_params(sess_obj, payload, size);
+    pthread_mutex_unlock(&sess_obj->lock);
+    return ret;
+}
+
+/*called with sess_obj->lock held*/
+static int session_set_sess_aif_params(struct session_obj *sess_obj,
     uint32_t aif_id,
     void* payload, size_t size)
 {
     int ret = 0;
     struct aif *aif_obj = NULL;
 
-    pthread_mutex_lock(&sess_obj->lock);
     ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
     if (ret) {
         AGM_LOGE("Error obtaining aif object with sess_id:%d,  aif id:%d\n",
@@ -1438,6 +1837,16 @@ int session_obj_set_sess_aif_params(struct session_obj *sess_obj,
    if ((size == 0) || (payload == NULL))
        goto done;
 
+   if (sess_obj->state != SESSION_CLOSED && aif_obj->state >= AIF_OPENED) {
+       ret = graph_set_config(sess_obj->graph, payload, size);
+       if (ret) {
+           AGM_LOGE("Error:%d setting for sess_aif params on sess_id:%d, \
+                     aif_id:%d\n", ret,
+                     sess_obj->sess_id, aif_obj->aif_id);
+       }
+       goto done;
+   }
+
    aif_obj->params = calloc(1, size);
    if (!aif_obj->params) {
        AGM_LOGE("No memory for sess_aif params on sess_id:%d, aif_id:%d\n",
@@ -1449,22 +1858,116 @@ int session_obj_set_sess_aif_params(struct session_obj *sess_obj,
    memcpy(aif_obj->params, payload, size);
    aif_obj->params_size = size;
 
-   if (sess_obj->state != SESSION_CLOSED && aif_obj->state >= AIF_OPENED) {
-       ret = graph_set_config(sess_obj->graph, aif_obj->params, aif_obj->params_size);
-       if (ret) {
-           AGM_LOGE("Error:%d setting for sess_aif params on sess_id:%d, \
-                     aif_id:%d\n", ret,
-                     sess_obj->sess_id, aif_obj->aif_id);
-       }
-       free(aif_obj->params);
-       aif_obj->params = NULL;
-       aif_obj->params_size = 0;
-   }
-
 done:
+    return ret;
+}
+
+int session_obj_set_sess_aif_params(struct session_obj *sess_obj,
+    uint32_t aif_id,
+    void* payload, size_t size)
+{
+    AGM_TRACE_SCOPE("session_obj_set_sess_aif_params");
+    int ret = 0;
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    ret = session_set_sess_aif_params(sess_obj, aif_id, payload, size);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
+}
+
+static void session_flush_params_batch(struct session_obj *sess_obj,
+                    struct agm_params_batch_entry **entries, uint32_t count,
+                    void *payload, size_t size)
+{
+    uint32_t i;
+    int ret = 0;
+
+    if (count == 0)
+        return;
+
+    ret = graph_set_config(sess_obj->graph, payload, size);
+    if (ret && count > 1) {
+        /*resend one by one to find out which entries failed*/
+        AGM_LOGE("Error:%d setting %u batched params on sess_id:%d\n",
+                 ret, count, sess_obj->sess_id);
+        for (i = 0; i < count; i++)
+            entries[i]->status = graph_set_config(sess_obj->graph,
+                                    entries[i]->payload, entries[i]->size);
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+        entries[i]->status = ret;
+}
+
+/*
+ *Entries are session or session-aif raw params of this session. Those
+ *that would be sent to the graph right away are concatenated and sent
+ *with one custom config, the others take the regular path in order.
+ */
+int session_obj_set_params_batch(struct session_obj *sess_obj,
+                                 struct agm_params_batch_entry **entries,
+                                 uint32_t num_entries)
+{
+    AGM_TRACE_SCOPE("session_obj_set_params_batch");
+    struct agm_params_batch_entry *entry = NULL;
+    struct aif *aif_obj = NULL;
+    uint8_t *payload = NULL;
+    size_t size = 0;
+    uint32_t i, first = 0, count = 0;
+    bool batch;
+    int ret = 0;
+
+    for (i = 0; i < num_entries; i++)
+        size += entries[i]->size;
+    /*without a staging buffer every entry is sent on its own*/
+    payload = malloc(size);
+    size = 0;
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    for (i = 0; i < num_entries; i++) {
+        entry = entries[i];
+        /*params are 8 byte aligned, anything else cannot be concatenated*/
+        batch = payload && entry->payload && entry->size &&
+                !(entry->size & 7) && sess_obj->state != SESSION_CLOSED;
+        if (batch && entry->type == AGM_PARAMS_BATCH_SESSION_AIF) {
+            batch = !aif_obj_get(sess_obj, entry->aif_id, &aif_obj) &&
+                    aif_obj->state >= AIF_OPENED;
+            if (batch && aif_obj->params) {
+                free(aif_obj->params);
+                aif_obj->params = NULL;
+                aif_obj->params_size = 0;
+            }
+        }
+
+        if (batch) {
+            if (count == 0)
+                first = i;
+            memcpy(payload + size, entry->payload, entry->size);
+            size += entry->size;
+            count++;
+            continue;
+        }
+
+        session_flush_params_batch(sess_obj, &entries[first], count,
+                                   payload, size);
+        count = 0;
+        size = 0;
+        if (entry->type == AGM_PARAMS_BATCH_SESSION)
+            entry->status = session_set_sess_params(sess_obj, entry->payload,
+                                                    entry->size);
+        else
+            entry->status = session_set_sess_aif_params(sess_obj,
+                                entry->aif_id, entry->payload, entry->size);
+    }
+    session_flush_params_batch(sess_obj, &entries[first], count, payload,
+                               size);
+    pthread_mutex_unlock(&sess_obj->lock);
 
+    free(payload);
+    for (i = 0; i < num_entries && !ret; i++)
+        ret = entries[i]->status;
+    return ret;
 }
 
 int session_obj_set_sess_aif_params_with_tag(struct session_obj *sess_obj,
@@ -1477,7 +1980,7 @@ int session_obj_set_sess_aif_params_with_tag(struct session_obj *sess_obj,
     struct agm_tag_config_gsl tag_config_gsl;
     size_t tkv_payload_size = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (aif_id < UINT_MAX) {
         ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
         if (ret) {
@@ -1579,7 +2082,7 @@ int session_obj_rw_acdb_params_with_tag(
     uint8_t enable_flag = 1;
     uint32_t actual_size = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = graph_enable_acdb_persistence(enable_flag);
     if (ret) {
         AGM_LOGE("Error: graph_enable_acdb_persistence failed. ret = %d\n", ret);
@@ -1666,6 +2169,17 @@ int session_dummy_rw_acdb_tunnel(
     return ret;
 }
 
+int session_dummy_set_acdb_tunnel_batch(void *payload, size_t size)
+{
+    int ret = 0;
+
+    AGM_LOGD("enter");
+    ret = graph_set_acdb_param_batch(payload, size);
+    AGM_LOGD("exit status=%d", ret);
+
+    return ret;
+}
+
 int session_obj_set_sess_aif_cal(struct session_obj *sess_obj,
     uint32_t aif_id,
     struct agm_cal_config *cal_config)
@@ -1675,7 +2189,7 @@ int session_obj_set_sess_aif_cal(struct session_obj *sess_obj,
     struct agm_meta_data_gsl *merged_metadata = NULL;
     struct agm_key_vector_gsl ckv;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (aif_id < UINT_MAX) {
         ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
         if (ret) {
@@ -1751,7 +2265,7 @@ int session_obj_set_sess_aif_metadata(struct session_obj *sess_obj,
     struct aif *aif_obj = NULL;
 
     AGM_LOGI("Setting metadata for sess aif id %d\n", aif_id);
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
     if (ret) {
         AGM_LOGE("Error obtaining aif object with sess_id:%d,  aif id:%d\n",
@@ -1777,9 +2291,10 @@ done:
 int session_obj_get_sess_params(struct session_obj *sess_obj,
         void *payload, size_t size)
 {
+    AGM_TRACE_SCOPE("session_obj_get_sess_params");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
 
     if (sess_obj->state != SESSION_CLOSED) {
         ret = graph_get_config(sess_obj->graph, payload, size);
@@ -1802,7 +2317,7 @@ int session_obj_get_tag_with_module_info(struct session_obj *sess_obj,
     struct agm_meta_data_gsl *merged_metadata = NULL;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_mode != AGM_SESSION_NON_TUNNEL) {
         if (aif_id < UINT_MAX) {
             ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
@@ -1914,7 +2429,7 @@ int session_obj_register_for_events(struct session_obj *sess_obj,
 
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
 
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Error registering for events, Session with sess_id:%d \
@@ -1939,11 +2454,12 @@ done:
 int session_obj_sess_aif_connect(struct session_obj *sess_obj,
     uint32_t aif_id, bool aif_state)
 {
+    AGM_TRACE_SCOPE("session_obj_sess_aif_connect");
     int ret = 0;
     struct aif *aif_obj = NULL;
     uint32_t opened_count = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = aif_obj_get(sess_obj, aif_id, &aif_obj);
     if (ret) {
         AGM_LOGE("Error obtaining aif object with sess_id:%d,  aif id:%d\n",
@@ -2053,28 +2569,20 @@ unwind:
     opened_count--;
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
-int session_obj_open(uint32_t session_id,
-                     enum agm_session_mode sess_mode,
-                     struct session_obj **session)
+/*called with sess_obj->lock held*/
+static int session_open(struct session_obj *sess_obj,
+                        enum agm_session_mode sess_mode)
 {
-
-    struct session_obj *sess_obj = NULL;
     int ret = 0;
     int ret_unwind = 0;
     struct listnode *node;
     struct aif *aif_obj = NULL;
 
-    ret = session_obj_get(session_id, &sess_obj);
-    if (ret) {
-        AGM_LOGE("Error getting session object\n");
-        return ret;
-    }
-
-    pthread_mutex_lock(&sess_obj->lock);
     if (sess_obj->state != SESSION_CLOSED) {
         AGM_LOGE("Session already Opened, session_state:%d\n",
                                        sess_obj->state);
@@ -2097,6 +2605,12 @@ int session_obj_open(uint32_t session_id,
             goto done;
         }
     } else {
+        /*graph kept in standby is already prepared, ready to be started*/
+        if (session_standby_reuse(sess_obj) == 0) {
+            sess_obj->state = SESSION_PREPARED;
+            goto done;
+        }
+
         /**
          *1. get first device obj from the list for the session
          *2. concatenate stream+dev metadata
@@ -2142,7 +2656,6 @@ int session_obj_open(uint32_t session_id,
     }
 
     sess_obj->state = SESSION_OPENED;
-    *session = sess_obj;
     goto done;
 
 unwind:
@@ -2165,17 +2678,61 @@ unwind:
     sess_obj->graph = NULL;
 
 done:
+    return ret;
+}
+
+int session_obj_open(uint32_t session_id,
+                     enum agm_session_mode sess_mode,
+                     struct session_obj **session)
+{
+    AGM_TRACE_SCOPE("session_obj_open");
+
+    struct session_obj *sess_obj = NULL;
+    int ret = 0;
+    uint64_t start_us = perf_now_us();
+
+    ret = session_obj_get(session_id, &sess_obj);
+    if (ret) {
+        AGM_LOGE("Error getting session object\n");
+        return ret;
+    }
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    ret = session_open(sess_obj, sess_mode);
+    if (!ret)
+        *session = sess_obj;
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_OPEN, start_us, 0, ret);
     return ret;
 }
 
-int session_obj_set_config(struct session_obj *sess_obj,
+/*called with sess_obj->lock held*/
+static int session_set_config(struct session_obj *sess_obj,
                  struct agm_session_config *stream_config,
                  struct agm_media_config *media_config,
                  struct agm_buffer_config *buffer_config)
 {
     int ret = 0;
-    pthread_mutex_lock(&sess_obj->lock);
+    bool config_changed = false;
+
+    if (sess_obj->standby_reused && sess_obj->state == SESSION_PREPARED) {
+        if (stream_config->dir == TX)
+            config_changed =
+                memcmp(&sess_obj->in_media_config, media_config,
+                       sizeof(struct agm_media_config)) ||
+                memcmp(&sess_obj->in_buffer_config, buffer_config,
+                       sizeof(struct agm_buffer_config));
+        else
+            config_changed =
+                memcmp(&sess_obj->out_media_config, media_config,
+                       sizeof(struct agm_media_config)) ||
+                memcmp(&sess_obj->out_buffer_config, buffer_config,
+                       sizeof(struct agm_buffer_config));
+        config_changed = config_changed ||
+                memcmp(&sess_obj->stream_config, stream_config,
+                       sizeof(struct agm_session_config));
+    }
 
     sess_obj->stream_config = *stream_config;
 
@@ -2200,39 +2757,210 @@ int session_obj_set_config(struct session_obj *sess_obj,
         }
     }
 
+    if (config_changed)
+        ret = session_standby_reopen(sess_obj);
+
+    return ret;
+}
+
+int session_obj_set_config(struct session_obj *sess_obj,
+                 struct agm_session_config *stream_config,
+                 struct agm_media_config *media_config,
+                 struct agm_buffer_config *buffer_config)
+{
+    AGM_TRACE_SCOPE("session_obj_set_config");
+    int ret = 0;
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    ret = session_set_config(sess_obj, stream_config, media_config,
+                             buffer_config);
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
 int session_obj_prepare(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_prepare");
     int ret = 0;
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = session_prepare(sess_obj);
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_PREPARE, start_us, 0, ret);
 
     return ret;
 }
 
 int session_obj_start(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_start");
     int ret = 0;
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = session_start(sess_obj);
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_START, start_us, 0, ret);
 
     return ret;
 }
 
+struct launch_aif_undo {
+    struct aif *aif_obj;
+    enum aif_state state;
+    struct agm_meta_data_gsl sess_aif_meta;
+};
+
+int session_obj_launch(struct session_obj *sess_obj,
+                       struct agm_session_launch_config *config)
+{
+    AGM_TRACE_SCOPE("session_obj_launch");
+    struct launch_aif_undo *undo = NULL;
+    struct agm_session_launch_aif *launch_aif = NULL;
+    struct agm_meta_data_gsl sess_meta;
+    struct aif *aif_obj = NULL;
+    uint32_t num_undo = 0;
+    bool opened = false;
+    int ret = 0;
+    uint64_t start_us = perf_now_us();
+
+    memset(&sess_meta, 0, sizeof(sess_meta));
+    if (config->num_aifs) {
+        undo = calloc(config->num_aifs, sizeof(struct launch_aif_undo));
+        if (!undo) {
+            AGM_LOGE("No memory for launch of sess_id:%d\n",
+                     sess_obj->sess_id);
+            return -ENOMEM;
+        }
+    }
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    if (sess_obj->state != SESSION_CLOSED) {
+        AGM_LOGE("Session already Opened, session_state:%d\n",
+                                       sess_obj->state);
+        ret = -EALREADY;
+        goto done;
+    }
+
+    /*stage metadata, keeping the current one until the launch succeeds*/
+    if (config->metadata_size) {
+        sess_meta = sess_obj->sess_meta;
+        memset(&sess_obj->sess_meta, 0, sizeof(sess_obj->sess_meta));
+        ret = metadata_copy(&sess_obj->sess_meta, config->metadata_size,
+                            config->metadata);
+        if (ret) {
+            AGM_LOGE("Error copying session metadata sess_id:%d\n",
+                     sess_obj->sess_id);
+            goto unwind;
+        }
+    }
+
+    for (num_undo = 0; num_undo < config->num_aifs; num_undo++) {
+        launch_aif = &config->aifs[num_undo];
+        ret = aif_obj_get(sess_obj, launch_aif->aif_id, &aif_obj);
+        if (ret) {
+            AGM_LOGE("Error obtaining aif object with sess_id:%d, aif id:%d\n",
+                     sess_obj->sess_id, launch_aif->aif_id);
+            goto unwind;
+        }
+
+        undo[num_undo].aif_obj = aif_obj;
+        undo[num_undo].state = aif_obj->state;
+        if (launch_aif->metadata_size) {
+            undo[num_undo].sess_aif_meta = aif_obj->sess_aif_meta;
+            memset(&aif_obj->sess_aif_meta, 0, sizeof(aif_obj->sess_aif_meta));
+            ret = metadata_copy(&aif_obj->sess_aif_meta,
+                                launch_aif->metadata_size,
+                                launch_aif->metadata);
+            if (ret) {
+                AGM_LOGE("Error copying session audio interface metadata "
+                         "sess_id:%d, aif_id:%d\n", sess_obj->sess_id,
+                         aif_obj->aif_id);
+                num_undo++;
+                goto unwind;
+            }
+        }
+        /*session is closed, connecting only marks the aif*/
+        if (aif_obj->state < AIF_OPEN)
+            aif_obj->state = AIF_OPEN;
+    }
+
+    ret = session_open(sess_obj, config->sess_mode);
+    if (ret) {
+        AGM_LOGE("Error:%d opening sess_id:%d\n", ret, sess_obj->sess_id);
+        goto unwind;
+    }
+    opened = true;
+
+    ret = session_set_config(sess_obj, &config->session_config,
+                             &config->media_config, &config->buffer_config);
+    if (ret) {
+        AGM_LOGE("Error:%d configuring sess_id:%d\n", ret, sess_obj->sess_id);
+        goto unwind;
+    }
+
+    ret = session_prepare(sess_obj);
+    if (ret) {
+        AGM_LOGE("Error:%d preparing sess_id:%d\n", ret, sess_obj->sess_id);
+        goto unwind;
+    }
+
+    if (config->start) {
+        ret = session_start(sess_obj);
+        if (ret) {
+            AGM_LOGE("Error:%d starting sess_id:%d\n", ret,
+                     sess_obj->sess_id);
+            goto unwind;
+        }
+    }
+
+    metadata_free(&sess_meta);
+    while (num_undo--)
+        metadata_free(&undo[num_undo].sess_aif_meta);
+    goto done;
+
+unwind:
+    if (opened)
+        session_close(sess_obj);
+
+    /*in reverse, so an aif listed twice ends up as it was before*/
+    while (num_undo--) {
+        aif_obj = undo[num_undo].aif_obj;
+        aif_obj->state = undo[num_undo].state;
+        if (config->aifs[num_undo].metadata_size) {
+            metadata_free(&aif_obj->sess_aif_meta);
+            aif_obj->sess_aif_meta = undo[num_undo].sess_aif_meta;
+        }
+    }
+
+    if (config->metadata_size) {
+        metadata_free(&sess_obj->sess_meta);
+        sess_obj->sess_meta = sess_meta;
+    }
+
+done:
+    session_publish_snapshot(sess_obj);
+    pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_LAUNCH, start_us, 0, ret);
+    free(undo);
+    return ret;
+}
+
 int session_obj_stop(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_stop");
     int ret = 0;
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = session_stop(sess_obj);
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_STOP, start_us, 0, ret);
 
     return ret;
 }
@@ -2240,20 +2968,25 @@ int session_obj_stop(struct session_obj *sess_obj)
 
 int session_obj_close(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_close");
     int ret = 0;
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     ret = session_close(sess_obj);
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_CLOSE, start_us, 0, ret);
 
     return ret;
 }
 
 int session_obj_pause(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_pause");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     /* TODO: should pause be issued in specific state,
        for now ensure its in started state */
     if (sess_obj->state != SESSION_STARTED) {
@@ -2269,18 +3002,20 @@ int session_obj_pause(struct session_obj *sess_obj)
     }
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
 int session_obj_flush(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_flush");
     int ret = 0;
     struct session_cb *sess_cb;
     struct listnode *node, *next;
     struct agm_event_cb_params *event_params = NULL;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
 
     ret = graph_flush(sess_obj->graph);
     if (ret) {
@@ -2311,6 +3046,7 @@ int session_obj_flush(struct session_obj *sess_obj)
         free(event_params);
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
@@ -2318,9 +3054,10 @@ done:
 
 int session_obj_resume(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_resume");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
 
     ret = graph_resume(sess_obj->graph);
     if (ret) {
@@ -2328,15 +3065,17 @@ int session_obj_resume(struct session_obj *sess_obj)
     }
 
 
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
 int session_obj_suspend(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_suspend");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
 
     ret = graph_suspend(sess_obj->graph);
     if (ret) {
@@ -2344,18 +3083,21 @@ int session_obj_suspend(struct session_obj *sess_obj)
     }
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
 int session_obj_read(struct session_obj *sess_obj, void *buff, size_t *count)
 {
+    AGM_TRACE_SCOPE("session_obj_read");
     int ret = 0;
     struct agm_buff buffer = {0};
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
-        AGM_LOGE("Cannot issue read in state:%d\n",
+        AGM_LOGE_DP("Cannot issue read in state:%d\n",
                            sess_obj->state);
         ret = -EINVAL;
         goto done;
@@ -2368,22 +3110,26 @@ int session_obj_read(struct session_obj *sess_obj, void *buff, size_t *count)
 
     ret = graph_read(sess_obj->graph, &buffer, count);
     if (ret) {
-        AGM_LOGE("Error:%d reading from graph\n", ret);
+        AGM_LOGE_DP("Error:%d reading from graph\n", ret);
     }
 
 done:
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_READ, start_us,
+                ret ? 0 : *count, ret);
     return ret;
 }
 
 int session_obj_write(struct session_obj *sess_obj, void *buff, size_t *count)
 {
+    AGM_TRACE_SCOPE("session_obj_write");
     int ret = 0;
     struct agm_buff buffer = {0};
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
-        AGM_LOGE("Cannot issue write in state:%d\n",
+        AGM_LOGE_DP("Cannot issue write in state:%d\n",
                             sess_obj->state);
         ret = -EINVAL;
         goto done;
@@ -2396,11 +3142,13 @@ int session_obj_write(struct session_obj *sess_obj, void *buff, size_t *count)
 
     ret = graph_write(sess_obj->graph, &buffer, count);
     if (ret) {
-        AGM_LOGE("Error:%d writing to graph\n", ret);
+        AGM_LOGE_DP("Error:%d writing to graph\n", ret);
     }
 
 done:
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_WRITE, start_us,
+                ret ? 0 : *count, ret);
     return ret;
 }
 
@@ -2409,7 +3157,7 @@ size_t session_obj_hw_processed_buff_cnt(struct session_obj *sess_obj,
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Cannot issue resume in state:%d\n",
                              sess_obj->state);
@@ -2428,9 +3176,10 @@ done:
 int session_obj_set_loopback(struct session_obj *sess_obj,
                     uint32_t playback_sess_id, bool state)
 {
+    AGM_TRACE_SCOPE("session_obj_set_loopback");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (playback_sess_id == sess_obj->loopback_sess_id &&
                             state == sess_obj->loopback_state) {
         AGM_LOGE("loopback already in %s state for session:%d\n",
@@ -2473,6 +3222,7 @@ int session_obj_set_loopback(struct session_obj *sess_obj,
     sess_obj->loopback_state = state;
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
@@ -2480,9 +3230,10 @@ done:
 int session_obj_set_ec_ref(struct session_obj *sess_obj, uint32_t aif_id,
                                         bool state)
 {
+    AGM_TRACE_SCOPE("session_obj_set_ec_ref");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (aif_id == sess_obj->ec_ref_aif_id && state == sess_obj->ec_ref_state) {
         AGM_LOGE("ec_ref already in %s state for session:%d\n",
                    ((state != false) ? "enabled":"disabled"),
@@ -2523,15 +3274,39 @@ int session_obj_set_ec_ref(struct session_obj *sess_obj, uint32_t aif_id,
     sess_obj->ec_ref_state = state;
 
 done:
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
 
+int session_obj_set_standby(struct session_obj *sess_obj, bool enable)
+{
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
+    sess_obj->standby_enabled = enable;
+    if (!enable) {
+        AGM_TRACE_MUTEX_LOCK(&hwep_lock, "lock:hwep");
+        session_standby_flush(sess_obj->sess_id);
+        pthread_mutex_unlock(&hwep_lock);
+    }
+    session_publish_snapshot(sess_obj);
+    pthread_mutex_unlock(&sess_obj->lock);
+
+    return 0;
+}
+
+int session_obj_get_perf_stats(struct session_obj *sess_obj,
+                               struct agm_perf_stats *stats)
+{
+    perf_snapshot(&sess_obj->perf, stats);
+    return 0;
+}
+
 int session_obj_eos(struct session_obj *sess_obj)
 {
+    AGM_TRACE_SCOPE("session_obj_eos");
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Cannot issue EOS in state:%d\n",
                           sess_obj->state);
@@ -2555,7 +3330,7 @@ int session_obj_get_timestamp(struct session_obj *sess_obj,
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Cannot get timestamp in state:%d\n",
                               sess_obj->state);
@@ -2576,7 +3351,7 @@ int session_obj_buffer_timestamp(struct session_obj *sess_obj, uint64_t *timesta
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state != SESSION_STARTED) {
         AGM_LOGE("Cannot get timestamp in state:%d\n", sess_obj->state);
         ret = -EINVAL;
@@ -2597,7 +3372,7 @@ int session_obj_get_sess_buf_info(struct session_obj *sess_obj, struct agm_buf_i
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Cannot get timestamp in state:%d\n", sess_obj->state);
         ret = -EINVAL;
@@ -2619,7 +3394,7 @@ int session_obj_set_gapless_metadata(struct session_obj *sess_obj,
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
         AGM_LOGE("Cannot set gapless data in state:%d\n", sess_obj->state);
         ret = -EINVAL;
@@ -2639,11 +3414,13 @@ int session_obj_write_with_metadata(struct session_obj *sess_obj,
                                     struct agm_buff *buffer,
                                     size_t *consumed_size)
 {
+    AGM_TRACE_SCOPE("session_obj_write_with_metadata");
     int ret = 0;
+    uint64_t start_us = perf_now_us();
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
-        AGM_LOGE("Cannot issue write in state:%d\n",
+        AGM_LOGE_DP("Cannot issue write in state:%d\n",
                             sess_obj->state);
         ret = -EINVAL;
         goto done;
@@ -2651,11 +3428,13 @@ int session_obj_write_with_metadata(struct session_obj *sess_obj,
 
     ret = graph_write(sess_obj->graph, buffer, consumed_size);
     if (ret) {
-        AGM_LOGE("Error:%d writing to graph\n", ret);
+        AGM_LOGE_DP("Error:%d writing to graph\n", ret);
     }
 
 done:
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_WRITE, start_us,
+                ret ? 0 : *consumed_size, ret);
     return ret;
 }
 
@@ -2663,10 +3442,13 @@ int session_obj_read_with_metadata(struct session_obj *sess_obj,
                                    struct agm_buff *buffer,
                                    uint32_t *captured_size)
 {
+    AGM_TRACE_SCOPE("session_obj_read_with_metadata");
     int ret = 0;
-    pthread_mutex_lock(&sess_obj->lock);
+    uint64_t start_us = perf_now_us();
+
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     if (sess_obj->state == SESSION_CLOSED) {
-        AGM_LOGE("Cannot issue read in state:%d\n",
+        AGM_LOGE_DP("Cannot issue read in state:%d\n",
                            sess_obj->state);
         ret = -EINVAL;
         goto done;
@@ -2675,13 +3457,15 @@ int session_obj_read_with_metadata(struct session_obj *sess_obj,
     size_t read_size;
     ret = graph_read(sess_obj->graph, buffer, &read_size);
     if (ret) {
-        AGM_LOGE("Error:%d reading from graph\n", ret);
+        AGM_LOGE_DP("Error:%d reading from graph\n", ret);
     }
 
     *captured_size = (uint32_t)read_size;
 
 done:
     pthread_mutex_unlock(&sess_obj->lock);
+    perf_record(&sess_obj->perf, AGM_PERF_OP_READ, start_us,
+                ret ? 0 : *captured_size, ret);
     return ret;
 }
 
@@ -2694,12 +3478,13 @@ int session_obj_set_non_tunnel_mode_config(struct session_obj *sess_obj,
 {
     int ret = 0;
 
-    pthread_mutex_lock(&sess_obj->lock);
+    AGM_TRACE_MUTEX_LOCK(&sess_obj->lock, "lock:sess_obj");
     sess_obj->stream_config = *session_config;
     sess_obj->in_media_config = *in_media_config;
     sess_obj->out_media_config = *out_media_config;
     sess_obj->in_buffer_config = *in_buffer_config;
     sess_obj->out_buffer_config = *out_buffer_config;
+    session_publish_snapshot(sess_obj);
     pthread_mutex_unlock(&sess_obj->lock);
     return ret;
 }
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#define LOG_TAG "AGM: trace"
+
+#ifdef AGM_TRACE_ENABLED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <agm/agm_list.h>
+#include <agm/agm_trace.h>
+#include <agm/perf.h>
+#include <agm/utils.h>
+
+#ifndef AGM_TRACE_FILE_PATH
+#define AGM_TRACE_FILE_PATH "/data/vendor/audio/agm_trace.json"
+#endif
+
+/*must be a power of two*/
+#define TRACE_RING_SIZE          4096
+#define TRACE_FLUSH_INTERVAL_MS  500
+#define TRACE_LINE_MAX           160
+
+struct trace_event {
+    uint64_t ts_us;
+    const char *name;
+    char phase;
+};
+
+/*
+ *Single producer (the owning thread), single consumer (the flusher).
+ *The owner only advances head and the flusher only advances tail, so
+ *recording an event never takes a lock. A full ring drops the event.
+ *Once the owner exits the ring is marked dead and the flusher frees it
+ *after writing out what is left.
+ */
+struct trace_ring {
+    struct listnode node;
+    pid_t tid;
+    bool dead;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    struct trace_event events[TRACE_RING_SIZE];
+};
+
+bool agm_trace_on;
+
+static __thread struct trace_ring *trace_tls_ring;
+static pthread_key_t trace_ring_key;
+static pthread_once_t trace_ring_key_once = PTHREAD_ONCE_INIT;
+static bool trace_ring_key_valid;
+static list_declare(trace_ring_list);
+static size_t trace_ring_cnt;
+static pthread_mutex_t trace_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t trace_flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t trace_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trace_thread_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t trace_thread;
+static bool trace_thread_exit;
+static int trace_fd = -1;
+static pid_t trace_pid;
+
+static void trace_ring_release(void *arg)
+{
+    struct trace_ring *ring = arg;
+
+    /*
+     *Runs on thread exit, the events still in the ring are written out
+     *by the next flush, which also frees it. Later events recorded from
+     *other key destructors go to a fresh ring.
+     */
+    trace_tls_ring = NULL;
+    __atomic_store_n(&ring->dead, true, __ATOMIC_RELEASE);
+}
+
+static void trace_ring_key_create(void)
+{
+    trace_ring_key_valid = !pthread_key_create(&trace_ring_key,
+                                               trace_ring_release);
+}
+
+static struct trace_ring *trace_ring_get(void)
+{
+    struct trace_ring *ring = trace_tls_ring;
+
+    if (ring)
+        return ring;
+
+    pthread_once(&trace_ring_key_once, trace_ring_key_create);
+    if (!trace_ring_key_valid)
+        return NULL;
+
+    /*first event on this thread*/
+    ring = calloc(1, sizeof(struct trace_ring));
+    if (!ring)
+        return NULL;
+
+    if (pthread_setspecific(trace_ring_key, ring)) {
+        free(ring);
+        return NULL;
+    }
+    ring->tid = (pid_t)syscall(SYS_gettid);
+    pthread_mutex_lock(&trace_ring_lock);
+    list_add_tail(&trace_ring_list, &ring->node);
+    trace_ring_cnt++;
+    pthread_mutex_unlock(&trace_ring_lock);
+    trace_tls_ring = ring;
+    return ring;
+}
+
+static void trace_record(const char *name, char phase)
+{
+    struct trace_ring *ring = trace_ring_get();
+    struct trace_event *event;
+    uint32_t head, tail;
+
+    if (!ring)
+        return;
+
+    head = ring->head;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TRACE_RING_SIZE) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->ts_us = perf_now_us();
+    event->name = name;
+    event->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void agm_trace_begin(const char *name)
+{
+    trace_record(name, 'B');
+}
+
+void agm_trace_end(const char *name)
+{
+    trace_record(name, 'E');
+}
+
+void agm_trace_instant(const char *name)
+{
+    trace_record(name, 'i');
+}
+
+static int trace_write(const char *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len) {
+        written = write(trace_fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        buf += written;
+        len -= written;
+    }
+    return 0;
+}
+
+static int trace_flush_ring(struct trace_ring *ring, char *buf, size_t size)
+{
+    struct trace_event *event;
+    uint32_t head, tail, dropped;
+    size_t len = 0;
+    int ret = 0;
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    tail = ring->tail;
+
+    for (; tail != head; tail++) {
+        event = &ring->events[tail & (TRACE_RING_SIZE - 1)];
+        if (size - len < TRACE_LINE_MAX) {
+            ret = trace_write(buf, len);
+            if (ret)
+                break;
+            len = 0;
+        }
+        len += snprintf(buf + len, size - len,
+                        "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64
+                        ",\"pid\":%d,\"tid\":%d%s},\n", event->name,
+                        event->phase, event->ts_us, trace_pid, ring->tid,
+                        event->phase == 'i' ? ",\"s\":\"t\"" : "");
+    }
+    if (!ret && len)
+        ret = trace_write(buf, len);
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+    dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+    if (dropped)
+        AGM_LOGE("trace ring of tid %d dropped %u events\n", ring->tid,
+                 dropped);
+    return ret;
+}
+
+int agm_trace_flush(void)
+{
+    struct trace_ring **rings = NULL;
+    struct listnode *node;
+    char *buf = NULL;
+    size_t size = TRACE_LINE_MAX * 64;
+    size_t cnt = 0, i;
+    bool dead;
+    int ret = 0;
+
+    buf = malloc(size);
+    if (!buf)
+        return -ENOMEM;
+
+    pthread_mutex_lock(&trace_flush_lock);
+    if (trace_fd < 0) {
+        ret = -EBADF;
+        goto done;
+    }
+
+    /*
+     *Rings are only freed below under trace_flush_lock, take a copy of
+     *the list so that threads registering their first event don't wait
+     *behind the file writes.
+     */
+    pthread_mutex_lock(&trace_ring_lock);
+    rings = calloc(trace_ring_cnt ? trace_ring_cnt : 1,
+                   sizeof(struct trace_ring *));
+    if (rings) {
+        list_for_each(node, &trace_ring_list)
+            rings[cnt++] = node_to_item(node, struct trace_ring, node);
+    }
+    pthread_mutex_unlock(&trace_ring_lock);
+    if (!rings) {
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        /*dead is read first, the owner records nothing after setting it*/
+        dead = __atomic_load_n(&rings[i]->dead, __ATOMIC_ACQUIRE);
+        ret = trace_flush_ring(rings[i], buf, size);
+        if (ret) {
+            AGM_LOGE("trace write failed %d\n", ret);
+            break;
+        }
+        if (!dead)
+            continue;
+
+        pthread_mutex_lock(&trace_ring_lock);
+        list_remove(&rings[i]->node);
+        trace_ring_cnt--;
+        pthread_mutex_unlock(&trace_ring_lock);
+        free(rings[i]);
+    }
+
+done:
+    pthread_mutex_unlock(&trace_flush_lock);
+    free(rings);
+    free(buf);
+    return ret;
+}
+
+static void *trace_flush_thread(void *arg __unused)
+{
+    struct timespec ts;
+
+    pthread_mutex_lock(&trace_thread_lock);
+    while (!trace_thread_exit) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += TRACE_FLUSH_INTERVAL_MS * 1000000L;
+        ts.tv_sec += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&trace_thread_cond, &trace_thread_lock, &ts);
+        if (trace_thread_exit)
+            break;
+        pthread_mutex_unlock(&trace_thread_lock);
+        agm_trace_flush();
+        pthread_mutex_lock(&trace_thread_lock);
+    }
+    pthread_mutex_unlock(&trace_thread_lock);
+    return NULL;
+}
+
+int agm_trace_init(void)
+{
+    const char *path = getenv("AGM_TRACE_FILE");
+    int ret = 0;
+
+    if (agm_trace_on)
+        return 0;
+
+    if (!path)
+        path = AGM_TRACE_FILE_PATH;
+
+    pthread_mutex_lock(&trace_flush_lock);
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (trace_fd < 0) {
+        ret = -errno;
+        pthread_mutex_unlock(&trace_flush_lock);
+        AGM_LOGE("failed to open trace file %s, err %d\n", path, ret);
+        return ret;
+    }
+    trace_pid = getpid();
+    /*the closing bracket is optional in the JSON array format*/
+    ret = trace_write("[\n", 2);
+    pthread_mutex_unlock(&trace_flush_lock);
+    if (ret)
+        goto err;
+
+    trace_thread_exit = false;
+    ret = -pthread_create(&trace_thread, NULL, trace_flush_thread, NULL);
+    if (ret) {
+        AGM_LOGE("trace flush thread creation failed %d\n", ret);
+        goto err;
+    }
+
+    __atomic_store_n(&agm_trace_on, true, __ATOMIC_RELEASE);
+    AGM_LOGI("tracing to %s\n", path);
+    return 0;
+
+err:
+    close(trace_fd);
+    trace_fd = -1;
+    return ret;
+}
+
+void agm_trace_deinit(void)
+{
+    if (!agm_trace_on)
+        return;
+
+    __atomic_store_n(&agm_trace_on, false, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&trace_thread_lock);
+    trace_thread_exit = true;
+    pthread_cond_signal(&trace_thread_cond);
+    pthread_mutex_unlock(&trace_thread_lock);
+    pthread_join(trace_thread, NULL);
+
+    agm_trace_flush();
+
+    pthread_mutex_lock(&trace_flush_lock);
+    close(trace_fd);
+    trace_fd = -1;
+    pthread_mutex_unlock(&trace_flush_lock);
+}
+
+#endif /* AGM_TRACE_ENABLED */
@@ -29,6 +29,8 @@
 #define LOG_TAG "AGM"
 
 #include<errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include <agm/utils.h>
 
@@ -114,3 +116,14 @@ char *ar_err_get_err_str(uint32_t error)
     else
         return ar_err_code_info[error].ar_err_str;
 }
+
+struct agm_log_config agm_log_cfg = AGM_LOG_CONFIG_INIT;
+
+void agm_log_config_update(void)
+{
+    agm_log_config_load(&agm_log_cfg);
+    AGM_LOGD("log level %d modules 0x%x sessions 0x%llx ratelimit %u/%u\n",
+             agm_log_cfg.level, agm_log_cfg.module_mask,
+             (unsigned long long)agm_log_cfg.session_mask,
+             agm_log_cfg.ratelimit_burst, agm_log_cfg.ratelimit_interval_ms);
+}
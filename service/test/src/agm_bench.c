@@ -0,0 +1,641 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ *Session lifecycle throughput and latency benchmark. Linked against
+ *libagm it measures AGM directly, linked against libagmclient it
+ *measures AGM through the IPC transport the client library was built
+ *for. Results are printed as a single JSON object.
+ */
+
+#include <agm/agm_api.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef AGM_BENCH_TRANSPORT
+#define AGM_BENCH_TRANSPORT "direct"
+#endif
+
+#define BENCH_MAX_SESSIONS  16
+
+enum bench_phase {
+    PHASE_OPEN,
+    PHASE_CONNECT,
+    PHASE_SET_CONFIG,
+    PHASE_PREPARE,
+    PHASE_START,
+    PHASE_STOP,
+    PHASE_DISCONNECT,
+    PHASE_CLOSE,
+    PHASE_MAX,
+};
+
+static const char *bench_phase_names[PHASE_MAX] = {
+    [PHASE_OPEN] = "open",
+    [PHASE_CONNECT] = "connect",
+    [PHASE_SET_CONFIG] = "set_config",
+    [PHASE_PREPARE] = "prepare",
+    [PHASE_START] = "start",
+    [PHASE_STOP] = "stop",
+    [PHASE_DISCONNECT] = "disconnect",
+    [PHASE_CLOSE] = "close",
+};
+
+struct bench_samples {
+    uint64_t *us;
+    uint32_t count;
+    uint32_t errors;
+};
+
+struct bench_opts {
+    uint32_t iterations;
+    uint32_t sessions;
+    uint32_t session_id;
+    uint32_t aif_id;
+    uint32_t switch_aif_id;
+    uint32_t miid;
+    const char *tests;
+    FILE *out;
+    bool printed;
+};
+
+struct bench_thread {
+    pthread_t thread;
+    pthread_barrier_t *barrier;
+    uint64_t handle;
+    uint64_t start_us;
+    uint64_t end_us;
+    int ret;
+};
+
+/*same key vectors as agm_test.c and agm_gsl_sim.conf*/
+static uint32_t stream_metadata[] = {
+    1,                                  /*number of GKVs*/
+    0xA1000000, 0xA1000001,             /*GKVs*/
+    2,                                  /*number of CKVs*/
+    0xA5000000, 48000, 0xA6000000, 16,  /*CKVs*/
+    1,                                  /*property id*/
+    2,                                  /*number of properties*/
+    1, 2,                               /*properties*/
+};
+
+static uint32_t dev_metadata[] = {
+    1,
+    0xA2000000, 0xA2000001,
+    2,
+    0xA5000000, 48000, 0xA6000000, 16,
+    1,
+    1,
+    5,
+};
+
+static struct agm_session_config bench_sess_config = {
+    .dir = RX,
+    .sess_mode = AGM_SESSION_DEFAULT,
+    .data_mode = AGM_DATA_BLOCKING,
+};
+
+static struct agm_media_config bench_media_config = {
+    .rate = 48000,
+    .channels = 2,
+    .format = AGM_FORMAT_PCM_S16_LE,
+};
+
+static struct agm_buffer_config bench_buffer_config = {
+    .count = 4,
+    .size = 3840,
+};
+
+static uint64_t bench_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int bench_samples_init(struct bench_samples *s, uint32_t n)
+{
+    s->us = calloc(n ? n : 1, sizeof(uint64_t));
+    s->count = 0;
+    s->errors = 0;
+    return s->us ? 0 : -ENOMEM;
+}
+
+static void bench_samples_free(struct bench_samples *s)
+{
+    free(s->us);
+    s->us = NULL;
+}
+
+static void bench_samples_add(struct bench_samples *s, uint64_t start_us,
+                              int ret)
+{
+    if (ret) {
+        s->errors++;
+        return;
+    }
+    s->us[s->count++] = bench_now_us() - start_us;
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_percentile(const struct bench_samples *s, uint32_t pct)
+{
+    uint32_t idx;
+
+    if (!s->count)
+        return 0;
+    idx = (uint32_t)(((uint64_t)s->count * pct + 99) / 100);
+    return s->us[idx ? idx - 1 : 0];
+}
+
+static void bench_print_samples(FILE *out, struct bench_samples *s)
+{
+    uint64_t total = 0;
+    uint32_t i;
+
+    qsort(s->us, s->count, sizeof(uint64_t), bench_cmp_u64);
+    for (i = 0; i < s->count; i++)
+        total += s->us[i];
+
+    fprintf(out, "{\"count\":%u,\"errors\":%u,\"mean_us\":%llu,"
+            "\"min_us\":%llu,\"p50_us\":%llu,\"p90_us\":%llu,"
+            "\"p99_us\":%llu,\"max_us\":%llu}", s->count, s->errors,
+            (unsigned long long)(s->count ? total / s->count : 0),
+            (unsigned long long)(s->count ? s->us[0] : 0),
+            (unsigned long long)bench_percentile(s, 50),
+            (unsigned long long)bench_percentile(s, 90),
+            (unsigned long long)bench_percentile(s, 99),
+            (unsigned long long)(s->count ? s->us[s->count - 1] : 0));
+}
+
+/*starts the results of a test, only once its setup has succeeded*/
+static void bench_print_key(struct bench_opts *opts, const char *name)
+{
+    fprintf(opts->out, "%s\"%s\":", opts->printed ? "," : "", name);
+    opts->printed = true;
+}
+
+static int bench_setup_aif(uint32_t session_id, uint32_t aif_id)
+{
+    int ret;
+
+    ret = agm_aif_set_media_config(aif_id, &bench_media_config);
+    if (ret)
+        return ret;
+    ret = agm_aif_set_metadata(aif_id, sizeof(dev_metadata),
+                               (uint8_t *)dev_metadata);
+    if (ret)
+        return ret;
+    return agm_session_aif_set_metadata(session_id, aif_id,
+                                        sizeof(dev_metadata),
+                                        (uint8_t *)dev_metadata);
+}
+
+static int bench_setup_session(uint32_t session_id, uint32_t aif_id)
+{
+    int ret;
+
+    ret = agm_session_set_metadata(session_id, sizeof(stream_metadata),
+                                   (uint8_t *)stream_metadata);
+    if (ret)
+        return ret;
+    return bench_setup_aif(session_id, aif_id);
+}
+
+/*open to prepared, the common starting point of most tests*/
+static int bench_session_bringup(uint32_t session_id, uint32_t aif_id,
+                                 uint64_t *handle)
+{
+    int ret;
+
+    ret = agm_session_open(session_id, AGM_SESSION_DEFAULT, handle);
+    if (ret)
+        return ret;
+    ret = agm_session_aif_connect(session_id, aif_id, true);
+    if (ret)
+        goto close;
+    ret = agm_session_set_config(*handle, &bench_sess_config,
+                                 &bench_media_config, &bench_buffer_config);
+    if (ret)
+        goto disconnect;
+    ret = agm_session_prepare(*handle);
+    if (ret)
+        goto disconnect;
+    return 0;
+
+disconnect:
+    agm_session_aif_connect(session_id, aif_id, false);
+close:
+    agm_session_close(*handle);
+    return ret;
+}
+
+static void bench_session_teardown(uint32_t session_id, uint32_t aif_id,
+                                   uint64_t handle)
+{
+    agm_session_aif_connect(session_id, aif_id, false);
+    agm_session_close(handle);
+}
+
+#define BENCH_STEP(phase, call) \
+    do { \
+        start_us = bench_now_us(); \
+        ret = (call); \
+        bench_samples_add(&samples[phase], start_us, ret); \
+    } while (0)
+
+static int bench_lifecycle(struct bench_opts *opts)
+{
+    struct bench_samples samples[PHASE_MAX];
+    uint64_t start_us, begin_us, elapsed_us = 0;
+    uint64_t handle = 0;
+    uint32_t i, cycles = 0;
+    int phase, ret = 0;
+
+    memset(samples, 0, sizeof(samples));
+    for (phase = 0; phase < PHASE_MAX; phase++) {
+        if (bench_samples_init(&samples[phase], opts->iterations)) {
+            ret = -ENOMEM;
+            goto done;
+        }
+    }
+
+    ret = bench_setup_session(opts->session_id, opts->aif_id);
+    if (ret) {
+        fprintf(stderr, "lifecycle setup failed %d\n", ret);
+        goto done;
+    }
+
+    begin_us = bench_now_us();
+    for (i = 0; i < opts->iterations; i++) {
+        BENCH_STEP(PHASE_OPEN, agm_session_open(opts->session_id,
+                                                AGM_SESSION_DEFAULT, &handle));
+        if (ret)
+            continue;
+        BENCH_STEP(PHASE_CONNECT, agm_session_aif_connect(opts->session_id,
+                                                          opts->aif_id, true));
+        BENCH_STEP(PHASE_SET_CONFIG, agm_session_set_config(handle,
+                   &bench_sess_config, &bench_media_config,
+                   &bench_buffer_config));
+        BENCH_STEP(PHASE_PREPARE, agm_session_prepare(handle));
+        BENCH_STEP(PHASE_START, agm_session_start(handle));
+        BENCH_STEP(PHASE_STOP, agm_session_stop(handle));
+        BENCH_STEP(PHASE_DISCONNECT, agm_session_aif_connect(opts->session_id,
+                                                             opts->aif_id,
+                                                             false));
+        BENCH_STEP(PHASE_CLOSE, agm_session_close(handle));
+        if (!ret)
+            cycles++;
+    }
+    elapsed_us = bench_now_us() - begin_us;
+    ret = 0;
+
+    bench_print_key(opts, "lifecycle");
+    fprintf(opts->out, "{\"cycles\":%u,\"cycles_per_sec\":%.2f,"
+            "\"phases\":{", cycles,
+            elapsed_us ? cycles * 1000000.0 / elapsed_us : 0.0);
+    for (phase = 0; phase < PHASE_MAX; phase++) {
+        fprintf(opts->out, "%s\"%s\":", phase ? "," : "",
+                bench_phase_names[phase]);
+        bench_print_samples(opts->out, &samples[phase]);
+    }
+    fprintf(opts->out, "}}");
+
+done:
+    for (phase = 0; phase < PHASE_MAX; phase++)
+        bench_samples_free(&samples[phase]);
+    return ret;
+}
+
+/*disconnecting the only aif of a running session and connecting another
+ *one is handled with graph_change*/
+static int bench_device_switch(struct bench_opts *opts)
+{
+    struct bench_samples samples;
+    uint32_t aifs[2] = {opts->aif_id, opts->switch_aif_id};
+    uint64_t start_us, handle = 0;
+    uint32_t i;
+    int ret;
+
+    if (bench_samples_init(&samples, opts->iterations))
+        return -ENOMEM;
+
+    ret = bench_setup_session(opts->session_id, aifs[0]);
+    if (!ret)
+        ret = bench_setup_aif(opts->session_id, aifs[1]);
+    if (!ret)
+        ret = bench_session_bringup(opts->session_id, aifs[0], &handle);
+    if (!ret)
+        ret = agm_session_start(handle);
+    if (ret) {
+        fprintf(stderr, "device switch setup failed %d\n", ret);
+        goto done;
+    }
+
+    for (i = 0; i < opts->iterations; i++) {
+        start_us = bench_now_us();
+        ret = agm_session_aif_connect(opts->session_id, aifs[i & 1], false);
+        if (!ret)
+            ret = agm_session_aif_connect(opts->session_id,
+                                          aifs[(i + 1) & 1], true);
+        bench_samples_add(&samples, start_us, ret);
+    }
+
+    agm_session_stop(handle);
+    bench_session_teardown(opts->session_id, aifs[i & 1], handle);
+    ret = 0;
+
+    bench_print_key(opts, "device_switch");
+    bench_print_samples(opts->out, &samples);
+
+done:
+    bench_samples_free(&samples);
+    return ret;
+}
+
+static int bench_params(struct bench_opts *opts)
+{
+    struct bench_samples set_samples, get_samples;
+    uint32_t payload[5];
+    uint64_t start_us, handle = 0;
+    uint32_t i;
+    int ret;
+
+    memset(&get_samples, 0, sizeof(get_samples));
+    if (bench_samples_init(&set_samples, opts->iterations) ||
+        bench_samples_init(&get_samples, opts->iterations)) {
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    ret = bench_setup_session(opts->session_id, opts->aif_id);
+    if (!ret)
+        ret = bench_session_bringup(opts->session_id, opts->aif_id, &handle);
+    if (ret) {
+        fprintf(stderr, "params setup failed %d\n", ret);
+        goto done;
+    }
+
+    for (i = 0; i < opts->iterations; i++) {
+        /*module param header: miid, param id, param size, error code*/
+        payload[0] = opts->miid;
+        payload[1] = 0x08001000;
+        payload[2] = sizeof(uint32_t);
+        payload[3] = 0;
+        payload[4] = i;
+
+        start_us = bench_now_us();
+        ret = agm_session_set_params(opts->session_id, payload,
+                                     sizeof(payload));
+        bench_samples_add(&set_samples, start_us, ret);
+
+        start_us = bench_now_us();
+        ret = agm_session_get_params(opts->session_id, payload,
+                                     sizeof(payload));
+        bench_samples_add(&get_samples, start_us, ret);
+    }
+
+    bench_session_teardown(opts->session_id, opts->aif_id, handle);
+    ret = 0;
+
+    bench_print_key(opts, "set_params");
+    bench_print_samples(opts->out, &set_samples);
+    bench_print_key(opts, "get_params");
+    bench_print_samples(opts->out, &get_samples);
+
+done:
+    bench_samples_free(&set_samples);
+    bench_samples_free(&get_samples);
+    return ret;
+}
+
+static void *bench_start_thread(void *arg)
+{
+    struct bench_thread *t = arg;
+
+    pthread_barrier_wait(t->barrier);
+    t->start_us = bench_now_us();
+    t->ret = agm_session_start(t->handle);
+    t->end_us = bench_now_us();
+    return NULL;
+}
+
+static int bench_concurrent_start(struct bench_opts *opts)
+{
+    struct bench_thread threads[BENCH_MAX_SESSIONS];
+    struct bench_samples per_session, all;
+    pthread_barrier_t barrier;
+    uint64_t first_us, last_us;
+    uint32_t n = opts->sessions, i, s;
+    int ret = 0;
+
+    memset(&all, 0, sizeof(all));
+    if (bench_samples_init(&per_session, opts->iterations * n) ||
+        bench_samples_init(&all, opts->iterations)) {
+        ret = -ENOMEM;
+        goto done;
+    }
+
+    memset(threads, 0, sizeof(threads));
+    for (s = 0; s < n; s++) {
+        ret = bench_setup_session(opts->session_id + s, opts->aif_id);
+        if (!ret)
+            ret = bench_session_bringup(opts->session_id + s, opts->aif_id,
+                                        &threads[s].handle);
+        if (ret) {
+            fprintf(stderr, "session %u setup failed %d\n",
+                    opts->session_id + s, ret);
+            n = s;
+            goto teardown;
+        }
+    }
+
+    pthread_barrier_init(&barrier, NULL, n);
+    for (i = 0; i < opts->iterations; i++) {
+        for (s = 0; s < n; s++) {
+            threads[s].barrier = &barrier;
+            pthread_create(&threads[s].thread, NULL, bench_start_thread,
+                           &threads[s]);
+        }
+
+        first_us = UINT64_MAX;
+        last_us = 0;
+        ret = 0;
+        for (s = 0; s < n; s++) {
+            pthread_join(threads[s].thread, NULL);
+            if (threads[s].ret) {
+                per_session.errors++;
+                ret = threads[s].ret;
+                continue;
+            }
+            per_session.us[per_session.count++] =
+                threads[s].end_us - threads[s].start_us;
+            if (threads[s].start_us < first_us)
+                first_us = threads[s].start_us;
+            if (threads[s].end_us > last_us)
+                last_us = threads[s].end_us;
+        }
+        if (ret)
+            all.errors++;
+        else
+            all.us[all.count++] = last_us - first_us;
+
+        for (s = 0; s < n; s++)
+            agm_session_stop(threads[s].handle);
+    }
+    pthread_barrier_destroy(&barrier);
+    ret = 0;
+
+teardown:
+    for (s = 0; s < n; s++)
+        bench_session_teardown(opts->session_id + s, opts->aif_id,
+                               threads[s].handle);
+    if (ret)
+        goto done;
+
+    bench_print_key(opts, "concurrent_start");
+    fprintf(opts->out, "{\"sessions\":%u,\"all\":", n);
+    bench_print_samples(opts->out, &all);
+    fprintf(opts->out, ",\"per_session\":");
+    bench_print_samples(opts->out, &per_session);
+    fprintf(opts->out, "}");
+
+done:
+    bench_samples_free(&per_session);
+    bench_samples_free(&all);
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -n <iterations>     iterations per test (default 100)\n"
+           "  -s <session id>     first session id (default 1)\n"
+           "  -a <aif id>         audio interface (default 0)\n"
+           "  -b <aif id>         second audio interface for device switch"
+           " (default 1)\n"
+           "  -c <sessions>       sessions started concurrently (default 4)\n"
+           "  -m <miid>           module instance for set/get params"
+           " (default 0x4001)\n"
+           "  -t <tests>          comma separated subset of lifecycle,"
+           "switch,params,concurrent\n"
+           "  -o <file>           write the JSON results to file\n",
+           prog);
+}
+
+static bool bench_selected(const char *tests, const char *name)
+{
+    const char *p = tests;
+    size_t len = strlen(name);
+
+    if (!tests)
+        return true;
+    while ((p = strstr(p, name)) != NULL) {
+        if ((p == tests || p[-1] == ',') && (p[len] == ',' || !p[len]))
+            return true;
+        p += len;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts opts = {
+        .iterations = 100,
+        .sessions = 4,
+        .session_id = 1,
+        .aif_id = 0,
+        .switch_aif_id = 1,
+        .miid = 0x4001,
+        .tests = NULL,
+        .out = stdout,
+    };
+    int opt, ret = 0, test_ret;
+
+    while ((opt = getopt(argc, argv, "n:s:a:b:c:m:t:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            opts.iterations = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            opts.session_id = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            opts.aif_id = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            opts.switch_aif_id = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            opts.sessions = strtoul(optarg, NULL, 0);
+            if (!opts.sessions || opts.sessions > BENCH_MAX_SESSIONS) {
+                fprintf(stderr, "sessions must be 1..%d\n", BENCH_MAX_SESSIONS);
+                return 1;
+            }
+            break;
+        case 'm':
+            opts.miid = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            opts.tests = optarg;
+            break;
+        case 'o':
+            opts.out = fopen(optarg, "w");
+            if (!opts.out) {
+                fprintf(stderr, "cannot open %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    ret = agm_init();
+    if (ret) {
+        fprintf(stderr, "agm_init failed %d\n", ret);
+        return 1;
+    }
+
+    fprintf(opts.out, "{\"benchmark\":\"agm_bench\",\"transport\":\"%s\","
+            "\"iterations\":%u,\"results\":{", AGM_BENCH_TRANSPORT,
+            opts.iterations);
+
+#define BENCH_RUN(name, fn) \
+    do { \
+        if (bench_selected(opts.tests, name)) { \
+            test_ret = fn(&opts); \
+            if (test_ret) \
+                ret = test_ret; \
+        } \
+    } while (0)
+
+    BENCH_RUN("lifecycle", bench_lifecycle);
+    BENCH_RUN("switch", bench_device_switch);
+    BENCH_RUN("params", bench_params);
+    BENCH_RUN("concurrent", bench_concurrent_start);
+
+    fprintf(opts.out, "}}\n");
+    if (opts.out != stdout)
+        fclose(opts.out);
+
+    agm_deinit();
+    return ret ? 1 : 0;
+}
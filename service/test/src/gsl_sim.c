@@ -0,0 +1,821 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ *Simulated GSL backend. Implements the gsl_intf.h entry points used by
+ *AGM without ACDB files or a DSP, so that AGM and the plugins can run
+ *on a host and their own overhead can be measured.
+ *
+ *Graphs and latencies come from the file named by AGM_GSL_SIM_CONFIG
+ *(default GSL_SIM_CONFIG_PATH), see agm_gsl_sim.conf for the format. A
+ *graph opened with a GKV contains the modules of every subgraph whose
+ *key values are all present in that GKV.
+ */
+#define LOG_TAG "AGM: gsl_sim"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <agm/agm_api.h>
+#include <agm/agm_list.h>
+#include <agm/utils.h>
+#include "gsl_intf.h"
+
+#ifndef GSL_SIM_CONFIG_PATH
+#define GSL_SIM_CONFIG_PATH "/etc/agm_gsl_sim.conf"
+#endif
+
+#define SIM_MAX_KVS      16
+#define SIM_MAX_MODULES  64
+#define SIM_LINE_MAX     512
+
+enum sim_op {
+    SIM_OP_OPEN,
+    SIM_OP_CLOSE,
+    SIM_OP_PREPARE,
+    SIM_OP_START,
+    SIM_OP_STOP,
+    SIM_OP_IOCTL,
+    SIM_OP_SET_CONFIG,
+    SIM_OP_SET_CUSTOM_CONFIG,
+    SIM_OP_GET_CUSTOM_CONFIG,
+    SIM_OP_GET_MODULE_INFO,
+    SIM_OP_READ,
+    SIM_OP_WRITE,
+    SIM_OP_EVENT,
+    SIM_OP_MAX,
+};
+
+static const char *sim_op_names[SIM_OP_MAX] = {
+    [SIM_OP_OPEN] = "open",
+    [SIM_OP_CLOSE] = "close",
+    [SIM_OP_PREPARE] = "prepare",
+    [SIM_OP_START] = "start",
+    [SIM_OP_STOP] = "stop",
+    [SIM_OP_IOCTL] = "ioctl",
+    [SIM_OP_SET_CONFIG] = "set_config",
+    [SIM_OP_SET_CUSTOM_CONFIG] = "set_custom_config",
+    [SIM_OP_GET_CUSTOM_CONFIG] = "get_custom_config",
+    [SIM_OP_GET_MODULE_INFO] = "get_module_info",
+    [SIM_OP_READ] = "read",
+    [SIM_OP_WRITE] = "write",
+    [SIM_OP_EVENT] = "event",
+};
+
+struct sim_latency {
+    uint32_t us;
+    uint32_t jitter_us;
+};
+
+struct sim_module {
+    uint32_t tag;
+    uint32_t mid;
+    uint32_t miid;
+};
+
+/*ACDB subgraph, selected by a subset of the graph key vector*/
+struct sim_subgraph {
+    struct listnode node;
+    size_t num_kvs;
+    struct gsl_key_value_pair kvs[SIM_MAX_KVS];
+    size_t num_modules;
+    struct sim_module modules[SIM_MAX_MODULES];
+    /*per module lookup results, owned by the simulator as in GSL*/
+    struct gsl_module_id_info *module_info[SIM_MAX_MODULES];
+};
+
+struct sim_graph {
+    pthread_mutex_t lock;
+    gsl_cb_func_ptr cb;
+    void *client_data;
+    size_t num_modules;
+    struct sim_module modules[SIM_MAX_MODULES];
+};
+
+struct sim_event {
+    struct listnode node;
+    uint64_t due_us;
+    struct sim_graph *graph;
+    struct gsl_event_cb_params params;
+    struct agm_event_read_write_done_payload payload;
+};
+
+static struct sim_latency sim_latency[SIM_OP_MAX];
+static list_declare(sim_subgraph_list);
+
+static pthread_mutex_t sim_event_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_event_cond = PTHREAD_COND_INITIALIZER;
+static list_declare(sim_event_list);
+static pthread_t sim_event_thread;
+static struct sim_graph *sim_dispatching;
+static bool sim_event_thread_exit;
+static bool sim_initialized;
+
+static uint64_t sim_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t sim_latency_us(enum sim_op op)
+{
+    struct sim_latency *lat = &sim_latency[op];
+
+    if (!lat->jitter_us)
+        return lat->us;
+    return lat->us + (uint32_t)(rand() % (lat->jitter_us + 1));
+}
+
+static void sim_delay(enum sim_op op)
+{
+    uint32_t us = sim_latency_us(op);
+
+    if (us)
+        usleep(us);
+}
+
+static bool sim_kv_present(const struct gsl_key_vector *gkv,
+                           const struct gsl_key_value_pair *kv)
+{
+    size_t i;
+
+    for (i = 0; i < gkv->num_kvps; i++) {
+        if (gkv->kvp[i].key == kv->key && gkv->kvp[i].value == kv->value)
+            return true;
+    }
+    return false;
+}
+
+static bool sim_subgraph_match(const struct sim_subgraph *sg,
+                               const struct gsl_key_vector *gkv)
+{
+    size_t i;
+
+    if (!gkv || !gkv->num_kvps)
+        return false;
+
+    for (i = 0; i < sg->num_kvs; i++) {
+        if (!sim_kv_present(gkv, &sg->kvs[i]))
+            return false;
+    }
+    return true;
+}
+
+/*collect the modules of all matching subgraphs, without duplicates*/
+static size_t sim_get_modules(const struct gsl_key_vector *gkv,
+                              struct sim_module *modules)
+{
+    struct sim_subgraph *sg;
+    struct listnode *node;
+    size_t num = 0, i, j;
+
+    list_for_each(node, &sim_subgraph_list) {
+        sg = node_to_item(node, struct sim_subgraph, node);
+        if (!sim_subgraph_match(sg, gkv))
+            continue;
+        for (i = 0; i < sg->num_modules && num < SIM_MAX_MODULES; i++) {
+            for (j = 0; j < num; j++) {
+                if (modules[j].miid == sg->modules[i].miid)
+                    break;
+            }
+            if (j == num)
+                modules[num++] = sg->modules[i];
+        }
+    }
+    return num;
+}
+
+static int sim_parse_u32(const char *str, uint32_t *val)
+{
+    char *end = NULL;
+    unsigned long v;
+
+    errno = 0;
+    v = strtoul(str, &end, 0);
+    if (errno || end == str || (*end && *end != '='))
+        return -EINVAL;
+    *val = (uint32_t)v;
+    return 0;
+}
+
+static int sim_parse_latency(char *args)
+{
+    char *name, *us, *jitter, *save = NULL;
+    uint32_t val;
+    int op;
+
+    name = strtok_r(args, " \t", &save);
+    us = strtok_r(NULL, " \t", &save);
+    jitter = strtok_r(NULL, " \t", &save);
+    if (!name || !us)
+        return -EINVAL;
+
+    for (op = 0; op < SIM_OP_MAX; op++) {
+        if (!strcmp(name, sim_op_names[op]))
+            break;
+    }
+    if (op == SIM_OP_MAX)
+        return -EINVAL;
+
+    if (sim_parse_u32(us, &val))
+        return -EINVAL;
+    sim_latency[op].us = val;
+    if (jitter) {
+        if (sim_parse_u32(jitter, &val))
+            return -EINVAL;
+        sim_latency[op].jitter_us = val;
+    }
+    return 0;
+}
+
+static int sim_parse_graph(char *args, struct sim_subgraph **sg)
+{
+    char *kv, *value, *save = NULL;
+    struct sim_subgraph *new_sg;
+
+    new_sg = calloc(1, sizeof(struct sim_subgraph));
+    if (!new_sg)
+        return -ENOMEM;
+
+    for (kv = strtok_r(args, " \t", &save); kv != NULL;
+         kv = strtok_r(NULL, " \t", &save)) {
+        value = strchr(kv, '=');
+        if (!value || new_sg->num_kvs == SIM_MAX_KVS ||
+            sim_parse_u32(kv, &new_sg->kvs[new_sg->num_kvs].key) ||
+            sim_parse_u32(value + 1, &new_sg->kvs[new_sg->num_kvs].value)) {
+            free(new_sg);
+            return -EINVAL;
+        }
+        new_sg->num_kvs++;
+    }
+
+    if (!new_sg->num_kvs) {
+        free(new_sg);
+        return -EINVAL;
+    }
+    list_add_tail(&sim_subgraph_list, &new_sg->node);
+    *sg = new_sg;
+    return 0;
+}
+
+static int sim_parse_module(char *args, struct sim_subgraph *sg)
+{
+    char *tag, *mid, *miid, *save = NULL;
+    struct sim_module *mod;
+
+    if (!sg || sg->num_modules == SIM_MAX_MODULES)
+        return -EINVAL;
+
+    tag = strtok_r(args, " \t", &save);
+    mid = strtok_r(NULL, " \t", &save);
+    miid = strtok_r(NULL, " \t", &save);
+    if (!tag || !mid || !miid)
+        return -EINVAL;
+
+    mod = &sg->modules[sg->num_modules];
+    if (sim_parse_u32(tag, &mod->tag) || sim_parse_u32(mid, &mod->mid) ||
+        sim_parse_u32(miid, &mod->miid))
+        return -EINVAL;
+    sg->num_modules++;
+    return 0;
+}
+
+static int sim_load_config(const char *path)
+{
+    struct sim_subgraph *sg = NULL;
+    char line[SIM_LINE_MAX];
+    char *cmd, *args;
+    int line_no = 0;
+    int ret = 0;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        AGM_LOGI("no config %s, running with an empty graph table\n", path);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        cmd = line + strspn(line, " \t");
+        if (!*cmd)
+            continue;
+        args = cmd + strcspn(cmd, " \t");
+        if (*args)
+            *args++ = '\0';
+
+        if (!strcmp(cmd, "latency"))
+            ret = sim_parse_latency(args);
+        else if (!strcmp(cmd, "graph"))
+            ret = sim_parse_graph(args, &sg);
+        else if (!strcmp(cmd, "module"))
+            ret = sim_parse_module(args, sg);
+        else
+            ret = -EINVAL;
+
+        if (ret) {
+            AGM_LOGE("%s:%d: invalid line\n", path, line_no);
+            break;
+        }
+    }
+    fclose(fp);
+    return ret;
+}
+
+static void sim_free_config(void)
+{
+    struct sim_subgraph *sg;
+    struct listnode *node, *next;
+    size_t i;
+
+    list_for_each_safe(node, next, &sim_subgraph_list) {
+        sg = node_to_item(node, struct sim_subgraph, node);
+        list_remove(node);
+        for (i = 0; i < sg->num_modules; i++)
+            free(sg->module_info[i]);
+        free(sg);
+    }
+    memset(sim_latency, 0, sizeof(sim_latency));
+}
+
+static void *sim_event_thread_loop(void *arg __unused)
+{
+    struct sim_event *event;
+    struct timespec ts;
+    uint64_t now_us, wait_us;
+    gsl_cb_func_ptr cb;
+    void *client_data;
+
+    pthread_mutex_lock(&sim_event_lock);
+    while (!sim_event_thread_exit) {
+        if (list_empty(&sim_event_list)) {
+            pthread_cond_wait(&sim_event_cond, &sim_event_lock);
+            continue;
+        }
+
+        event = node_to_item(list_head(&sim_event_list), struct sim_event,
+                             node);
+        now_us = sim_now_us();
+        if (event->due_us > now_us) {
+            wait_us = event->due_us - now_us;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += wait_us / 1000000;
+            ts.tv_nsec += (wait_us % 1000000) * 1000;
+            ts.tv_sec += ts.tv_nsec / 1000000000L;
+            ts.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&sim_event_cond, &sim_event_lock, &ts);
+            continue;
+        }
+
+        list_remove(&event->node);
+        pthread_mutex_lock(&event->graph->lock);
+        cb = event->graph->cb;
+        client_data = event->graph->client_data;
+        pthread_mutex_unlock(&event->graph->lock);
+
+        /*gsl_close waits for the graph to stop being dispatched*/
+        sim_dispatching = event->graph;
+        pthread_mutex_unlock(&sim_event_lock);
+        if (cb)
+            cb(&event->params, client_data);
+        free(event);
+        pthread_mutex_lock(&sim_event_lock);
+        sim_dispatching = NULL;
+        pthread_cond_broadcast(&sim_event_cond);
+    }
+    pthread_mutex_unlock(&sim_event_lock);
+    return NULL;
+}
+
+static void sim_post_event(struct sim_graph *graph, uint32_t event_id,
+                           uint32_t tag, const struct gsl_buff *buff)
+{
+    struct sim_event *event, *temp;
+    struct listnode *node;
+
+    event = calloc(1, sizeof(struct sim_event));
+    if (!event)
+        return;
+
+    event->graph = graph;
+    event->due_us = sim_now_us() + sim_latency_us(SIM_OP_EVENT);
+    event->params.source_module_id = GSL_EVENT_SRC_MODULE_ID_GSL;
+    event->params.event_id = event_id;
+    if (buff) {
+        event->payload.tag = tag;
+        event->payload.buff.timestamp = buff->timestamp;
+        event->payload.buff.flags = buff->flags;
+        event->payload.buff.size = buff->size;
+        event->payload.buff.addr = buff->addr;
+        event->params.event_payload_size = sizeof(event->payload);
+        event->params.event_payload = (void *)&event->payload;
+    }
+
+    /*keep the queue ordered by due time*/
+    pthread_mutex_lock(&sim_event_lock);
+    list_for_each(node, &sim_event_list) {
+        temp = node_to_item(node, struct sim_event, node);
+        if (temp->due_us > event->due_us)
+            break;
+    }
+    list_add_tail(node, &event->node);
+    pthread_cond_broadcast(&sim_event_cond);
+    pthread_mutex_unlock(&sim_event_lock);
+}
+
+static void sim_flush_events(struct sim_graph *graph)
+{
+    struct sim_event *event;
+    struct listnode *node, *next;
+
+    pthread_mutex_lock(&sim_event_lock);
+    list_for_each_safe(node, next, &sim_event_list) {
+        event = node_to_item(node, struct sim_event, node);
+        if (event->graph == graph) {
+            list_remove(node);
+            free(event);
+        }
+    }
+    while (sim_dispatching == graph)
+        pthread_cond_wait(&sim_event_cond, &sim_event_lock);
+    pthread_mutex_unlock(&sim_event_lock);
+}
+
+int32_t gsl_init(struct gsl_init_data *init_data __unused)
+{
+    const char *path = getenv("AGM_GSL_SIM_CONFIG");
+    int ret = 0;
+
+    if (sim_initialized)
+        return AR_EOK;
+
+    if (!path)
+        path = GSL_SIM_CONFIG_PATH;
+
+    ret = sim_load_config(path);
+    if (ret) {
+        sim_free_config();
+        return AR_EBADPARAM;
+    }
+
+    sim_event_thread_exit = false;
+    ret = pthread_create(&sim_event_thread, NULL, sim_event_thread_loop, NULL);
+    if (ret) {
+        AGM_LOGE("event thread creation failed %d\n", ret);
+        sim_free_config();
+        return AR_ENORESOURCE;
+    }
+
+    sim_initialized = true;
+    return AR_EOK;
+}
+
+void gsl_deinit(void)
+{
+    struct listnode *node, *next;
+
+    if (!sim_initialized)
+        return;
+
+    pthread_mutex_lock(&sim_event_lock);
+    sim_event_thread_exit = true;
+    pthread_cond_broadcast(&sim_event_cond);
+    pthread_mutex_unlock(&sim_event_lock);
+    pthread_join(sim_event_thread, NULL);
+
+    list_for_each_safe(node, next, &sim_event_list) {
+        list_remove(node);
+        free(node_to_item(node, struct sim_event, node));
+    }
+    sim_free_config();
+    sim_initialized = false;
+}
+
+int32_t gsl_open(const struct gsl_key_vector *graph_key_vect,
+                 const struct gsl_key_vector *cal_key_vect __unused,
+                 gsl_handle_t *graph_handle)
+{
+    struct sim_graph *graph;
+
+    if (!graph_key_vect || !graph_handle)
+        return AR_EBADPARAM;
+
+    graph = calloc(1, sizeof(struct sim_graph));
+    if (!graph)
+        return AR_ENOMEMORY;
+
+    pthread_mutex_init(&graph->lock, (const pthread_mutexattr_t *) NULL);
+    graph->num_modules = sim_get_modules(graph_key_vect, graph->modules);
+    sim_delay(SIM_OP_OPEN);
+    *graph_handle = graph;
+    return AR_EOK;
+}
+
+int32_t gsl_close(gsl_handle_t graph_handle)
+{
+    struct sim_graph *graph = graph_handle;
+
+    if (!graph)
+        return AR_EBADPARAM;
+
+    sim_flush_events(graph);
+    sim_delay(SIM_OP_CLOSE);
+    pthread_mutex_destroy(&graph->lock);
+    free(graph);
+    return AR_EOK;
+}
+
+int32_t gsl_register_event_cb(gsl_handle_t graph_handle, gsl_cb_func_ptr cb,
+                              void *client_data)
+{
+    struct sim_graph *graph = graph_handle;
+
+    if (!graph)
+        return AR_EBADPARAM;
+
+    pthread_mutex_lock(&graph->lock);
+    graph->cb = cb;
+    graph->client_data = client_data;
+    pthread_mutex_unlock(&graph->lock);
+    return AR_EOK;
+}
+
+int32_t gsl_ioctl(gsl_handle_t graph_handle, enum gsl_cmd_id cmd_id,
+                  void *cmd_payload, size_t cmd_payload_sz __unused)
+{
+    struct sim_graph *graph = graph_handle;
+    struct gsl_cmd_graph_select *graph_select;
+    struct sim_module modules[SIM_MAX_MODULES];
+    size_t num_modules;
+
+    if (!graph)
+        return AR_EBADPARAM;
+
+    switch (cmd_id) {
+    case GSL_CMD_PREPARE:
+        sim_delay(SIM_OP_PREPARE);
+        break;
+    case GSL_CMD_START:
+        sim_delay(SIM_OP_START);
+        break;
+    case GSL_CMD_STOP:
+        sim_delay(SIM_OP_STOP);
+        break;
+    case GSL_CMD_ADD_GRAPH:
+    case GSL_CMD_CHANGE_GRAPH:
+        if (!cmd_payload)
+            return AR_EBADPARAM;
+        graph_select = cmd_payload;
+        num_modules = sim_get_modules(&graph_select->graph_key_vector,
+                                      modules);
+        pthread_mutex_lock(&graph->lock);
+        graph->num_modules = num_modules;
+        memcpy(graph->modules, modules, num_modules * sizeof(modules[0]));
+        pthread_mutex_unlock(&graph->lock);
+        sim_delay(SIM_OP_IOCTL);
+        break;
+    case GSL_CMD_EOS:
+        sim_delay(SIM_OP_IOCTL);
+        sim_post_event(graph, AGM_EVENT_EOS_RENDERED, 0, NULL);
+        break;
+    default:
+        sim_delay(SIM_OP_IOCTL);
+        break;
+    }
+    return AR_EOK;
+}
+
+int32_t gsl_set_cal(gsl_handle_t graph_handle,
+                    const struct gsl_key_vector *graph_key_vect __unused,
+                    const struct gsl_key_vector *cal_key_vect __unused)
+{
+    if (!graph_handle)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_SET_CONFIG);
+    return AR_EOK;
+}
+
+int32_t gsl_set_config(gsl_handle_t graph_handle,
+                       const struct gsl_key_vector *graph_key_vect __unused,
+                       uint32_t tag __unused,
+                       const struct gsl_key_vector *tag_key_vect __unused)
+{
+    if (!graph_handle)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_SET_CONFIG);
+    return AR_EOK;
+}
+
+int32_t gsl_set_custom_config(gsl_handle_t graph_handle,
+                              const uint8_t *payload,
+                              const uint32_t payload_size __unused)
+{
+    if (!graph_handle || !payload)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_SET_CUSTOM_CONFIG);
+    return AR_EOK;
+}
+
+int32_t gsl_get_custom_config(gsl_handle_t graph_handle, uint8_t *payload,
+                              uint32_t payload_size __unused)
+{
+    if (!graph_handle || !payload)
+        return AR_EBADPARAM;
+
+    /*parameters are returned as sent, the DSP would fill them in*/
+    sim_delay(SIM_OP_GET_CUSTOM_CONFIG);
+    return AR_EOK;
+}
+
+int32_t gsl_get_tags_with_module_info(const struct gsl_key_vector *graph_key_vect,
+                                      void *tag_module_info,
+                                      size_t *tag_module_info_size)
+{
+    struct sim_module modules[SIM_MAX_MODULES];
+    struct gsl_tag_module_info *info = tag_module_info;
+    struct gsl_tag_module_info_entry *entry;
+    bool done[SIM_MAX_MODULES] = {false};
+    size_t num_modules, required, i, j;
+    uint32_t num_tags = 0;
+
+    if (!graph_key_vect || !tag_module_info_size)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_GET_MODULE_INFO);
+    num_modules = sim_get_modules(graph_key_vect, modules);
+
+    required = sizeof(struct gsl_tag_module_info) +
+               num_modules * sizeof(struct gsl_module_id_info_entry);
+    for (i = 0; i < num_modules; i++) {
+        for (j = 0; j < i; j++) {
+            if (modules[j].tag == modules[i].tag)
+                break;
+        }
+        if (j == i)
+            required += sizeof(struct gsl_tag_module_info_entry);
+    }
+
+    if (!info || *tag_module_info_size < required) {
+        *tag_module_info_size = required;
+        return info ? AR_ENEEDMORE : AR_EOK;
+    }
+
+    /*one entry per tag, followed by the modules carrying that tag*/
+    entry = (struct gsl_tag_module_info_entry *)info->tag_module_entry;
+    for (i = 0; i < num_modules; i++) {
+        if (done[i])
+            continue;
+        entry->tag_id = modules[i].tag;
+        entry->num_modules = 0;
+        for (j = i; j < num_modules; j++) {
+            if (modules[j].tag != modules[i].tag)
+                continue;
+            entry->module_entry[entry->num_modules].module_id = modules[j].mid;
+            entry->module_entry[entry->num_modules].module_iid = modules[j].miid;
+            entry->num_modules++;
+            done[j] = true;
+        }
+        entry = (struct gsl_tag_module_info_entry *)((uint8_t *)entry +
+                 sizeof(struct gsl_tag_module_info_entry) +
+                 entry->num_modules * sizeof(struct gsl_module_id_info_entry));
+        num_tags++;
+    }
+    info->num_tags = num_tags;
+    *tag_module_info_size = required;
+    return AR_EOK;
+}
+
+int32_t gsl_get_tagged_module_info(const struct gsl_key_vector *graph_key_vect,
+                                   uint32_t tag,
+                                   struct gsl_module_id_info **module_info,
+                                   uint32_t *module_info_size)
+{
+    struct sim_subgraph *sg;
+    struct gsl_module_id_info *info;
+    struct listnode *node;
+    size_t i, size;
+
+    if (!graph_key_vect || !module_info || !module_info_size)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_GET_MODULE_INFO);
+    list_for_each(node, &sim_subgraph_list) {
+        sg = node_to_item(node, struct sim_subgraph, node);
+        if (!sim_subgraph_match(sg, graph_key_vect))
+            continue;
+        for (i = 0; i < sg->num_modules; i++) {
+            if (sg->modules[i].tag != tag)
+                continue;
+
+            /*built on first lookup, freed in gsl_deinit*/
+            info = sg->module_info[i];
+            size = sizeof(struct gsl_module_id_info) +
+                   sizeof(struct gsl_module_id_info_entry);
+            if (!info) {
+                info = calloc(1, size);
+                if (!info)
+                    return AR_ENOMEMORY;
+                info->num_modules = 1;
+                info->module_entry[0].module_id = sg->modules[i].mid;
+                info->module_entry[0].module_iid = sg->modules[i].miid;
+                sg->module_info[i] = info;
+            }
+            *module_info = info;
+            *module_info_size = (uint32_t)size;
+            return AR_EOK;
+        }
+    }
+    return AR_ENOTEXIST;
+}
+
+int32_t gsl_get_graph_alias(const struct gsl_key_vector *graph_key_vect,
+                            char *alias, uint32_t *alias_len)
+{
+    if (!graph_key_vect || !alias || !alias_len || !*alias_len)
+        return AR_EBADPARAM;
+
+    snprintf(alias, *alias_len, "GSL_SIM_%zu_KVS", graph_key_vect->num_kvps);
+    return AR_EOK;
+}
+
+int32_t gsl_write(gsl_handle_t graph_handle, uint32_t tag,
+                  struct gsl_buff *buff, uint32_t *consumed_size)
+{
+    struct sim_graph *graph = graph_handle;
+
+    if (!graph || !buff || !consumed_size)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_WRITE);
+    *consumed_size = buff->size;
+    sim_post_event(graph, AGM_EVENT_WRITE_DONE, tag, buff);
+    return AR_EOK;
+}
+
+int32_t gsl_read(gsl_handle_t graph_handle, uint32_t tag,
+                 struct gsl_buff *buff, uint32_t *filled_size)
+{
+    struct sim_graph *graph = graph_handle;
+
+    if (!graph || !buff || !filled_size)
+        return AR_EBADPARAM;
+
+    sim_delay(SIM_OP_READ);
+    if (buff->addr)
+        memset(buff->addr, 0, buff->size);
+    *filled_size = buff->size;
+    sim_post_event(graph, AGM_EVENT_READ_DONE, tag, buff);
+    return AR_EOK;
+}
+
+int32_t gsl_get_processed_buff_cnt(gsl_handle_t graph_handle __unused,
+                                   enum gsl_data_dir dir __unused)
+{
+    return 2;
+}
+
+int32_t gsl_get_tagged_data(struct gsl_key_vector *key_vect __unused,
+                            uint32_t tag __unused,
+                            struct gsl_key_vector *tag_key_vect __unused,
+                            uint8_t *payload __unused,
+                            size_t *payload_size __unused)
+{
+    /*no calibration database, parameters are returned as sent*/
+    return AR_EOK;
+}
+
+int32_t gsl_set_tag_data_to_acdb(struct gsl_key_vector *key_vect __unused,
+                                 uint32_t tag __unused,
+                                 struct gsl_key_vector *tag_key_vect __unused,
+                                 uint8_t *payload __unused,
+                                 size_t payload_size __unused)
+{
+    return AR_EOK;
+}
+
+int32_t gsl_set_cal_data_to_acdb(struct gsl_key_vector *key_vect __unused,
+                                 struct gsl_key_vector *cal_key_vect __unused,
+                                 uint8_t *payload __unused,
+                                 size_t payload_size __unused)
+{
+    return AR_EOK;
+}
+
+int32_t gsl_enable_acdb_persistence(uint8_t enable_flag __unused)
+{
+    return AR_EOK;
+}